@@ -28,7 +28,6 @@
 #include <renderer/functions.h>
 #include <rtc/rtc.h>
 #include <util/fs.h>
-#include <util/lock_and_find.h>
 #include <util/log.h>
 #include <util/string_utils.h>
 
@@ -93,14 +92,6 @@ void update_viewport(HostState &state) {
 }
 
 bool init(HostState &state, Config &cfg, const Root &root_paths) {
-    const ResumeAudioThread resume_thread = [&state](SceUID thread_id) {
-        const auto thread = lock_and_find(thread_id, state.kernel.threads, state.kernel.mutex);
-        const std::lock_guard<std::mutex> lock(thread->mutex);
-        if (thread->status == ThreadStatus::wait) {
-            thread->update_status(ThreadStatus::run);
-        }
-    };
-
     state.cfg = std::move(cfg);
 
     state.base_path = root_paths.get_base_path_string();
@@ -137,6 +128,8 @@ bool init(HostState &state, Config &cfg, const Root &root_paths) {
         break;
     }
 
+    state.display.vblank_spin_wait = cfg.vblank_spin_wait;
+
     if (cfg.fullscreen) {
         state.display.fullscreen = true;
         window_type |= SDL_WINDOW_FULLSCREEN_DESKTOP;
@@ -160,7 +153,7 @@ bool init(HostState &state, Config &cfg, const Root &root_paths) {
         return false;
     }
 
-    if (!init(state.audio, resume_thread)) {
+    if (!init(state.audio, cfg.audio_buffer_size)) {
         LOG_WARN("Failed to init audio! Audio will not work.");
     }
 
@@ -19,10 +19,16 @@
 
 #include <util/types.h>
 
-#include <functional>
+#include <cstdint>
 
 struct AudioState;
+struct AudioOutPort;
 
-typedef std::function<void(SceUID)> ResumeAudioThread;
+// buffer_samples is the device buffer size in frames, rounded up to a power of two
+bool init(AudioState &state, int buffer_samples);
 
-bool init(AudioState &state, ResumeAudioThread resume_thread);
+// Returns the new port id, or 0 if the samples can't be converted to the device format
+int open_out_port(AudioState &state, int len, int freq, int channels);
+// Converts a grain of guest samples and queues it, now_us being the current guest time.
+// Returns the guest time at which the hardware takes the grain in, once the grain before it starts playing.
+std::uint64_t output_to_port(AudioState &state, AudioOutPort &port, const void *buf, std::uint64_t now_us);
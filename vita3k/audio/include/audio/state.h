@@ -21,7 +21,8 @@
 
 #include <SDL_audio.h>
 
-#include <functional>
+#include <array>
+#include <atomic>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -31,26 +32,86 @@
 #define SCE_AUDIO_VOLUME_0DB SCE_AUDIO_OUT_MAX_VOL //!< Maximum output port volume
 
 typedef std::shared_ptr<SDL_AudioStream> AudioStreamPtr;
-typedef std::function<void(SceUID)> ResumeAudioThread;
+
+// Single producer single consumer ring of frames in the device format.
+// The guest thread outputting to the port writes, the audio callback reads, neither takes a lock.
+class AudioOutRing {
+public:
+    // Not thread safe, called before the port is published
+    void reset(std::size_t min_capacity_frames, std::size_t frame_bytes);
+
+    // Frames queued
+    std::size_t size() const;
+    std::size_t capacity() const {
+        return capacity_frames;
+    }
+
+    // Returns the number of frames written or read, which is less than asked when the ring is full or empty
+    std::size_t write(const uint8_t *data, std::size_t frames);
+    std::size_t read(uint8_t *data, std::size_t frames);
+
+private:
+    std::vector<uint8_t> buffer;
+    std::size_t capacity_frames = 0;
+    std::size_t frame_bytes = 0;
+
+    // Positions only grow, they are masked when accessing the buffer
+    alignas(64) std::atomic<std::size_t> write_pos{ 0 };
+    alignas(64) std::atomic<std::size_t> read_pos{ 0 };
+};
 
 struct ReadOnlyAudioOutPortState {
+    int id = 0;
+    int len = 0;
+    int freq = 0;
     int len_bytes = 0;
+    // A grain converted to the device rate
+    std::size_t grain_frames = 0;
+    // Device buffer frames the ring may hold beyond the two grains the port clock keeps queued
+    std::size_t slack_frames = 0;
 };
 
+// Models the hardware consuming the port one grain after the other, in guest microseconds.
+// Output returns once the grain before the submitted one starts playing, so one grain is always queued.
+struct AudioOutPortClock {
+    bool running = false;
+    std::uint64_t start_us = 0;
+    // Samples submitted since start_us, at the port rate
+    std::uint64_t samples = 0;
+};
+
+struct AudioOutPortStats {
+    std::atomic<std::uint64_t> grains{ 0 };
+    // Submitted after every grain before them finished playing, the port went silent
+    std::atomic<std::uint64_t> late_grains{ 0 };
+    // The device ran dry in the middle of a buffer
+    std::atomic<std::uint64_t> starved_callbacks{ 0 };
+    // Didn't fit in the ring
+    std::atomic<std::uint64_t> dropped_frames{ 0 };
+};
+
+// Producer side, the audio callback never touches it
 struct SharedAudioOutPortState {
     std::mutex mutex;
     AudioStreamPtr stream;
-    SceUID thread = -1;
+    std::vector<uint8_t> convert_buffer;
+    AudioOutPortClock clock;
+    // Totals at the last statistics report
+    std::uint64_t reported_late_grains = 0;
+    std::uint64_t reported_starved_callbacks = 0;
+    std::uint64_t reported_dropped_frames = 0;
 };
 
 struct AudioOutPort {
     ReadOnlyAudioOutPortState ro;
     SharedAudioOutPortState shared;
+    AudioOutRing ring;
+    AudioOutPortStats stats;
     // Channel range from 0 - 32768
     int left_channel_volume = SCE_AUDIO_VOLUME_0DB;
     int right_channel_volume = SCE_AUDIO_VOLUME_0DB;
     // Volume range from 1 - 128
-    float volume = SDL_MIX_MAXVOLUME;
+    std::atomic<int> volume{ SDL_MIX_MAXVOLUME };
 };
 
 struct AudioInPort {
@@ -63,9 +124,12 @@ typedef std::shared_ptr<AudioOutPort> AudioOutPortPtr;
 typedef std::map<int, AudioOutPortPtr> AudioOutPortPtrs;
 typedef std::shared_ptr<void> AudioDevicePtr;
 
+struct AudioOutPortSnapshot {
+    std::vector<AudioOutPortPtr> ports;
+};
+
 struct ReadOnlyAudioState {
     SDL_AudioSpec spec;
-    ResumeAudioThread resume_thread;
 };
 
 struct AudioCallbackState {
@@ -76,6 +140,11 @@ struct SharedAudioState {
     std::mutex mutex;
     int next_port_id = 1;
     AudioOutPortPtrs out_ports;
+    // The audio callback reads the published snapshot without locking. Port changes rebuild the other
+    // one under mutex, once the callback is done with it, and swap it in.
+    std::array<AudioOutPortSnapshot, 2> snapshots;
+    std::atomic<AudioOutPortSnapshot *> published_snapshot{ nullptr };
+    std::atomic<AudioOutPortSnapshot *> reading_snapshot{ nullptr };
     AudioInPort in_port;
 };
 
@@ -25,34 +25,73 @@
 #include <algorithm>
 #include <cassert>
 #include <cstring>
+#include <thread>
 
 #define AUDIO_PROFILE(name) MICROPROFILE_SCOPEI("Audio", name, MP_THISTLE)
 
-static void mix_out_port(uint8_t *stream, uint8_t *temp_buffer, int len, AudioOutPort &port, const ResumeAudioThread &resume_thread) {
+static constexpr int MIN_BUFFER_SAMPLES = 64;
+static constexpr int MAX_BUFFER_SAMPLES = 4096;
+
+void AudioOutRing::reset(std::size_t min_capacity_frames, std::size_t frame_bytes) {
+    capacity_frames = 1;
+    while (capacity_frames < min_capacity_frames)
+        capacity_frames <<= 1;
+
+    this->frame_bytes = frame_bytes;
+    buffer.assign(capacity_frames * frame_bytes, 0);
+    write_pos = 0;
+    read_pos = 0;
+}
+
+std::size_t AudioOutRing::size() const {
+    // Read position first, so the difference can't underflow
+    const std::size_t read = read_pos.load(std::memory_order_acquire);
+    const std::size_t write = write_pos.load(std::memory_order_acquire);
+    return std::min(write - read, capacity_frames);
+}
+
+std::size_t AudioOutRing::write(const uint8_t *data, std::size_t frames) {
+    const std::size_t write = write_pos.load(std::memory_order_relaxed);
+    const std::size_t read = read_pos.load(std::memory_order_acquire);
+    frames = std::min(frames, capacity_frames - (write - read));
+
+    const std::size_t offset = write & (capacity_frames - 1);
+    const std::size_t first = std::min(frames, capacity_frames - offset);
+    std::memcpy(&buffer[offset * frame_bytes], data, first * frame_bytes);
+    std::memcpy(buffer.data(), data + first * frame_bytes, (frames - first) * frame_bytes);
+
+    write_pos.store(write + frames, std::memory_order_release);
+    return frames;
+}
+
+std::size_t AudioOutRing::read(uint8_t *data, std::size_t frames) {
+    const std::size_t read = read_pos.load(std::memory_order_relaxed);
+    const std::size_t write = write_pos.load(std::memory_order_acquire);
+    frames = std::min(frames, write - read);
+
+    const std::size_t offset = read & (capacity_frames - 1);
+    const std::size_t first = std::min(frames, capacity_frames - offset);
+    std::memcpy(data, &buffer[offset * frame_bytes], first * frame_bytes);
+    std::memcpy(data + first * frame_bytes, buffer.data(), (frames - first) * frame_bytes);
+
+    read_pos.store(read + frames, std::memory_order_release);
+    return frames;
+}
+
+static std::size_t get_frame_bytes(const SDL_AudioSpec &spec) {
+    return (SDL_AUDIO_BITSIZE(spec.format) / 8) * spec.channels;
+}
+
+static void mix_out_port(uint8_t *stream, uint8_t *temp_buffer, const SDL_AudioSpec &spec, AudioOutPort &port) {
     AUDIO_PROFILE(__func__);
 
-    // How much data is available?
-    std::unique_lock<std::mutex> lock(port.shared.mutex);
-    const int bytes_available = SDL_AudioStreamAvailable(port.shared.stream.get());
-    assert(bytes_available >= 0);
-
-    // Running out of data?
-    // The (len * 2) is just a guess that seems to work.
-    if (bytes_available < (len * 2)) {
-        // Is there a thread waiting for playback to finish?
-        if (port.shared.thread >= 0) {
-            // Wake the thread up.
-            resume_thread(port.shared.thread);
-            port.shared.thread = -1;
-        }
-    }
+    const std::size_t frames = port.ring.read(temp_buffer, spec.samples);
+    if (frames > 0) {
+        SDL_MixAudio(stream, temp_buffer, static_cast<Uint32>(frames * get_frame_bytes(spec)), port.volume.load(std::memory_order_relaxed));
 
-    // Mix as much as we need.
-    const int bytes_to_get = std::min(len, bytes_available);
-    const int bytes_got = SDL_AudioStreamGet(port.shared.stream.get(), temp_buffer, bytes_to_get);
-    lock.unlock();
-    if (bytes_got > 0) {
-        SDL_MixAudio(stream, temp_buffer, bytes_got, port.volume);
+        // An empty ring is a port that isn't playing, running out halfway is an underrun
+        if (frames < spec.samples)
+            port.stats.starved_callbacks.fetch_add(1, std::memory_order_relaxed);
     }
 }
 
@@ -65,35 +104,55 @@ static void SDLCALL audio_callback(void *userdata, Uint8 *stream, int len) {
     assert(len == state.ro.spec.size);
     assert(len == state.callback.temp_buffer.size());
 
-    std::vector<AudioOutPortPtr> ports;
-    {
-        // Read from shared state.
-        const std::lock_guard<std::mutex> lock(state.shared.mutex);
-        ports.reserve(state.shared.out_ports.size());
-        for (const AudioOutPortPtrs::value_type &port : state.shared.out_ports) {
-            ports.push_back(port.second);
+    // Retry until the snapshot marked as read is still the published one, see publish_out_ports
+    AudioOutPortSnapshot *snapshot;
+    do {
+        snapshot = state.shared.published_snapshot.load();
+        state.shared.reading_snapshot.store(snapshot);
+    } while (state.shared.published_snapshot.load() != snapshot);
+
+    std::memset(stream, state.ro.spec.silence, len);
+
+    if (snapshot) {
+        for (const AudioOutPortPtr &port : snapshot->ports) {
+            mix_out_port(stream, state.callback.temp_buffer.data(), state.ro.spec, *port);
         }
     }
 
-    std::memset(stream, state.ro.spec.silence, len);
+    state.shared.reading_snapshot.store(nullptr);
+}
+
+// Called with the shared mutex held
+static void publish_out_ports(SharedAudioState &shared) {
+    AudioOutPortSnapshot *const current = shared.published_snapshot.load();
+    AudioOutPortSnapshot *const next = (current == &shared.snapshots[0]) ? &shared.snapshots[1] : &shared.snapshots[0];
 
-    for (const AudioOutPortPtr &port : ports) {
-        mix_out_port(stream, state.callback.temp_buffer.data(), len, *port, state.ro.resume_thread);
+    // The callback may still be mixing from it if it started before the previous swap, it doesn't take long
+    while (shared.reading_snapshot.load() == next)
+        std::this_thread::yield();
+
+    next->ports.clear();
+    for (const AudioOutPortPtrs::value_type &port : shared.out_ports) {
+        next->ports.push_back(port.second);
     }
+    shared.published_snapshot.store(next);
 }
 
 static void close_audio(void *) {
     SDL_CloseAudio();
 }
 
-bool init(AudioState &state, ResumeAudioThread resume_thread) {
-    state.ro.resume_thread = resume_thread;
+bool init(AudioState &state, int buffer_samples) {
+    // SDL wants a power of two
+    int samples = MIN_BUFFER_SAMPLES;
+    while ((samples < buffer_samples) && (samples < MAX_BUFFER_SAMPLES))
+        samples <<= 1;
 
     SDL_AudioSpec desired = {};
     desired.freq = 48000;
     desired.format = AUDIO_S16LSB;
     desired.channels = 2;
-    desired.samples = 1024;
+    desired.samples = samples;
     desired.callback = &audio_callback;
     desired.userdata = &state;
 
@@ -104,8 +163,114 @@ bool init(AudioState &state, ResumeAudioThread resume_thread) {
 
     state.device = AudioDevicePtr(nullptr, close_audio);
     state.callback.temp_buffer.resize(state.ro.spec.size);
+    LOG_INFO("Audio device opened with {} samples buffers at {} Hz", state.ro.spec.samples, state.ro.spec.freq);
 
     SDL_PauseAudio(0);
 
     return true;
 }
+
+int open_out_port(AudioState &state, int len, int freq, int channels) {
+    const SDL_AudioSpec &spec = state.ro.spec;
+    const AudioStreamPtr stream(SDL_NewAudioStream(AUDIO_S16LSB, channels, freq, spec.format, spec.channels, spec.freq), SDL_FreeAudioStream);
+    if (!stream) {
+        return 0;
+    }
+
+    // Frames of a grain once converted to the device rate
+    const std::size_t grain_frames = (static_cast<std::size_t>(len) * spec.freq + freq - 1) / freq;
+    const std::size_t frame_bytes = get_frame_bytes(spec);
+
+    const AudioOutPortPtr port = std::make_shared<AudioOutPort>();
+    port->ro.len = len;
+    port->ro.freq = freq;
+    port->ro.len_bytes = len * channels * sizeof(int16_t);
+    port->ro.grain_frames = grain_frames;
+    // The device pulls a buffer ahead and may ask for it just before the next grain comes in
+    port->ro.slack_frames = spec.samples * 2;
+    port->ring.reset(grain_frames * 3 + port->ro.slack_frames, frame_bytes);
+    port->shared.stream = stream;
+    port->shared.convert_buffer.resize(grain_frames * 2 * frame_bytes);
+
+    const std::lock_guard<std::mutex> lock(state.shared.mutex);
+    const int port_id = state.shared.next_port_id++;
+    port->ro.id = port_id;
+    state.shared.out_ports.emplace(port_id, port);
+    publish_out_ports(state.shared);
+
+    return port_id;
+}
+
+static std::uint64_t frames_to_us(std::uint64_t frames, int freq) {
+    return frames * 1'000'000 / freq;
+}
+
+static void report_out_port_stats(AudioOutPort &port) {
+    SharedAudioOutPortState &shared = port.shared;
+    const std::uint64_t late_grains = port.stats.late_grains.load(std::memory_order_relaxed);
+    const std::uint64_t starved_callbacks = port.stats.starved_callbacks.load(std::memory_order_relaxed);
+    const std::uint64_t dropped_frames = port.stats.dropped_frames.load(std::memory_order_relaxed);
+    if ((late_grains == shared.reported_late_grains) && (starved_callbacks == shared.reported_starved_callbacks) && (dropped_frames == shared.reported_dropped_frames))
+        return;
+
+    LOG_WARN("Audio port {}: {} late grains, {} device underruns and {} dropped frames in the last minute", port.ro.id,
+        late_grains - shared.reported_late_grains, starved_callbacks - shared.reported_starved_callbacks, dropped_frames - shared.reported_dropped_frames);
+    shared.reported_late_grains = late_grains;
+    shared.reported_starved_callbacks = starved_callbacks;
+    shared.reported_dropped_frames = dropped_frames;
+}
+
+std::uint64_t output_to_port(AudioState &state, AudioOutPort &port, const void *buf, std::uint64_t now_us) {
+    AUDIO_PROFILE(__func__);
+
+    const std::lock_guard<std::mutex> lock(port.shared.mutex);
+    SDL_AudioStream *const stream = port.shared.stream.get();
+    SDL_AudioStreamPut(stream, buf, port.ro.len_bytes);
+
+    const int available = SDL_AudioStreamAvailable(stream);
+    if (available > 0) {
+        if (port.shared.convert_buffer.size() < static_cast<std::size_t>(available))
+            port.shared.convert_buffer.resize(available);
+
+        const int bytes_got = SDL_AudioStreamGet(stream, port.shared.convert_buffer.data(), available);
+        if (bytes_got > 0) {
+            const std::size_t frames = bytes_got / get_frame_bytes(state.ro.spec);
+            const std::size_t written = port.ring.write(port.shared.convert_buffer.data(), frames);
+            port.stats.dropped_frames.fetch_add(frames - written, std::memory_order_relaxed);
+        }
+    }
+
+    const std::uint64_t grains = port.stats.grains.fetch_add(1, std::memory_order_relaxed) + 1;
+    const std::uint64_t grains_per_minute = std::max<std::uint64_t>(60ULL * port.ro.freq / port.ro.len, 1);
+    if ((grains % grains_per_minute) == 0)
+        report_out_port_stats(port);
+
+    AudioOutPortClock &clock = port.shared.clock;
+    if (clock.running && (now_us >= clock.start_us + frames_to_us(clock.samples, port.ro.freq))) {
+        // Everything submitted already played, the port went silent in between
+        port.stats.late_grains.fetch_add(1, std::memory_order_relaxed);
+        clock.running = false;
+    }
+    if (!clock.running) {
+        clock.running = true;
+        clock.start_us = now_us;
+        clock.samples = 0;
+    }
+    const std::uint64_t previous_start_samples = (clock.samples >= static_cast<std::uint64_t>(port.ro.len)) ? clock.samples - port.ro.len : 0;
+    clock.samples += port.ro.len;
+
+    // Follow the device clock, which drifts from the guest one. The ring should hold about the previous grain
+    // and this one, only move the port clock when it is off by more than the device buffering.
+    if (clock.samples > static_cast<std::uint64_t>(port.ro.len)) {
+        const std::size_t queued = port.ring.size();
+        const std::size_t max_queued = port.ro.grain_frames * 2 + port.ro.slack_frames;
+        const std::size_t min_queued = port.ro.grain_frames * 2 - std::min(port.ro.slack_frames, port.ro.grain_frames);
+        if (queued > max_queued) {
+            clock.start_us += frames_to_us(queued - max_queued, state.ro.spec.freq);
+        } else if (queued < min_queued) {
+            clock.start_us -= std::min(frames_to_us(min_queued - queued, state.ro.spec.freq), clock.start_us);
+        }
+    }
+
+    return std::max(clock.start_us + frames_to_us(previous_start_samples, port.ro.freq), now_us);
+}
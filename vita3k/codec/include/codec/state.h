@@ -18,15 +18,20 @@
 #pragma once
 
 #include <array>
+#include <condition_variable>
 #include <cstdint>
+#include <mutex>
 #include <queue>
 #include <string>
+#include <thread>
+#include <vector>
 
 struct AVFrame;
 struct AVPacket;
 struct AVCodecContext;
 struct AVFormatContext;
 struct AVCodecParserContext;
+struct SwrContext;
 
 union DecoderSize {
     struct {
@@ -62,6 +67,8 @@ struct DecoderState {
 
     // TODO: proper error handling (return bool?)
     virtual void flush();
+    // Signals the end of the stream, receive() then returns the frames still held by the decoder
+    virtual void drain();
     virtual bool send(const uint8_t *data, uint32_t size) = 0;
     virtual bool receive(uint8_t *data, DecoderSize *size = nullptr) = 0;
     virtual void configure(void *options);
@@ -79,27 +86,43 @@ struct H264DecoderOptions {
 
 struct H264DecoderState : public DecoderState {
     AVCodecParserContext *parser{};
+    AVPacket *packet{};
+    AVFrame *frame{};
+    std::vector<uint8_t> au_frame;
+    bool draining = false;
 
     uint64_t pts = ~0ull;
     uint64_t dts = ~0ull;
+    // Layout of the pictures written by receive, see copy_yuv_data_from_frame
+    bool chroma_interleaved = false;
 
     static uint32_t buffer_size(DecoderSize size);
 
     uint32_t get(DecoderQuery query) override;
 
+    void flush() override;
+    void drain() override;
     bool send(const uint8_t *data, uint32_t size) override;
+    // Returns false without a picture while frame threading holds it back, or once drained
     bool receive(uint8_t *data, DecoderSize *size) override;
     void configure(void *options) override;
 
-    H264DecoderState(uint32_t width, uint32_t height);
+    // A thread_count of 0 lets ffmpeg pick one per host core. Frame threading delays the output by
+    // thread_count - 1 pictures, so only slice threading is used unless it is asked for.
+    H264DecoderState(uint32_t width, uint32_t height, int thread_count, bool frame_threading = false);
     ~H264DecoderState() override;
 };
 
 struct MjpegDecoderState : public DecoderState {
+    AVPacket *packet{};
+    AVFrame *frame{};
+    std::vector<uint8_t> jpeg_buffer;
+
     bool send(const uint8_t *data, uint32_t size) override;
     bool receive(uint8_t *data, DecoderSize *size) override;
 
-    MjpegDecoderState();
+    explicit MjpegDecoderState(int thread_count);
+    ~MjpegDecoderState() override;
 };
 
 struct Atrac9DecoderState : public DecoderState {
@@ -163,45 +186,145 @@ public:
     explicit PCMDecoderState(const float dest_frequency);
 };
 
-struct PlayerState {
-    std::string video_playing;
-    std::queue<std::string> videos_queue;
-
-    AVFormatContext *format{};
-    AVCodecContext *video_context{};
-    AVCodecContext *audio_context{};
-    int32_t video_stream_id = -1;
-    int32_t audio_stream_id = -1;
+enum class PlayerMediaType {
+    VIDEO,
+    AUDIO,
+};
 
-    std::queue<AVPacket *> audio_packets;
-    std::queue<AVPacket *> video_packets;
+// A decoded frame, stored in the buffer given to PlayerState::set_buffers at buffer_index
+struct PlayerFrame {
+    uint32_t buffer_index = 0;
+    uint32_t size = 0;
+    uint64_t timestamp = 0;
+
+    // Video only, taken from the frame itself since the player's size changes as soon as it opens the next video
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint64_t duration_microseconds = 0;
+
+    // Audio only
+    uint32_t channels = 0;
+    uint32_t sample_rate = 0;
+    uint32_t sample_count = 0;
+};
 
-    uint64_t time_of_last_frame = 0;
-    uint64_t framerate_microseconds = 0;
+// Decodes ahead on its own thread, straight into buffers owned by the caller.
+// The frames queued per stream are bounded by the buffer count minus RESERVED_BUFFERS, so the frame
+// delivered last and the one before it, which the guest may still be reading, are never overwritten.
+struct PlayerState {
+    static constexpr uint32_t VIDEO_BUFFER_COUNT = 5;
+    static constexpr uint32_t AUDIO_BUFFER_COUNT = 10;
+    static constexpr uint32_t RESERVED_BUFFERS = 2;
 
-    uint64_t last_timestamp = 0;
-    uint32_t last_channels = 0;
-    uint32_t last_sample_rate = 0;
-    uint32_t last_sample_count = 0;
+    PlayerState();
+    ~PlayerState();
 
     DecoderSize get_size();
-    uint64_t get_framerate_microseconds();
+    // Format of the audio stream, before any frame is decoded
+    PlayerFrame get_audio_format();
 
+    // Playing a video, or video frames of one are left to deliver
+    bool is_active();
+
+    // Opens the video right away if none is playing
+    void queue(const std::string &path);
     void pop_video();
     void free_video();
+
+    // Returns false if no frame is ready, O(1)
+    bool receive(PlayerMediaType type, PlayerFrame &frame);
+    // Size of the buffers the decoder waits for, 0 if it doesn't wait. Buffers can only be replaced once the
+    // frames decoded in the old ones are received.
+    uint32_t get_required_buffer_size(PlayerMediaType type);
+    void set_buffers(PlayerMediaType type, const std::vector<uint8_t *> &buffers, uint32_t size);
+
+private:
+    struct FrameQueue {
+        std::vector<uint8_t *> buffers;
+        uint32_t buffer_size = 0;
+        uint32_t required_size = 0;
+        std::vector<PlayerFrame> frames;
+        // Only grow, frames[written % buffers.size()] is the next one decoded
+        uint64_t written = 0;
+        uint64_t read = 0;
+
+        bool has_room() const;
+    };
+
+    // Decoder thread side of a stream
+    struct StreamDecoder {
+        AVCodecContext *context{};
+        int32_t stream_id = -1;
+        std::queue<AVPacket *> packets;
+        // Allocated once, holds a decoded frame until there's a buffer to write it to
+        AVFrame *frame{};
+        bool frame_pending = false;
+        bool ended = false;
+    };
+
+    // The decoders and the format context belong to whoever set busy, the decoder thread or a caller
+    // opening or closing a video
+    void acquire_decoders(std::unique_lock<std::mutex> &lock);
+    void release_decoders();
+
     void switch_video(const std::string &path);
+    void close_video();
+    bool can_decode() const;
+    bool next_packet(StreamDecoder &stream, StreamDecoder &other);
+    void decode(PlayerMediaType type);
+    void decode_loop();
+
+    FrameQueue &get_queue(PlayerMediaType type) {
+        return type == PlayerMediaType::VIDEO ? video_frames : audio_frames;
+    }
+    StreamDecoder &get_decoder(PlayerMediaType type) {
+        return type == PlayerMediaType::VIDEO ? video : audio;
+    }
+
+    // Everything below is guarded by mutex, except the format context and the decoders, see acquire_decoders
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::thread thread;
+    bool quit = false;
+    bool busy = false;
 
-    bool next_packet(int32_t stream_id);
+    std::string video_playing;
+    std::queue<std::string> videos_queue;
 
-    std::vector<int16_t> receive_audio();
-    std::vector<uint8_t> receive_video();
+    AVFormatContext *format{};
+    StreamDecoder video;
+    StreamDecoder audio;
 
-    void queue(const std::string &path);
+    DecoderSize size{};
+    PlayerFrame audio_format;
 
-    ~PlayerState();
+    FrameQueue video_frames;
+    FrameQueue audio_frames;
+};
+
+// Converts interleaved s16 samples to interleaved stereo float.
+// Same rate mono and stereo input is converted directly, anything else goes through a swresample
+// context kept until the format changes.
+struct S16ToF32Converter {
+    S16ToF32Converter() = default;
+    S16ToF32Converter(const S16ToF32Converter &) = delete;
+    S16ToF32Converter &operator=(const S16ToF32Converter &) = delete;
+    ~S16ToF32Converter();
+
+    bool convert(const int16_t *source_s16, int32_t source_channels, uint32_t source_samples, uint32_t source_freq,
+        float *dest_f32, uint32_t dest_samples, uint32_t dest_freq);
+
+private:
+    SwrContext *swr = nullptr;
+    int32_t swr_channels = 0;
+    uint32_t swr_source_freq = 0;
+    uint32_t swr_dest_freq = 0;
 };
 
+// Writes a YUV420 frame in one of the layouts the renderer converts YUV420 textures from: the Y plane followed by
+// either the U and V planes (P3) or a single plane of interleaved U and V samples (P2, NV12)
+void copy_yuv_data_from_frame(AVFrame *frame, uint8_t *dest, bool chroma_interleaved);
+// Converts a YUV444 image as returned by MjpegDecoderState::receive, doesn't need a decoder
 void convert_yuv_to_rgb(const uint8_t *yuv, uint8_t *rgba, uint32_t width, uint32_t height);
-void copy_yuv_data_from_frame(AVFrame *frame, uint8_t *dest);
 bool resample_s16_to_f32(const int16_t *source_s16, int32_t source_channels, uint32_t source_samples, uint32_t source_freq,
     float *dest_f32, uint32_t dest_samples, uint32_t dest_freq);
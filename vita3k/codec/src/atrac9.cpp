@@ -28,29 +28,123 @@ extern "C" {
 
 #include <util/log.h>
 
+#include <algorithm>
 #include <cassert>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CODEC_S16_TO_F32_SSE2
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define CODEC_S16_TO_F32_NEON
+#endif
+
 struct FFMPEGAtrac9Info {
     uint32_t version;
     uint32_t config_data;
     uint32_t padding;
 };
 
-bool resample_s16_to_f32(const int16_t *source_s16, int32_t source_channels, uint32_t source_samples, uint32_t source_freq,
+// swresample spreads a mono channel over both front channels at -3dB
+static const float MONO_TO_STEREO_SCALE = 0.70710678f / 32768.0f;
+static const float S16_TO_F32_SCALE = 1.0f / 32768.0f;
+
+static void convert_stereo_s16_to_f32(const int16_t *source, float *dest, uint32_t samples) {
+    uint32_t i = 0;
+    const uint32_t count = samples * 2;
+#if defined(CODEC_S16_TO_F32_SSE2)
+    const __m128 scale = _mm_set1_ps(S16_TO_F32_SCALE);
+    for (; i + 8 <= count; i += 8) {
+        const __m128i s16 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i));
+        // Sign extend by putting each sample in the high half of a 32-bit lane
+        const __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(s16, s16), 16);
+        const __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(s16, s16), 16);
+        _mm_storeu_ps(dest + i, _mm_mul_ps(_mm_cvtepi32_ps(low), scale));
+        _mm_storeu_ps(dest + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(high), scale));
+    }
+#elif defined(CODEC_S16_TO_F32_NEON)
+    const float32x4_t scale = vdupq_n_f32(S16_TO_F32_SCALE);
+    for (; i + 8 <= count; i += 8) {
+        const int16x8_t s16 = vld1q_s16(source + i);
+        vst1q_f32(dest + i, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(s16))), scale));
+        vst1q_f32(dest + i + 4, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(s16))), scale));
+    }
+#endif
+    for (; i < count; i++)
+        dest[i] = source[i] * S16_TO_F32_SCALE;
+}
+
+static void convert_mono_s16_to_stereo_f32(const int16_t *source, float *dest, uint32_t samples) {
+    uint32_t i = 0;
+#if defined(CODEC_S16_TO_F32_SSE2)
+    const __m128 scale = _mm_set1_ps(MONO_TO_STEREO_SCALE);
+    for (; i + 8 <= samples; i += 8) {
+        const __m128i s16 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i));
+        const __m128 low = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s16, s16), 16)), scale);
+        const __m128 high = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(s16, s16), 16)), scale);
+        _mm_storeu_ps(dest + i * 2, _mm_unpacklo_ps(low, low));
+        _mm_storeu_ps(dest + i * 2 + 4, _mm_unpackhi_ps(low, low));
+        _mm_storeu_ps(dest + i * 2 + 8, _mm_unpacklo_ps(high, high));
+        _mm_storeu_ps(dest + i * 2 + 12, _mm_unpackhi_ps(high, high));
+    }
+#elif defined(CODEC_S16_TO_F32_NEON)
+    const float32x4_t scale = vdupq_n_f32(MONO_TO_STEREO_SCALE);
+    for (; i + 4 <= samples; i += 4) {
+        const float32x4_t mono = vmulq_f32(vcvtq_f32_s32(vmovl_s16(vld1_s16(source + i))), scale);
+        vst2q_f32(dest + i * 2, float32x4x2_t{ { mono, mono } });
+    }
+#endif
+    for (; i < samples; i++) {
+        const float sample = source[i] * MONO_TO_STEREO_SCALE;
+        dest[i * 2] = sample;
+        dest[i * 2 + 1] = sample;
+    }
+}
+
+S16ToF32Converter::~S16ToF32Converter() {
+    swr_free(&swr);
+}
+
+bool S16ToF32Converter::convert(const int16_t *source_s16, int32_t source_channels, uint32_t source_samples, uint32_t source_freq,
     float *dest_f32, uint32_t dest_samples, uint32_t dest_freq) {
-    const int source_channel_type = source_channels == 2 ? AV_CH_LAYOUT_STEREO : AV_CH_LAYOUT_MONO;
+    if ((source_freq == dest_freq) && (source_channels == 1 || source_channels == 2)) {
+        const uint32_t samples = std::min(source_samples, dest_samples);
+        if (source_channels == 2)
+            convert_stereo_s16_to_f32(source_s16, dest_f32, samples);
+        else
+            convert_mono_s16_to_stereo_f32(source_s16, dest_f32, samples);
+        return true;
+    }
+
+    if (!swr || (swr_channels != source_channels) || (swr_source_freq != source_freq) || (swr_dest_freq != dest_freq)) {
+        swr_free(&swr);
 
-    SwrContext *swr = swr_alloc_set_opts(nullptr,
-        AV_CH_LAYOUT_STEREO, AV_SAMPLE_FMT_FLT, dest_freq,
-        source_channel_type, AV_SAMPLE_FMT_S16, source_freq,
-        0, nullptr);
+        const int source_channel_type = source_channels == 2 ? AV_CH_LAYOUT_STEREO : AV_CH_LAYOUT_MONO;
+        swr = swr_alloc_set_opts(nullptr,
+            AV_CH_LAYOUT_STEREO, AV_SAMPLE_FMT_FLT, dest_freq,
+            source_channel_type, AV_SAMPLE_FMT_S16, source_freq,
+            0, nullptr);
+
+        if (!swr || (swr_init(swr) < 0)) {
+            LOG_ERROR("Failed to initialize s16 to f32 conversion from {} Hz to {} Hz", source_freq, dest_freq);
+            swr_free(&swr);
+            return false;
+        }
 
-    swr_init(swr);
+        swr_channels = source_channels;
+        swr_source_freq = source_freq;
+        swr_dest_freq = dest_freq;
+    }
 
     const int result = swr_convert(swr, (uint8_t **)&dest_f32, dest_samples, (const uint8_t **)(&source_s16), source_samples);
-    swr_free(&swr);
     assert(result > 0);
     return (result >= 0);
+}
+
+bool resample_s16_to_f32(const int16_t *source_s16, int32_t source_channels, uint32_t source_samples, uint32_t source_freq,
+    float *dest_f32, uint32_t dest_samples, uint32_t dest_freq) {
+    S16ToF32Converter converter;
+    return converter.convert(source_s16, source_channels, source_samples, source_freq, dest_f32, dest_samples, dest_freq);
 };
 
 /*
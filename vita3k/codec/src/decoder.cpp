@@ -35,6 +35,10 @@ uint32_t DecoderState::get_es_size(const uint8_t *data) {
     return std::numeric_limits<uint32_t>::max();
 }
 
+void DecoderState::drain() {
+    // do nothing
+}
+
 void DecoderState::flush() {
     avcodec_flush_buffers(context);
 }
@@ -25,11 +25,23 @@ extern "C" {
 
 #include <cassert>
 
-void copy_yuv_data_from_frame(AVFrame *frame, uint8_t *dest) {
+void copy_yuv_data_from_frame(AVFrame *frame, uint8_t *dest, bool chroma_interleaved) {
     for (int32_t a = 0; a < frame->height; a++) {
         memcpy(dest, &frame->data[0][frame->linesize[0] * a], frame->width);
         dest += frame->width;
     }
+    if (chroma_interleaved) {
+        for (int32_t a = 0; a < frame->height / 2; a++) {
+            const uint8_t *u = &frame->data[1][frame->linesize[1] * a];
+            const uint8_t *v = &frame->data[2][frame->linesize[2] * a];
+            for (int32_t b = 0; b < frame->width / 2; b++) {
+                dest[b * 2] = u[b];
+                dest[b * 2 + 1] = v[b];
+            }
+            dest += frame->width;
+        }
+        return;
+    }
     for (int32_t a = 0; a < frame->height / 2; a++) {
         memcpy(dest, &frame->data[1][frame->linesize[1] * a], frame->width / 2);
         dest += frame->width / 2;
@@ -55,10 +67,12 @@ uint32_t H264DecoderState::get(DecoderQuery query) {
 bool H264DecoderState::send(const uint8_t *data, uint32_t size) {
     int error = 0;
 
-    std::vector<uint8_t> au_frame(size + AV_INPUT_BUFFER_PADDING_SIZE);
+    // The parser and decoder may read past the end of the input
+    if (au_frame.size() < size + AV_INPUT_BUFFER_PADDING_SIZE)
+        au_frame.resize(size + AV_INPUT_BUFFER_PADDING_SIZE);
     memcpy(au_frame.data(), data, size);
+    memset(au_frame.data() + size, 0, AV_INPUT_BUFFER_PADDING_SIZE);
 
-    AVPacket *packet = av_packet_alloc();
     error = av_parser_parse2(
         parser, // AVCodecParserContext *s,
         context, // AVCodecContext *avctx,
@@ -72,12 +86,20 @@ bool H264DecoderState::send(const uint8_t *data, uint32_t size) {
     );
     if (error < 0) {
         LOG_WARN("Error parsing H264 packet: {}.", log_hex(static_cast<uint32_t>(error)));
-        av_packet_free(&packet);
         return false;
     }
 
+    // An empty packet would put the decoder in draining mode
+    if (packet->size == 0)
+        return true;
+
+    // A previous drain() left the decoder at the end of the stream
+    if (draining) {
+        avcodec_flush_buffers(context);
+        draining = false;
+    }
+
     error = avcodec_send_packet(context, packet);
-    av_packet_free(&packet);
     if (error < 0) {
         LOG_WARN("Error sending H264 packet: {}.", log_hex(static_cast<uint32_t>(error)));
         return false;
@@ -87,27 +109,43 @@ bool H264DecoderState::send(const uint8_t *data, uint32_t size) {
 }
 
 bool H264DecoderState::receive(uint8_t *data, DecoderSize *size) {
-    AVFrame *frame = av_frame_alloc();
-
     int error = avcodec_receive_frame(context, frame);
     if (error < 0) {
-        LOG_WARN("Error receiving H264 frame: {}.", log_hex(static_cast<uint32_t>(error)));
-        av_frame_free(&frame);
+        // With frame threading the first pictures come out a few packets late, and the end of a drain is expected
+        if (error != AVERROR(EAGAIN) && error != AVERROR_EOF)
+            LOG_WARN("Error receiving H264 frame: {}.", log_hex(static_cast<uint32_t>(error)));
         return false;
     }
 
     if (data) {
-        copy_yuv_data_from_frame(frame, data);
+        copy_yuv_data_from_frame(frame, data, chroma_interleaved);
     }
 
     if (size) {
-        *size = { static_cast<uint32_t>(context->width), static_cast<uint32_t>(context->height) };
+        *size = { static_cast<uint32_t>(frame->width), static_cast<uint32_t>(frame->height) };
     }
 
-    av_frame_free(&frame);
+    av_frame_unref(frame);
     return true;
 }
 
+void H264DecoderState::drain() {
+    if (draining)
+        return;
+
+    int error = avcodec_send_packet(context, nullptr);
+    if (error < 0) {
+        LOG_WARN("Error draining H264 decoder: {}.", log_hex(static_cast<uint32_t>(error)));
+        return;
+    }
+    draining = true;
+}
+
+void H264DecoderState::flush() {
+    DecoderState::flush();
+    draining = false;
+}
+
 void H264DecoderState::configure(void *options) {
     auto *opt = reinterpret_cast<H264DecoderOptions *>(options);
 
@@ -115,7 +153,7 @@ void H264DecoderState::configure(void *options) {
     dts = static_cast<uint64_t>(opt->dts_upper) << 32u | static_cast<uint64_t>(opt->dts_lower);
 }
 
-H264DecoderState::H264DecoderState(uint32_t width, uint32_t height) {
+H264DecoderState::H264DecoderState(uint32_t width, uint32_t height, int thread_count, bool frame_threading) {
     AVCodec *codec = avcodec_find_decoder(AV_CODEC_ID_H264);
     assert(codec);
 
@@ -127,11 +165,20 @@ H264DecoderState::H264DecoderState(uint32_t width, uint32_t height) {
     assert(context);
     context->width = width;
     context->height = height;
+    // Frame threading is preferred by ffmpeg when both are allowed, guest players expecting a picture out of
+    // every packet would stall on its delay
+    context->thread_count = thread_count;
+    context->thread_type = frame_threading ? FF_THREAD_FRAME | FF_THREAD_SLICE : FF_THREAD_SLICE;
 
     int result = avcodec_open2(context, codec, nullptr);
     assert(result == 0);
+
+    packet = av_packet_alloc();
+    frame = av_frame_alloc();
 }
 
 H264DecoderState::~H264DecoderState() {
+    av_frame_free(&frame);
+    av_packet_free(&packet);
     av_parser_close(parser);
 }
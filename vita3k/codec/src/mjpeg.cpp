@@ -25,11 +25,15 @@ extern "C" {
 #include <util/log.h>
 
 #include <cassert>
+#include <memory>
 
 void convert_yuv_to_rgb(const uint8_t *yuv, uint8_t *rgba, uint32_t width, uint32_t height) {
-    SwsContext *context = sws_getContext(width, height, AV_PIX_FMT_YUV444P, width, height, AV_PIX_FMT_RGBA,
+    // One per host thread, reused as long as the image size doesn't change
+    thread_local std::unique_ptr<SwsContext, decltype(&sws_freeContext)> cached(nullptr, sws_freeContext);
+    SwsContext *sws = sws_getCachedContext(cached.release(), width, height, AV_PIX_FMT_YUV444P, width, height, AV_PIX_FMT_RGBA,
         0, nullptr, nullptr, nullptr);
-    assert(context);
+    cached.reset(sws);
+    assert(sws);
 
     const uint8_t *slices[] = {
         &yuv[0], // Y Slice
@@ -51,20 +55,19 @@ void convert_yuv_to_rgb(const uint8_t *yuv, uint8_t *rgba, uint32_t width, uint3
         static_cast<int>(width * 4),
     };
 
-    int error = sws_scale(context, slices, strides, 0, height, dst_slices, dst_strides);
+    int error = sws_scale(sws, slices, strides, 0, height, dst_slices, dst_strides);
     assert(error == height);
-    sws_freeContext(context);
 }
 
 bool MjpegDecoderState::send(const uint8_t *data, uint32_t size) {
-    std::vector<uint8_t> jpeg_buffer(size + AV_INPUT_BUFFER_PADDING_SIZE);
+    if (jpeg_buffer.size() < size + AV_INPUT_BUFFER_PADDING_SIZE)
+        jpeg_buffer.resize(size + AV_INPUT_BUFFER_PADDING_SIZE);
     std::memcpy(jpeg_buffer.data(), data, size);
+    std::memset(jpeg_buffer.data() + size, 0, AV_INPUT_BUFFER_PADDING_SIZE);
 
-    AVPacket *packet = av_packet_alloc();
     packet->data = jpeg_buffer.data();
     packet->size = size;
     int error = avcodec_send_packet(context, packet);
-    av_packet_free(&packet);
 
     if (error < 0) {
         LOG_WARN("Error sending Mjpeg packet: {}.", log_hex(static_cast<uint32_t>(error)));
@@ -74,11 +77,9 @@ bool MjpegDecoderState::send(const uint8_t *data, uint32_t size) {
 }
 
 bool MjpegDecoderState::receive(uint8_t *data, DecoderSize *size) {
-    AVFrame *frame = av_frame_alloc();
     int error = avcodec_receive_frame(context, frame);
     if (error < 0) {
         LOG_WARN("Error receiving Mjpeg frame: {}.", log_hex(static_cast<uint32_t>(error)));
-        av_frame_free(&frame);
         return false;
     }
 
@@ -104,17 +105,28 @@ bool MjpegDecoderState::receive(uint8_t *data, DecoderSize *size) {
         size->height = frame->height;
     }
 
-    av_frame_free(&frame);
+    av_frame_unref(frame);
 
     return true;
 }
 
-MjpegDecoderState::MjpegDecoderState() {
+MjpegDecoderState::MjpegDecoderState(int thread_count) {
     AVCodec *codec = avcodec_find_decoder(AV_CODEC_ID_MJPEG);
     assert(codec);
 
     context = avcodec_alloc_context3(codec);
     assert(context);
+    // Every image is returned by the call decoding it, frame threading would only add latency
+    context->thread_count = thread_count;
+    context->thread_type = FF_THREAD_SLICE;
     int error = avcodec_open2(context, codec, nullptr);
     assert(error == 0);
+
+    packet = av_packet_alloc();
+    frame = av_frame_alloc();
+}
+
+MjpegDecoderState::~MjpegDecoderState() {
+    av_frame_free(&frame);
+    av_packet_free(&packet);
 }
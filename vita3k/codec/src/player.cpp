@@ -28,56 +28,169 @@ extern "C" {
 #include <cassert>
 #include <chrono>
 
-uint64_t PlayerState::get_framerate_microseconds() {
-    AVRational rational = format->streams[video_stream_id]->avg_frame_rate;
-    return static_cast<float>(rational.den) / static_cast<float>(rational.num) * 1000000;
+bool PlayerState::FrameQueue::has_room() const {
+    if (required_size)
+        return false;
+    // Decode a first frame to know the size of the buffers to ask for
+    if (buffers.empty())
+        return true;
+    return written - read < buffers.size() - RESERVED_BUFFERS;
+}
+
+PlayerState::PlayerState() {
+    video.frame = av_frame_alloc();
+    audio.frame = av_frame_alloc();
+    thread = std::thread(&PlayerState::decode_loop, this);
+}
+
+PlayerState::~PlayerState() {
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    cond.notify_all();
+    thread.join();
+
+    close_video();
+    av_frame_free(&video.frame);
+    av_frame_free(&audio.frame);
 }
 
 DecoderSize PlayerState::get_size() {
-    if (video_context)
-        return { static_cast<uint32_t>(video_context->width), static_cast<uint32_t>(video_context->height) };
+    const std::lock_guard<std::mutex> lock(mutex);
+    return size;
+}
+
+PlayerFrame PlayerState::get_audio_format() {
+    const std::lock_guard<std::mutex> lock(mutex);
+    return audio_format;
+}
+
+bool PlayerState::is_active() {
+    const std::lock_guard<std::mutex> lock(mutex);
+    return !video_playing.empty() || (video_frames.written != video_frames.read);
+}
 
-    return {};
+void PlayerState::acquire_decoders(std::unique_lock<std::mutex> &lock) {
+    cond.wait(lock, [&] { return !busy; });
+    busy = true;
+}
+
+void PlayerState::release_decoders() {
+    busy = false;
+    cond.notify_all();
+}
+
+void PlayerState::queue(const std::string &path) {
+    if (fs::exists(path)) {
+        LOG_INFO("Queued video: '{}'.", path);
+        std::unique_lock<std::mutex> lock(mutex);
+        acquire_decoders(lock);
+        if (video_playing.empty()) {
+            lock.unlock();
+            switch_video(path);
+            lock.lock();
+        } else {
+            videos_queue.push(path);
+        }
+        release_decoders();
+    } else {
+        LOG_INFO("Cannot find video: {}", path);
+    }
 }
 
 void PlayerState::pop_video() {
-    switch_video(videos_queue.front());
+    std::unique_lock<std::mutex> lock(mutex);
+    if (videos_queue.empty())
+        return;
+
+    acquire_decoders(lock);
+    const std::string path = videos_queue.front();
     videos_queue.pop();
+    lock.unlock();
+    switch_video(path);
+    lock.lock();
+    release_decoders();
 }
 
 void PlayerState::free_video() {
-    if (video_context) {
-        avcodec_close(video_context);
-        avcodec_free_context(&video_context);
-    }
+    std::unique_lock<std::mutex> lock(mutex);
+    acquire_decoders(lock);
+    lock.unlock();
+    close_video();
+    lock.lock();
+
+    // Frames of the stopped video aren't delivered
+    video_frames.read = video_frames.written;
+    audio_frames.read = audio_frames.written;
+    release_decoders();
+}
 
-    if (audio_context) {
-        avcodec_close(audio_context);
-        avcodec_free_context(&audio_context);
-    }
+bool PlayerState::receive(PlayerMediaType type, PlayerFrame &frame) {
+    const std::lock_guard<std::mutex> lock(mutex);
+    FrameQueue &queue = get_queue(type);
+    if (queue.read == queue.written)
+        return false;
+
+    frame = queue.frames[queue.read % queue.frames.size()];
+    queue.read++;
+    // A buffer is free for the decoder again
+    cond.notify_all();
+    return true;
+}
 
-    if (format) {
-        avformat_close_input(&format);
-    }
+uint32_t PlayerState::get_required_buffer_size(PlayerMediaType type) {
+    const std::lock_guard<std::mutex> lock(mutex);
+    return get_queue(type).required_size;
+}
+
+void PlayerState::set_buffers(PlayerMediaType type, const std::vector<uint8_t *> &buffers, uint32_t size) {
+    const std::lock_guard<std::mutex> lock(mutex);
+    FrameQueue &queue = get_queue(type);
+    assert(queue.read == queue.written);
+    assert(buffers.size() > RESERVED_BUFFERS);
+
+    queue.buffers = buffers;
+    queue.buffer_size = size;
+    queue.frames.assign(buffers.size(), {});
+    queue.written = 0;
+    queue.read = 0;
+    if (size >= queue.required_size)
+        queue.required_size = 0;
+    cond.notify_all();
+}
+
+void PlayerState::close_video() {
+    for (StreamDecoder *stream : { &video, &audio }) {
+        if (stream->context) {
+            avcodec_close(stream->context);
+            avcodec_free_context(&stream->context);
+        }
 
-    while (!video_packets.empty()) {
-        AVPacket *packet = video_packets.front();
-        av_packet_free(&packet);
-        video_packets.pop();
+        while (!stream->packets.empty()) {
+            AVPacket *packet = stream->packets.front();
+            av_packet_free(&packet);
+            stream->packets.pop();
+        }
+
+        av_frame_unref(stream->frame);
+        stream->frame_pending = false;
+        stream->ended = false;
+        stream->stream_id = -1;
     }
 
-    while (!audio_packets.empty()) {
-        AVPacket *packet = audio_packets.front();
-        av_packet_free(&packet);
-        audio_packets.pop();
+    if (format) {
+        avformat_close_input(&format);
     }
 
+    const std::lock_guard<std::mutex> lock(mutex);
     video_playing = "";
+    size = {};
+    audio_format = {};
 }
 
 void PlayerState::switch_video(const std::string &path) {
-    free_video();
-    video_playing = path;
+    close_video();
 
     int error;
 
@@ -88,98 +201,121 @@ void PlayerState::switch_video(const std::string &path) {
     error = avformat_find_stream_info(format, nullptr);
     assert(error >= 0);
 
-    video_stream_id = av_find_best_stream(format, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
-    audio_stream_id = av_find_best_stream(format, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0);
+    video.stream_id = av_find_best_stream(format, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+    audio.stream_id = av_find_best_stream(format, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0);
+
+    for (StreamDecoder *stream : { &video, &audio }) {
+        if (stream->stream_id < 0)
+            continue;
+
+        AVStream *av_stream = format->streams[stream->stream_id];
+        AVCodec *codec = avcodec_find_decoder(av_stream->codecpar->codec_id);
+        stream->context = avcodec_alloc_context3(codec);
+        avcodec_parameters_to_context(stream->context, av_stream->codecpar);
+        avcodec_open2(stream->context, codec, nullptr);
+    }
+
+    const std::lock_guard<std::mutex> lock(mutex);
+    video_playing = path;
 
-    if (video_stream_id >= 0) {
-        AVStream *video_stream = format->streams[video_stream_id];
-        AVCodec *video_codec = avcodec_find_decoder(video_stream->codecpar->codec_id);
-        video_context = avcodec_alloc_context3(video_codec);
-        avcodec_parameters_to_context(video_context, video_stream->codecpar);
-        avcodec_open2(video_context, video_codec, nullptr);
+    if (video.context) {
+        size = { static_cast<uint32_t>(video.context->width), static_cast<uint32_t>(video.context->height) };
     }
 
-    if (audio_stream_id >= 0) {
-        AVStream *audio_stream = format->streams[audio_stream_id];
-        AVCodec *audio_codec = avcodec_find_decoder(audio_stream->codecpar->codec_id);
-        audio_context = avcodec_alloc_context3(audio_codec);
-        avcodec_parameters_to_context(audio_context, audio_stream->codecpar);
-        avcodec_open2(audio_context, audio_codec, nullptr);
+    if (audio.context) {
+        audio_format.channels = audio.context->channels;
+        audio_format.sample_rate = audio.context->sample_rate;
+        audio_format.sample_count = audio.context->frame_size;
+        audio_format.size = audio_format.channels * audio_format.sample_count * sizeof(int16_t);
     }
 }
 
-bool PlayerState::next_packet(int32_t stream_id) {
-    std::queue<AVPacket *> &this_queue = stream_id == video_stream_id ? video_packets : audio_packets;
-    std::queue<AVPacket *> &other_queue = stream_id != video_stream_id ? video_packets : audio_packets;
-
+bool PlayerState::next_packet(StreamDecoder &stream, StreamDecoder &other) {
     while (true) {
-        if (!this_queue.empty()) {
-            AVPacket *this_packet = this_queue.front();
-            this_queue.pop();
+        if (!stream.packets.empty()) {
+            AVPacket *this_packet = stream.packets.front();
+            stream.packets.pop();
 
-            if (stream_id == video_stream_id) {
-                int err = avcodec_send_packet(video_context, this_packet);
-                assert(err == 0);
-            }
-
-            if (stream_id == audio_stream_id) {
-                int err = avcodec_send_packet(audio_context, this_packet);
-                assert(err == 0);
-            }
+            int err = avcodec_send_packet(stream.context, this_packet);
+            assert(err == 0);
 
             av_packet_free(&this_packet);
             return true;
         }
 
         AVPacket *packet = av_packet_alloc();
-        if (av_read_frame(format, packet) != 0)
+        if (av_read_frame(format, packet) != 0) {
+            av_packet_free(&packet);
             return false;
+        }
 
-        if (packet->stream_index == stream_id) {
-            this_queue.push(packet);
+        if (packet->stream_index == stream.stream_id) {
+            stream.packets.push(packet);
+        } else if (other.context && (packet->stream_index == other.stream_id)) {
+            other.packets.push(packet);
         } else {
-            other_queue.push(packet);
+            av_packet_free(&packet);
         }
     }
 }
 
-std::vector<int16_t> PlayerState::receive_audio() {
-    if (audio_stream_id < 0)
-        return {};
+void PlayerState::decode(PlayerMediaType type) {
+    StreamDecoder &stream = get_decoder(type);
+    StreamDecoder &other = get_decoder(type == PlayerMediaType::VIDEO ? PlayerMediaType::AUDIO : PlayerMediaType::VIDEO);
+    AVFrame *frame = stream.frame;
+
+    while (!stream.frame_pending) {
+        const int error = avcodec_receive_frame(stream.context, frame);
+        if (error == 0) {
+            stream.frame_pending = true;
+        } else if ((error != AVERROR(EAGAIN)) || !next_packet(stream, other)) {
+            stream.ended = true;
+            return;
+        }
+    }
 
-    if (video_playing.empty())
-        return {};
+    uint32_t frame_size;
+    if (type == PlayerMediaType::VIDEO) {
+        frame_size = H264DecoderState::buffer_size({ static_cast<uint32_t>(frame->width), static_cast<uint32_t>(frame->height) });
+    } else {
+        frame_size = frame->nb_samples * frame->channels * sizeof(int16_t);
+    }
 
-    int error;
-    AVFrame *frame = av_frame_alloc();
-    std::vector<int16_t> data;
-    while (true) {
-        error = avcodec_receive_frame(audio_context, frame);
+    uint32_t index;
+    uint8_t *dest;
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        FrameQueue &queue = get_queue(type);
+        if (queue.buffers.empty() || (queue.buffer_size < frame_size)) {
+            // Keep the frame until bigger buffers come
+            queue.required_size = frame_size;
+            return;
+        }
+        index = queue.written % queue.buffers.size();
+        dest = queue.buffers[index];
+    }
 
-        if (error == AVERROR(EAGAIN) && next_packet(audio_stream_id))
-            continue;
+    PlayerFrame info;
+    info.buffer_index = index;
+    info.size = frame_size;
+    info.timestamp = frame->best_effort_timestamp;
 
-        if (error != 0) {
-            if (videos_queue.empty()) {
-                // Stop playing videos or
-                video_playing = "";
-                break;
-            } else {
-                // Play the next video (if there is any).
-                switch_video(videos_queue.front());
-                videos_queue.pop();
-                continue;
-            }
-        }
+    if (type == PlayerMediaType::VIDEO) {
+        info.width = frame->width;
+        info.height = frame->height;
+        const AVRational rational = format->streams[stream.stream_id]->avg_frame_rate;
+        info.duration_microseconds = rational.num ? static_cast<float>(rational.den) / static_cast<float>(rational.num) * 1000000 : 0;
 
+        // The guest draws AvPlayer frames as YUV420P2 textures
+        copy_yuv_data_from_frame(frame, dest, true);
+    } else {
         LOG_WARN_IF(frame->format != AV_SAMPLE_FMT_FLTP, "Unknown audio format {}.", frame->format);
 
-        last_channels = frame->channels;
-        last_sample_count = frame->nb_samples;
-        last_sample_rate = frame->sample_rate;
-
-        data.resize(frame->nb_samples * frame->channels);
+        info.channels = frame->channels;
+        info.sample_count = frame->nb_samples;
+        info.sample_rate = frame->sample_rate;
 
+        int16_t *data = reinterpret_cast<int16_t *>(dest);
         for (int a = 0; a < frame->nb_samples; a++) {
             for (int b = 0; b < frame->channels; b++) {
                 auto *frame_data = reinterpret_cast<float *>(frame->data[b]);
@@ -189,71 +325,57 @@ std::vector<int16_t> PlayerState::receive_audio() {
                 data[a * frame->channels + b] = pcm_sample;
             }
         }
-
-        break;
     }
 
-    av_frame_free(&frame);
-    return data;
+    av_frame_unref(frame);
+    stream.frame_pending = false;
+
+    const std::lock_guard<std::mutex> lock(mutex);
+    FrameQueue &queue = get_queue(type);
+    queue.frames[index] = info;
+    queue.written++;
 }
 
-std::vector<uint8_t> PlayerState::receive_video() {
-    if (video_stream_id < 0)
-        return {};
+bool PlayerState::can_decode() const {
+    if (video_playing.empty() || busy)
+        return false;
 
-    if (video_playing.empty())
-        return {};
+    return (video.context && !video.ended && video_frames.has_room()) || (audio.context && !audio.ended && audio_frames.has_room());
+}
 
-    int error;
-    AVFrame *frame = av_frame_alloc();
-    std::vector<uint8_t> data;
+void PlayerState::decode_loop() {
+    std::unique_lock<std::mutex> lock(mutex);
     while (true) {
-        error = avcodec_receive_frame(video_context, frame);
-
-        if (error == AVERROR(EAGAIN) && next_packet(video_stream_id))
-            continue;
-
-        if (error != 0) {
-            if (videos_queue.empty()) {
-                // Stop playing videos or
-                video_playing = "";
-                break;
-            } else {
+        cond.wait(lock, [&] { return quit || can_decode(); });
+        if (quit)
+            break;
+
+        // Audio frames are cheap and running out of them is audible, keep them filled first
+        const PlayerMediaType type = (audio.context && !audio.ended && audio_frames.has_room()) ? PlayerMediaType::AUDIO : PlayerMediaType::VIDEO;
+
+        busy = true;
+        lock.unlock();
+        decode(type);
+
+        // The video stream sets the end of a video, or the audio one if there is no video
+        const StreamDecoder &main = video.context ? video : audio;
+        if (main.ended) {
+            lock.lock();
+            std::string next;
+            if (!videos_queue.empty()) {
                 // Play the next video (if there is any).
-                switch_video(videos_queue.front());
+                next = videos_queue.front();
                 videos_queue.pop();
-                continue;
             }
-        }
+            lock.unlock();
 
-        last_timestamp = frame->best_effort_timestamp;
-
-        data.resize(H264DecoderState::buffer_size(
-            { static_cast<uint32_t>(video_context->width), static_cast<uint32_t>(video_context->height) }));
-        copy_yuv_data_from_frame(frame, data.data());
-
-        break;
-    }
-
-    av_frame_free(&frame);
-    return data;
-}
+            if (next.empty())
+                close_video();
+            else
+                switch_video(next);
+        }
 
-void PlayerState::queue(const std::string &path) {
-    if (fs::exists(path)) {
-        LOG_INFO("Queued video: '{}'.", path);
-        if (video_playing.empty())
-            switch_video(path);
-        else
-            videos_queue.push(path);
-    } else {
-        LOG_INFO("Cannot find video: {}", path);
+        lock.lock();
+        release_decoders();
     }
 }
-
-PlayerState::~PlayerState() {
-    free_video();
-
-    video_playing = "";
-    videos_queue = {};
-}
@@ -115,6 +115,14 @@ enum PerfomanceOverleyPosition {
     code(bool, "video-playing", true, video_playing)                                                    \
     code(bool, "shader-cache", true, shader_cache)                                                      \
     code(bool, "spirv-shader", false, spirv_shader)                                                     \
+    code(int, "resolution-multiplier", 1, resolution_multiplier)                                        \
+    code(bool, "vblank-spin-wait", true, vblank_spin_wait)                                              \
+    code(bool, "guest-thread-scheduler", false, guest_thread_scheduler)                                 \
+    code(bool, "guest-profiler", false, guest_profiler)                                                 \
+    code(bool, "native-libc-functions", true, native_libc_functions)                                    \
+    code(int, "audio-buffer-size", 512, audio_buffer_size)                                              \
+    code(int, "video-decoder-threads", 0, video_decoder_threads)                                        \
+    code(bool, "video-decoder-frame-threading", false, video_decoder_frame_threading)                   \
     code(uint64_t, "current-ime-lang", 4, current_ime_lang)                                             \
     code(bool, "disable-at9-decoder", false, disable_at9_decoder)
 
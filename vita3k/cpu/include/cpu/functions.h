@@ -30,6 +30,8 @@ CPUStatePtr init_cpu(CPUBackend backend, bool cpu_opt, SceUID thread_id, std::si
 int run(CPUState &state);
 int step(CPUState &state);
 void stop(CPUState &state);
+// Thread safe, see CPUInterface::interrupt
+void interrupt(CPUState &state);
 void set_thread_id(CPUState &state, SceUID thread_id);
 SceUID get_thread_id(CPUState &state);
 uint32_t read_reg(CPUState &state, size_t index);
@@ -50,6 +52,14 @@ void load_context(CPUState &state, CPUContext ctx);
 std::size_t get_processor_id(CPUState &state);
 void invalidate_jit_cache(CPUState &state, Address start, size_t length);
 
+// Jit instances of exited threads, kept for reuse by new threads
+void invalidate_pooled_jit_cache(Address start, size_t length);
+void clear_jit_pool();
+
+// Instructions run by the interpreter because the jit can't translate them
+void log_interpreter_fallback_report();
+void reset_interpreter_fallback_stats();
+
 uint32_t read_fpscr(CPUState &state);
 void write_fpscr(CPUState &state, uint32_t value);
 uint32_t read_cpsr(CPUState &state);
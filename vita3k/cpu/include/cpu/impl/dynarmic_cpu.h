@@ -30,11 +30,12 @@
 
 class ArmDynarmicCallback;
 class ArmDynarmicCP15;
+struct InterpreterFallbackStats;
 
 class DynarmicCPU : public CPUInterface {
     friend class ArmDynarmicCallback;
 
-    UnicornCPU fallback;
+    std::unique_ptr<UnicornCPU> fallback; // Created on first use
     CPUState *parent;
 
     std::unique_ptr<Dynarmic::A32::Jit> jit;
@@ -54,13 +55,19 @@ class DynarmicCPU : public CPUInterface {
     bool log_code = false;
     bool cpu_opt;
 
+    std::unique_ptr<InterpreterFallbackStats> fallback_stats;
+
     std::unique_ptr<Dynarmic::A32::Jit> make_jit();
+    bool take_pooled_jit();
+    void release_jit_to_pool();
+    UnicornCPU &get_fallback();
 
 public:
     DynarmicCPU(CPUState *state, std::size_t processor_id, Dynarmic::ExclusiveMonitor *monitor, bool cpu_opt);
     ~DynarmicCPU() override;
     int run() override;
     void stop() override;
+    void interrupt() override;
 
     uint32_t get_reg(uint8_t idx) override;
     void set_reg(uint8_t idx, uint32_t val) override;
@@ -28,6 +28,10 @@ struct CPUInterface {
 
     virtual int run() = 0;
     virtual void stop() = 0;
+    // Can be called from another host thread. Makes a run in progress return 0 soon, with a context it can resume from.
+    virtual void interrupt() {
+        stop();
+    }
 
     virtual uint32_t get_reg(uint8_t idx) = 0;
     virtual void set_reg(uint8_t idx, uint32_t val) = 0;
@@ -93,6 +93,10 @@ void stop(CPUState &state) {
     state.cpu->stop();
 }
 
+void interrupt(CPUState &state) {
+    state.cpu->interrupt();
+}
+
 uint32_t read_reg(CPUState &state, size_t index) {
     return state.cpu->get_reg(index);
 }
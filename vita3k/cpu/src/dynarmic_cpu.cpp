@@ -19,9 +19,14 @@
 #include <cpu/impl/dynarmic_cpu.h>
 #include <cpu/impl/interface.h>
 #include <cpu/state.h>
+#include <algorithm>
+#include <deque>
+#include <mutex>
 #include <set>
+#include <unordered_map>
 #include <util/log.h>
 
+#include <mem/functions.h>
 #include <mem/ptr.h>
 
 #include <dynarmic/frontend/A32/a32_ir_emitter.h>
@@ -85,6 +90,98 @@ public:
     }
 };
 
+// Instructions dynarmic can't translate are run by unicorn, which costs a full context round trip each time.
+// Count them per address so that the ones hit in hot loops can be found and given a proper implementation.
+struct InterpreterFallbackSite {
+    std::string disassembly;
+    uint64_t hits = 0;
+    uint64_t next_report = 1024;
+};
+
+typedef std::unordered_map<Address, InterpreterFallbackSite> InterpreterFallbackSites;
+
+// Each CPU counts its own fallbacks, the lock is only ever contended while a report is built
+struct InterpreterFallbackStats {
+    std::mutex mutex;
+    InterpreterFallbackSites sites;
+};
+
+// Live CPUs, the counts of the ones already destroyed and the addresses already warned about by any CPU
+static std::mutex fallback_registry_mutex;
+static std::set<InterpreterFallbackStats *> fallback_registry;
+static InterpreterFallbackSites retired_fallback_sites;
+static std::set<Address> warned_fallback_sites;
+
+static void merge_fallback_sites(InterpreterFallbackSites &dest, const InterpreterFallbackSites &src) {
+    for (const auto &[addr, site] : src) {
+        InterpreterFallbackSite &merged = dest[addr];
+        merged.hits += site.hits;
+        if (merged.disassembly.empty())
+            merged.disassembly = site.disassembly;
+    }
+}
+
+static void record_interpreter_fallback(CPUState &state, InterpreterFallbackStats &stats, Address addr, size_t num_insts) {
+    bool first_hit = false;
+    std::string first_disassembly;
+    {
+        const std::lock_guard<std::mutex> guard(stats.mutex);
+        auto [site, inserted] = stats.sites.try_emplace(addr);
+        site->second.hits += num_insts;
+        if (inserted) {
+            site->second.disassembly = disassemble(state, addr & ~1, (addr & 1) != 0);
+            first_hit = true;
+            first_disassembly = site->second.disassembly;
+        } else if (site->second.hits >= site->second.next_report) {
+            // Hits grow by num_insts at a time, so report each power of two crossed rather than reached exactly
+            while (site->second.next_report <= site->second.hits)
+                site->second.next_report <<= 1;
+            LOG_WARN("Interpreter fallback at 0x{:X} ({}) hit {} times", addr & ~1, site->second.disassembly, site->second.hits);
+        }
+    }
+
+    // Each CPU sees its own first hit, warn once for all of them.
+    // The CPU lock is released first since the report takes the two the other way around.
+    if (first_hit) {
+        const std::lock_guard<std::mutex> registry_guard(fallback_registry_mutex);
+        if (warned_fallback_sites.insert(addr).second)
+            LOG_WARN("Interpreter fallback at 0x{:X} ({} instructions): {}", addr & ~1, num_insts, first_disassembly);
+    }
+}
+
+void log_interpreter_fallback_report() {
+    InterpreterFallbackSites merged;
+    {
+        const std::lock_guard<std::mutex> registry_guard(fallback_registry_mutex);
+        merged = retired_fallback_sites;
+        for (InterpreterFallbackStats *stats : fallback_registry) {
+            const std::lock_guard<std::mutex> guard(stats->mutex);
+            merge_fallback_sites(merged, stats->sites);
+        }
+    }
+    if (merged.empty())
+        return;
+
+    std::vector<std::pair<Address, InterpreterFallbackSite>> sites(merged.begin(), merged.end());
+    std::sort(sites.begin(), sites.end(), [](const auto &a, const auto &b) {
+        return a.second.hits > b.second.hits;
+    });
+
+    LOG_INFO("Interpreter fallback report, {} addresses:", sites.size());
+    for (const auto &[addr, site] : sites)
+        LOG_INFO("    0x{:X}: {} hits, {}", addr & ~1, site.hits, site.disassembly);
+}
+
+void reset_interpreter_fallback_stats() {
+    const std::lock_guard<std::mutex> registry_guard(fallback_registry_mutex);
+    retired_fallback_sites.clear();
+    warned_fallback_sites.clear();
+    for (InterpreterFallbackStats *stats : fallback_registry) {
+        const std::lock_guard<std::mutex> guard(stats->mutex);
+        stats->sites.clear();
+    }
+}
+
 class ArmDynarmicCallback : public Dynarmic::A32::UserCallbacks {
     friend class DynarmicCPU;
 
@@ -122,6 +219,16 @@ public:
         }
     }
 
+    // Only watched pages are flagged slow, so these are the only accesses reaching the callbacks besides invalid ones
+    void log_memory_access(const char *type, Dynarmic::A32::VAddr addr, size_t size, uint64_t value) {
+        const Address start = parent->protocol->get_watch_memory_addr(addr);
+        if (!start)
+            return;
+
+        LOG_TRACE("{} ({}): {} {} bytes, address {} + {} ({}, {}), value {} at {}", log_hex((uint64_t)this), parent->thread_id, type, size,
+            log_hex(start), log_hex(addr - start), log_hex(addr), mem_name(start, *parent->mem), log_hex(value), log_hex(cpu->get_pc()));
+    }
+
     template <typename T>
     T MemoryRead(Dynarmic::A32::VAddr addr) {
         Ptr<T> ptr{ addr };
@@ -132,7 +239,7 @@ public:
 
         T ret = *ptr.get(*parent->mem);
         if (cpu->log_mem) {
-            LOG_TRACE("Read uint{}_t at address: 0x{:x}, val = 0x{:x}", sizeof(T) * 8, addr, ret);
+            log_memory_access("Read", addr, sizeof(T), ret);
         }
         return ret;
     }
@@ -163,7 +270,7 @@ public:
 
         *ptr.get(*parent->mem) = value;
         if (cpu->log_mem) {
-            LOG_TRACE("Write uint{}_t at addr: 0x{:x}, val = 0x{:x}", sizeof(T) * 8, addr, value);
+            log_memory_access("Write", addr, sizeof(T), value);
         }
     }
 
@@ -203,11 +310,14 @@ public:
         if (cpu->is_thumb_mode())
             addr |= 1;
 
+        record_interpreter_fallback(*parent, *cpu->fallback_stats, addr, num_insts);
+
+        UnicornCPU &fallback = cpu->get_fallback();
         CPUContext context = cpu->save_context();
         context.set_pc(addr);
-        cpu->fallback.load_context(context);
-        cpu->fallback.execute_instructions_no_check(static_cast<int>(num_insts));
-        context = cpu->fallback.save_context();
+        fallback.load_context(context);
+        fallback.execute_instructions_no_check(static_cast<int>(num_insts));
+        context = fallback.save_context();
         context.cpsr = cpu->get_cpsr();
         context.fpscr = cpu->get_fpscr();
         cpu->load_context(context);
@@ -241,7 +351,7 @@ public:
         case Dynarmic::A32::Exception::UndefinedInstruction:
         case Dynarmic::A32::Exception::UnpredictableInstruction:
         case Dynarmic::A32::Exception::DecodeError: {
-            LOG_WARN("Undefined/Unpredictable instruction at addr 0x{:X}, inst 0x{:X} ({})", pc, MemoryReadCode(pc), disassemble(*parent, pc, nullptr));
+            // Logged once per address by the fallback statistics
             InterpreterFallback(pc, 1);
             break;
         }
@@ -265,15 +375,84 @@ public:
     }
 };
 
+// Jit instances outlive their thread in this pool, so that a later thread on the same core reuses the code
+// they already translated instead of translating it again. Each one goes with its callbacks and its CP15,
+// whose tpidruro address is baked in the translated code.
+struct PooledJit {
+    std::size_t core_id;
+    Dynarmic::ExclusiveMonitor *monitor;
+    bool cpu_opt;
+    std::unique_ptr<Dynarmic::A32::Jit> jit;
+    std::unique_ptr<ArmDynarmicCallback> cb;
+    std::shared_ptr<ArmDynarmicCP15> cp15;
+};
+
+static constexpr std::size_t MAX_POOLED_JITS = 16;
+
+static std::mutex jit_pool_mutex;
+static std::deque<PooledJit> jit_pool; // Most recently released last
+
+bool DynarmicCPU::take_pooled_jit() {
+    const std::lock_guard<std::mutex> guard(jit_pool_mutex);
+    for (auto it = jit_pool.rbegin(); it != jit_pool.rend(); ++it) {
+        if ((it->core_id != core_id) || (it->monitor != monitor) || (it->cpu_opt != cpu_opt))
+            continue;
+
+        jit = std::move(it->jit);
+        cb = std::move(it->cb);
+        cp15 = std::move(it->cp15);
+        jit_pool.erase(std::next(it).base());
+
+        cb->parent = parent;
+        cb->cpu = this;
+        return true;
+    }
+
+    return false;
+}
+
+void DynarmicCPU::release_jit_to_pool() {
+    // Logging jits are built with different callbacks, don't keep them around
+    if (!jit || log_code || log_mem)
+        return;
+
+    jit->Reset();
+    jit->ClearExclusiveState();
+    cp15->set_tpidruro(0);
+
+    const std::lock_guard<std::mutex> guard(jit_pool_mutex);
+    jit_pool.push_back({ core_id, monitor, cpu_opt, std::move(jit), std::move(cb), std::move(cp15) });
+    if (jit_pool.size() > MAX_POOLED_JITS)
+        jit_pool.pop_front();
+}
+
+void invalidate_pooled_jit_cache(Address start, size_t length) {
+    const std::lock_guard<std::mutex> guard(jit_pool_mutex);
+    for (auto &pooled : jit_pool)
+        pooled.jit->InvalidateCacheRange(start, length);
+}
+
+void clear_jit_pool() {
+    const std::lock_guard<std::mutex> guard(jit_pool_mutex);
+    jit_pool.clear();
+}
+
 std::unique_ptr<Dynarmic::A32::Jit> DynarmicCPU::make_jit() {
     Dynarmic::A32::UserConfig config;
     config.arch_version = Dynarmic::A32::ArchVersion::v7;
     config.callbacks = cb.get();
-    config.fastmem_pointer = (log_mem || !cpu_opt) ? nullptr : parent->mem->memory.get();
+    const bool fastmem = !log_mem && cpu_opt;
+    config.fastmem_pointer = fastmem ? parent->mem->memory.get() : nullptr;
     config.hook_hint_instructions = true;
     config.global_monitor = monitor;
+    // LDREX/STREX compare and swap directly on the fastmem mapping instead of going through the callbacks
+    // under the monitor lock, blocks whose exclusive accesses fault get recompiled to use the callbacks
+    config.fastmem_exclusive_access = fastmem;
+    config.recompile_on_exclusive_fastmem_failure = true;
     config.coprocessors[15] = cp15;
-    config.page_table = nullptr;
+    // Without fastmem, accesses still go straight to memory through the page table,
+    // only unmapped pages and watched ones (flagged slow) take the callbacks, where memory logging happens.
+    config.page_table = fastmem ? nullptr : get_host_page_table(*parent->mem);
     config.processor_id = core_id;
     config.optimizations = cpu_opt ? Dynarmic::all_safe_optimizations : Dynarmic::no_optimizations;
 
@@ -282,16 +461,38 @@ std::unique_ptr<Dynarmic::A32::Jit> DynarmicCPU::make_jit() {
 
 DynarmicCPU::DynarmicCPU(CPUState *state, std::size_t processor_id, Dynarmic::ExclusiveMonitor *monitor, bool cpu_opt)
     : parent(state)
-    , fallback(state)
-    , cb(std::make_unique<ArmDynarmicCallback>(*state, *this))
-    , cp15(std::make_shared<ArmDynarmicCP15>())
     , monitor(monitor)
     , cpu_opt(cpu_opt)
-    , core_id(processor_id) {
-    jit = make_jit();
+    , core_id(processor_id)
+    , fallback_stats(std::make_unique<InterpreterFallbackStats>()) {
+    {
+        const std::lock_guard<std::mutex> guard(fallback_registry_mutex);
+        fallback_registry.insert(fallback_stats.get());
+    }
+
+    if (!take_pooled_jit()) {
+        cb = std::make_unique<ArmDynarmicCallback>(*state, *this);
+        cp15 = std::make_shared<ArmDynarmicCP15>();
+        jit = make_jit();
+    }
+}
+
+UnicornCPU &DynarmicCPU::get_fallback() {
+    // Most threads never need it, and opening a unicorn instance is costly
+    if (!fallback) {
+        fallback = std::make_unique<UnicornCPU>(parent);
+        fallback->set_tpidruro(cp15->get_tpidruro());
+    }
+
+    return *fallback;
 }
 
 DynarmicCPU::~DynarmicCPU() {
+    release_jit_to_pool();
+
+    const std::lock_guard<std::mutex> guard(fallback_registry_mutex);
+    fallback_registry.erase(fallback_stats.get());
+    merge_fallback_sites(retired_fallback_sites, fallback_stats->sites);
 }
 
 int DynarmicCPU::run() {
@@ -344,6 +545,11 @@ void DynarmicCPU::stop() {
     exit_request = true;
 }
 
+void DynarmicCPU::interrupt() {
+    // Thread safe, the translated code checks for it between blocks. Neither break_ nor halted is set, so run returns 0.
+    jit->HaltExecution();
+}
+
 uint32_t DynarmicCPU::get_reg(uint8_t idx) {
     return jit->Regs()[idx];
 }
@@ -370,7 +576,8 @@ uint32_t DynarmicCPU::get_tpidruro() {
 
 void DynarmicCPU::set_tpidruro(uint32_t val) {
     cp15->set_tpidruro(val);
-    fallback.set_tpidruro(val);
+    if (fallback)
+        fallback->set_tpidruro(val);
 }
 
 void DynarmicCPU::set_pc(uint32_t val) {
@@ -354,18 +354,43 @@ bool UnicornCPU::is_thumb_mode() {
     return mode & UC_MODE_THUMB;
 }
 
+// Core registers then the VFP double registers, transferred in one batch each way.
+// The context keeps the float registers contiguous, so a pair of them is one double register.
+static constexpr size_t CONTEXT_CORE_REG_COUNT = 16;
+static constexpr size_t CONTEXT_DOUBLE_REG_COUNT = 32;
+static constexpr size_t CONTEXT_REG_COUNT = CONTEXT_CORE_REG_COUNT + CONTEXT_DOUBLE_REG_COUNT;
+
+static std::array<int, CONTEXT_REG_COUNT> context_reg_ids() {
+    std::array<int, CONTEXT_REG_COUNT> ids{};
+    for (size_t i = 0; i < 13; i++)
+        ids[i] = UC_ARM_REG_R0 + static_cast<int>(i);
+    ids[13] = UC_ARM_REG_SP;
+    ids[14] = UC_ARM_REG_LR;
+    ids[15] = UC_ARM_REG_PC;
+    for (size_t i = 0; i < CONTEXT_DOUBLE_REG_COUNT; i++)
+        ids[CONTEXT_CORE_REG_COUNT + i] = UC_ARM_REG_D0 + static_cast<int>(i);
+    return ids;
+}
+
+static std::array<void *, CONTEXT_REG_COUNT> context_reg_values(CPUContext &ctx) {
+    static_assert(sizeof(ctx.fpu_registers) == CONTEXT_DOUBLE_REG_COUNT * sizeof(DoubleReg));
+    std::array<void *, CONTEXT_REG_COUNT> values{};
+    for (size_t i = 0; i < CONTEXT_CORE_REG_COUNT; i++)
+        values[i] = &ctx.cpu_registers[i];
+    for (size_t i = 0; i < CONTEXT_DOUBLE_REG_COUNT; i++)
+        values[CONTEXT_CORE_REG_COUNT + i] = &ctx.fpu_registers[i * 2];
+    return values;
+}
+
 CPUContext UnicornCPU::save_context() {
+    static std::array<int, CONTEXT_REG_COUNT> ids = context_reg_ids();
+
     CPUContext ctx;
-    for (size_t i = 0; i < 13; i++) {
-        ctx.cpu_registers[i] = get_reg(i);
-    }
-    ctx.cpu_registers[13] = get_sp();
-    ctx.cpu_registers[14] = get_lr();
-    ctx.set_pc(is_thumb_mode() ? get_pc() | 1 : get_pc());
+    auto values = context_reg_values(ctx);
+    const uc_err err = uc_reg_read_batch(uc.get(), ids.data(), values.data(), static_cast<int>(CONTEXT_REG_COUNT));
+    assert(err == UC_ERR_OK);
 
-    for (size_t i = 0; i < ctx.fpu_registers.size(); i++) {
-        ctx.fpu_registers[i] = get_float_reg(i);
-    }
+    ctx.set_pc(is_thumb_mode() ? ctx.get_pc() | 1 : ctx.get_pc());
 
     // Unicorn doesn't like tweaking cpsr
     // ctx.cpsr = get_cpsr();
@@ -375,20 +400,18 @@ CPUContext UnicornCPU::save_context() {
 }
 
 void UnicornCPU::load_context(CPUContext ctx) {
-    for (size_t i = 0; i < ctx.fpu_registers.size(); i++) {
-        set_float_reg(i, ctx.fpu_registers[i]);
-    }
+    static std::array<int, CONTEXT_REG_COUNT> ids = context_reg_ids();
 
     // Unicorn doesn't like tweaking cpsr
     // set_cpsr(ctx.cpsr);
     // set_fpscr(ctx.fpscr);
 
-    for (size_t i = 0; i < 16; i++) {
-        set_reg(i, ctx.cpu_registers[i]);
-    }
-    set_sp(ctx.get_sp());
-    set_lr(ctx.get_lr());
-    set_pc(ctx.thumb() ? ctx.get_pc() | 1 : ctx.get_pc());
+    // Writing pc with the low bit set is what switches unicorn to thumb
+    if (ctx.thumb())
+        ctx.cpu_registers[15] |= 1;
+    auto values = context_reg_values(ctx);
+    const uc_err err = uc_reg_write_batch(uc.get(), ids.data(), values.data(), static_cast<int>(CONTEXT_REG_COUNT));
+    assert(err == UC_ERR_OK);
 }
 
 bool UnicornCPU::hit_breakpoint() {
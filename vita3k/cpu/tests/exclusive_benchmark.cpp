@@ -0,0 +1,55 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include "exclusive_harness.h"
+
+#include <cstdio>
+
+// Throughput of guest LDREX/STREX increments as the thread count grows. Not run by ctest.
+static constexpr uint32_t INCREMENTS_PER_THREAD = 100000;
+
+static bool report(exclusive::Harness &harness, const char *name, bool cpu_opt, size_t thread_count, size_t counter_count) {
+    const exclusive::Result result = harness.run(thread_count, cpu_opt, counter_count, INCREMENTS_PER_THREAD);
+    const uint64_t expected = uint64_t(INCREMENTS_PER_THREAD) * thread_count;
+    if (!result.ok || result.total != expected) {
+        std::printf("%s, cpu_opt %s, %zu threads: FAILED (%llu of %llu increments)\n", name, cpu_opt ? "on" : "off",
+            thread_count, static_cast<unsigned long long>(result.total), static_cast<unsigned long long>(expected));
+        return false;
+    }
+
+    const double mops = expected / result.elapsed.count() / 1e6;
+    std::printf("%s, cpu_opt %s, %zu threads: %.2f M increments/s\n", name, cpu_opt ? "on" : "off", thread_count, mops);
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    exclusive::Harness harness;
+    if (!harness.init()) {
+        std::printf("Failed to initialise guest memory\n");
+        return 1;
+    }
+
+    bool ok = true;
+    for (const bool cpu_opt : { true, false }) {
+        for (size_t thread_count = 1; thread_count <= exclusive::MAX_THREADS; thread_count *= 2) {
+            ok &= report(harness, "shared counter", cpu_opt, thread_count, 1);
+            ok &= report(harness, "counter per granule", cpu_opt, thread_count, thread_count);
+        }
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,149 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <cpu/common.h>
+#include <cpu/functions.h>
+#include <cpu/state.h>
+#include <mem/functions.h>
+#include <mem/ptr.h>
+#include <mem/state.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Guest threads incrementing counters with LDREX/STREX loops, run by the JIT with and without
+// optimizations (fastmem exclusive accesses on one side, page table and callbacks on the other).
+// Shared by the exclusive access tests and the throughput benchmark.
+namespace exclusive {
+
+static constexpr size_t MAX_THREADS = 8;
+static constexpr size_t RESERVATION_GRANULE = 8;
+
+// r0: counter address, r1: increments, returns to lr
+static constexpr uint32_t INCREMENT_CODE[] = {
+    0xE1902F9F, // retry: LDREX r2, [r0]
+    0xE2822001, // ADD r2, r2, #1
+    0xE1803F92, // STREX r3, r2, [r0]
+    0xE3530000, // CMP r3, #0
+    0x1AFFFFFA, // BNE retry
+    0xE2511001, // SUBS r1, r1, #1
+    0x1AFFFFF8, // BNE retry
+    0xE12FFF1E, // BX lr
+};
+
+struct Protocol : CPUProtocolBase {
+    ExclusiveMonitorPtr monitor;
+    bool unexpected_svc = false;
+
+    explicit Protocol(ExclusiveMonitorPtr monitor)
+        : monitor(monitor) {
+    }
+
+    void call_svc(CPUState &cpu, uint32_t svc, Address pc, SceUID thread_id) override {
+        unexpected_svc = true;
+        stop(cpu);
+    }
+
+    Address get_watch_memory_addr(Address addr) override {
+        return 0;
+    }
+
+    ExclusiveMonitorPtr get_exlusive_monitor() override {
+        return monitor;
+    }
+};
+
+struct Result {
+    bool ok = false;
+    uint64_t total = 0;
+    std::chrono::duration<double> elapsed{};
+};
+
+class Harness {
+public:
+    bool init() {
+        if (!::init(mem))
+            return false;
+        monitor = new_exclusive_monitor(MAX_THREADS);
+        protocol = std::make_unique<Protocol>(monitor);
+
+        code = alloc_block(mem, sizeof(INCREMENT_CODE), "exclusive test code");
+        std::copy(std::begin(INCREMENT_CODE), std::end(INCREMENT_CODE), code.get_ptr<uint32_t>().get(mem));
+        counters = alloc_block(mem, MAX_THREADS * RESERVATION_GRANULE, "exclusive test counters");
+        return true;
+    }
+
+    ~Harness() {
+        if (!monitor)
+            return;
+        // Pooled jits keep a pointer to the monitor
+        clear_jit_pool();
+        free_exclusive_monitor(monitor);
+    }
+
+    // Runs thread_count guest threads, thread i incrementing counter i % counter_count, and sums the counters.
+    // Only the guest code running is timed.
+    Result run(size_t thread_count, bool cpu_opt, size_t counter_count, uint32_t increments) {
+        Result result;
+        for (size_t i = 0; i < MAX_THREADS; ++i)
+            counter(i) = 0;
+
+        std::vector<CPUStatePtr> cpus;
+        for (size_t i = 0; i < thread_count; ++i) {
+            CPUStatePtr cpu = init_cpu(CPUBackend::Dynarmic, cpu_opt, static_cast<SceUID>(i + 1), i, mem, protocol.get());
+            if (!cpu)
+                return result;
+
+            write_reg(*cpu, 0, counters.get() + static_cast<Address>((i % counter_count) * RESERVATION_GRANULE));
+            write_reg(*cpu, 1, increments);
+            write_lr(*cpu, cpu->halt_instruction_pc);
+            write_pc(*cpu, code.get());
+            cpus.push_back(std::move(cpu));
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for (CPUStatePtr &cpu : cpus)
+            threads.emplace_back([&cpu]() { ::run(*cpu); });
+        for (std::thread &thread : threads)
+            thread.join();
+        result.elapsed = std::chrono::steady_clock::now() - start;
+
+        for (size_t i = 0; i < counter_count; ++i)
+            result.total += counter(i);
+        result.ok = !protocol->unexpected_svc;
+        return result;
+    }
+
+private:
+    uint32_t &counter(size_t index) {
+        return counters.get_ptr<uint32_t>().get(mem)[index * RESERVATION_GRANULE / sizeof(uint32_t)];
+    }
+
+    MemState mem;
+    ExclusiveMonitorPtr monitor = nullptr;
+    std::unique_ptr<Protocol> protocol;
+    Block code;
+    Block counters;
+};
+
+} // namespace exclusive
@@ -0,0 +1,55 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include "exclusive_harness.h"
+
+#include <gtest/gtest.h>
+
+static constexpr uint32_t INCREMENTS_PER_THREAD = 20000;
+static constexpr size_t THREAD_COUNT = 4;
+
+class exclusive_access : public testing::Test {
+protected:
+    void SetUp() override {
+        ASSERT_TRUE(harness.init());
+    }
+
+    // Runs THREAD_COUNT guest threads, thread i incrementing counter i % counter_count. Returns the sum of the counters.
+    uint64_t run_increments(bool cpu_opt, size_t counter_count) {
+        const exclusive::Result result = harness.run(THREAD_COUNT, cpu_opt, counter_count, INCREMENTS_PER_THREAD);
+        EXPECT_TRUE(result.ok) << "Failed to create the CPUs or unexpected SVC";
+        return result.total;
+    }
+
+    exclusive::Harness harness;
+};
+
+TEST_F(exclusive_access, shared_counter_optimized) {
+    EXPECT_EQ(run_increments(true, 1), uint64_t(INCREMENTS_PER_THREAD) * THREAD_COUNT);
+}
+
+TEST_F(exclusive_access, shared_counter_unoptimized) {
+    EXPECT_EQ(run_increments(false, 1), uint64_t(INCREMENTS_PER_THREAD) * THREAD_COUNT);
+}
+
+TEST_F(exclusive_access, counter_per_granule_optimized) {
+    EXPECT_EQ(run_increments(true, THREAD_COUNT), uint64_t(INCREMENTS_PER_THREAD) * THREAD_COUNT);
+}
+
+TEST_F(exclusive_access, counter_per_granule_unoptimized) {
+    EXPECT_EQ(run_increments(false, THREAD_COUNT), uint64_t(INCREMENTS_PER_THREAD) * THREAD_COUNT);
+}
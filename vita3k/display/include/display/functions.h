@@ -19,8 +19,12 @@
 
 #include <cstdint>
 #include <util/types.h>
+#include <vector>
 
 struct DisplayState;
 struct KernelState;
 
 void wait_vblank(DisplayState &display, KernelState &kernel, const SceUID thread_id, const int count, const bool since_last_setbuf);
+
+// Steady clock timestamps in microseconds of the last vblanks, oldest first, for frame pacing telemetry
+std::vector<std::uint64_t> get_vblank_timestamps(DisplayState &display, const std::size_t count);
@@ -17,10 +17,13 @@
 
 #pragma once
 
+#include <array>
 #include <atomic>
+#include <functional>
 #include <mem/ptr.h>
 #include <memory>
 #include <mutex>
+#include <queue>
 #include <thread>
 #include <vector>
 
@@ -35,9 +38,18 @@ typedef std::shared_ptr<ThreadState> ThreadStatePtr;
 
 struct DisplayStateVBlankWaitInfo {
     ThreadStatePtr target_thread;
-    std::int32_t vsync_left;
+    std::uint64_t target_vcount;
+
+    bool operator>(const DisplayStateVBlankWaitInfo &rhs) const {
+        return target_vcount > rhs.target_vcount;
+    }
 };
 
+// Waiter with the earliest target vblank on top
+typedef std::priority_queue<DisplayStateVBlankWaitInfo, std::vector<DisplayStateVBlankWaitInfo>, std::greater<DisplayStateVBlankWaitInfo>> DisplayStateVBlankWaitQueue;
+
+static constexpr std::size_t VBLANK_TIMESTAMP_HISTORY_SIZE = 128;
+
 struct DisplayState {
     Ptr<const void> base;
     uint32_t pitch = 0;
@@ -49,7 +61,12 @@ struct DisplayState {
     std::atomic<bool> abort{ false };
     std::atomic<bool> imgui_render{ true };
     std::atomic<bool> fullscreen{ false };
+    std::atomic<bool> vblank_spin_wait{ true };
     std::atomic<std::uint64_t> vblank_count{ 0 };
-    std::vector<DisplayStateVBlankWaitInfo> vblank_wait_infos;
+    DisplayStateVBlankWaitQueue vblank_wait_infos;
     std::uint64_t last_setframe_vblank_count = 0;
+
+    // Steady clock time in microseconds of the most recent vblanks, indexed by vblank count modulo the history size.
+    // Protected by mutex.
+    std::array<std::uint64_t, VBLANK_TIMESTAMP_HISTORY_SIZE> vblank_timestamps{};
 };
@@ -15,34 +15,76 @@
 // with this program; if not, write to the Free Software Foundation, Inc.,
 // 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 
+#include <display/functions.h>
 #include <display/state.h>
 #include <kernel/state.h>
 
+#include <algorithm>
 #include <chrono>
 #include <util/find.h>
 
 // Code heavily influenced by PPSSSPP's SceDisplay.cpp
 
-static constexpr int TARGET_FPS = 60;
-static constexpr int TARGET_MS_PER_FRAME = 1000 / TARGET_FPS;
+// The Vita refreshes at 60000/1001 Hz. Deadlines are computed from the vblank index and the clock start
+// so that sleep overshoot never accumulates into drift.
+static constexpr std::int64_t VBLANK_PERIOD_NUM_NS = 1001 * 1'000'000'000LL;
+static constexpr std::int64_t VBLANK_PERIOD_DEN = 60000;
+
+// How long before the deadline the sleep ends, the rest being spent spinning when spin wait is enabled
+static constexpr auto VBLANK_SPIN_THRESHOLD = std::chrono::microseconds(500);
+
+static std::chrono::steady_clock::duration vblank_deadline_offset(const std::uint64_t vblank_index) {
+    // Whole multiples of the denominator first, the full product would overflow after a couple of days
+    const std::int64_t whole = static_cast<std::int64_t>(vblank_index / VBLANK_PERIOD_DEN) * VBLANK_PERIOD_NUM_NS;
+    const std::int64_t remainder = static_cast<std::int64_t>(vblank_index % VBLANK_PERIOD_DEN) * VBLANK_PERIOD_NUM_NS / VBLANK_PERIOD_DEN;
+    return std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(whole + remainder));
+}
+
+static void wait_until_deadline(const DisplayState &display, const std::chrono::steady_clock::time_point deadline) {
+    if (!display.vblank_spin_wait) {
+        std::this_thread::sleep_until(deadline);
+        return;
+    }
+
+    std::this_thread::sleep_until(deadline - VBLANK_SPIN_THRESHOLD);
+    while (std::chrono::steady_clock::now() < deadline)
+        std::this_thread::yield();
+}
 
 static void vblank_sync_thread(DisplayState &display) {
+    const auto clock_start = std::chrono::steady_clock::now();
+    std::uint64_t vblank_index = 0;
+
     while (!display.abort.load()) {
         {
             const std::lock_guard<std::mutex> guard(display.mutex);
-            for (std::size_t i = 0; i < display.vblank_wait_infos.size(); i++) {
-                if (--display.vblank_wait_infos[i].vsync_left == 0) {
-                    ThreadStatePtr target_wait = display.vblank_wait_infos[i].target_thread;
+            const std::uint64_t vcount = ++display.vblank_count;
+
+            const auto now = std::chrono::steady_clock::now();
+            display.vblank_timestamps[vcount % VBLANK_TIMESTAMP_HISTORY_SIZE] = std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count();
+
+            while (!display.vblank_wait_infos.empty() && display.vblank_wait_infos.top().target_vcount <= vcount) {
+                const ThreadStatePtr target_wait = display.vblank_wait_infos.top().target_thread;
+                display.vblank_wait_infos.pop();
 
-                    target_wait->resume();
-                    target_wait->status_cond.notify_all();
+                target_wait->resume();
+                target_wait->status_cond.notify_all();
+            }
+        }
+
+        vblank_index++;
+        auto deadline = clock_start + vblank_deadline_offset(vblank_index);
 
-                    display.vblank_wait_infos.erase(display.vblank_wait_infos.begin() + i--);
-                }
+        // After a long stall (debugger, host suspend), skip the missed vblanks rather than firing them back to back
+        const auto now = std::chrono::steady_clock::now();
+        if (now > deadline + vblank_deadline_offset(1)) {
+            while (deadline <= now) {
+                vblank_index++;
+                deadline = clock_start + vblank_deadline_offset(vblank_index);
             }
-            display.vblank_count++;
         }
-        std::this_thread::sleep_for(std::chrono::milliseconds(TARGET_MS_PER_FRAME));
+
+        wait_until_deadline(display, deadline);
     }
 }
 
@@ -58,15 +100,12 @@ void wait_vblank(DisplayState &display, KernelState &kernel, const SceUID thread
 
     {
         const std::lock_guard<std::mutex> guard(display.mutex);
-        if (since_last_setbuf) {
-            const std::size_t blank_passed = display.vblank_count - display.last_setframe_vblank_count;
-            if (blank_passed >= count) {
-                return;
-            } else {
-                count -= static_cast<int>(blank_passed);
-            }
-        }
-        display.vblank_wait_infos.push_back({ wait_thread, count });
+        const std::uint64_t base_vcount = since_last_setbuf ? display.last_setframe_vblank_count : display.vblank_count.load();
+        const std::uint64_t target_vcount = base_vcount + count;
+        if (target_vcount <= display.vblank_count)
+            return;
+
+        display.vblank_wait_infos.push({ wait_thread, target_vcount });
     }
 
     auto thread_lock = std::unique_lock(wait_thread->mutex);
@@ -75,3 +114,16 @@ void wait_vblank(DisplayState &display, KernelState &kernel, const SceUID thread
     wait_thread->suspend();
     wait_thread->status_cond.wait(thread_lock, [=]() { return wait_thread->status != ThreadStatus::suspend; });
 }
+
+std::vector<std::uint64_t> get_vblank_timestamps(DisplayState &display, const std::size_t count) {
+    const std::lock_guard<std::mutex> guard(display.mutex);
+    const std::uint64_t vcount = display.vblank_count;
+    const std::size_t available = static_cast<std::size_t>(std::min<std::uint64_t>({ vcount, count, VBLANK_TIMESTAMP_HISTORY_SIZE }));
+
+    std::vector<std::uint64_t> timestamps;
+    timestamps.reserve(available);
+    for (std::uint64_t i = vcount + 1 - available; i <= vcount; i++)
+        timestamps.push_back(display.vblank_timestamps[i % VBLANK_TIMESTAMP_HISTORY_SIZE]);
+
+    return timestamps;
+}
@@ -293,6 +293,9 @@ struct GuiState {
     std::string disassembly_arch = "THUMB";
     char disassembly_address[9] = "00000000";
     char disassembly_count[5] = "100";
+
+    char watch_memory_address[9] = "00000000";
+    char watch_memory_size[9] = "4";
     std::vector<std::string> disassembly;
 
     bool is_capturing_keys = false;
@@ -34,6 +34,7 @@
 #include <util/string_utils.h>
 
 #include <algorithm>
+#include <cstdlib>
 #include <nfd.h>
 #include <pugixml.hpp>
 #include <sstream>
@@ -381,6 +382,9 @@ void draw_settings_dialog(GuiState &gui, HostState &host) {
                                   "and not all GPU are compatible with this.");
             }
         }
+        ImGui::SliderInt("Resolution Multiplier (Reboot for apply)", &host.cfg.resolution_multiplier, 1, MAX_RES_MULTIPLIER);
+        if (ImGui::IsItemHovered())
+            ImGui::SetTooltip("Render at a multiple of the native 960x544 resolution.\nHigher values look sharper on large displays but need a faster GPU.");
         ImGui::EndTabItem();
     } else
         ImGui::PopStyleColor();
@@ -643,6 +647,22 @@ void draw_settings_dialog(GuiState &gui, HostState &host) {
             host.kernel.debugger.watch_memory = !host.kernel.debugger.watch_memory;
             host.kernel.debugger.update_watches();
         }
+        ImGui::Text("Range");
+        ImGui::SameLine();
+        ImGui::PushItemWidth(10 * 8);
+        ImGui::InputText("##watch_addr", gui.watch_memory_address, 9, ImGuiInputTextFlags_CharsHexadecimal);
+        ImGui::SameLine();
+        ImGui::InputText("##watch_size", gui.watch_memory_size, 9, ImGuiInputTextFlags_CharsDecimal);
+        ImGui::PopItemWidth();
+        ImGui::SameLine();
+        const Address watch_address = static_cast<Address>(std::strtoul(gui.watch_memory_address, nullptr, 16));
+        if (ImGui::Button("Add##watch_memory"))
+            host.kernel.debugger.add_watch_memory_addr(host.mem, watch_address, std::strtoul(gui.watch_memory_size, nullptr, 10));
+        if (ImGui::IsItemHovered())
+            ImGui::SetTooltip("Log accesses to this address range (hexadecimal address, size in bytes) while memory is watched.");
+        ImGui::SameLine();
+        if (ImGui::Button("Remove##watch_memory"))
+            host.kernel.debugger.remove_watch_memory_addr(host.mem, watch_address);
         ImGui::Spacing();
         if (ImGui::Button(host.kernel.debugger.watch_import_calls ? "Unwatch import calls" : "Watch import calls")) {
             host.kernel.debugger.watch_import_calls = !host.kernel.debugger.watch_import_calls;
@@ -481,6 +481,8 @@ static ExitCode load_app_impl(Ptr<const void> &entry_point, HostState &host, con
     const auto call_import = [&host](CPUState &cpu, uint32_t nid, SceUID thread_id) {
         ::call_import(host, cpu, nid, thread_id);
     };
+    host.kernel.guest_thread_scheduler = host.cfg.guest_thread_scheduler;
+    host.kernel.native_functions.enabled = host.cfg.native_libc_functions;
     if (!host.kernel.init(host.mem, call_import, host.kernel.cpu_backend, host.kernel.cpu_opt)) {
         LOG_WARN("Failed to init kernel!");
         return KernelInitFailed;
@@ -521,6 +523,9 @@ static ExitCode load_app_impl(Ptr<const void> &entry_point, HostState &host, con
     LOG_INFO("Version: {}", host.app_version);
     LOG_INFO("Category: {}", host.app_category);
 
+    if (host.cfg.guest_profiler)
+        host.kernel.profiler.start(host.kernel, fs::path(host.base_path) / "profiles" / host.io.title_id);
+
     init_device_paths(host.io);
     init_savedata_app_path(host.io, host.pref_path);
 
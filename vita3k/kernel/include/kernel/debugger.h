@@ -65,8 +65,8 @@ struct Debugger {
     bool log_exports = false;
     bool dump_elfs = false;
 
-    void add_watch_memory_addr(Address addr, size_t size);
-    void remove_watch_memory_addr(KernelState &state, Address addr);
+    void add_watch_memory_addr(MemState &mem, Address addr, size_t size);
+    void remove_watch_memory_addr(MemState &mem, Address addr);
     void add_breakpoint(MemState &mem, uint32_t addr, bool thumb_mode);
     void remove_breakpoint(MemState &mem, uint32_t addr);
     void add_trampoile(MemState &mem, uint32_t addr, bool thumb_mode, TrampolineCallback callback);
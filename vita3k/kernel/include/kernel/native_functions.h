@@ -0,0 +1,78 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <mem/block.h>
+#include <mem/util.h>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+
+constexpr uint32_t NATIVE_FUNCTION_SVC = 0x55;
+
+struct CPUState;
+struct KernelState;
+struct MemState;
+
+// Returns false when the arguments reach memory the host can't access directly or write protected memory,
+// the guest code runs instead
+typedef bool (*NativeFunctionImpl)(CPUState &cpu, MemState &mem);
+
+struct NativeFunction {
+    const char *name;
+    NativeFunctionImpl impl;
+    bool thumb_mode;
+    Address addr;
+    uint32_t original;
+    // Original first instruction followed by a jump back to the rest of the guest function
+    Block fallback_code;
+    Address fallback_addr;
+};
+
+typedef std::map<Address, std::unique_ptr<NativeFunction>> NativeFunctionPtrs;
+
+// The first instruction of a replaced function is moved out to its fallback code,
+// so it must not depend on where it runs
+bool is_movable_arm(uint32_t inst);
+bool is_movable_thumb16(uint16_t inst);
+// inst holds the first halfword in its low bits, as read from memory
+bool is_movable_thumb32(uint32_t inst);
+
+// Hot guest libc routines (memcpy, memset, ...) replaced by host implementations working on the host
+// mapping of guest memory. Their first instruction is swapped for a SVC that runs the host code and
+// returns to the caller, or resumes the guest code when watched or unmapped pages are involved.
+struct NativeFunctions {
+    NativeFunctions() = delete;
+    explicit NativeFunctions(KernelState &kernel);
+
+    bool enabled = true;
+
+    // Patches the function exported with this NID at addr (thumb bit set for thumb code), if it has a replacement
+    bool patch(MemState &mem, Address addr, uint32_t nid);
+    // Called from the NATIVE_FUNCTION_SVC handler, pc being the address after the SVC
+    bool call(CPUState &cpu, MemState &mem, Address pc);
+    // Forgets every patched function and frees its fallback code, the patched code is left as is
+    void clear();
+
+private:
+    std::mutex mutex;
+    KernelState &parent;
+    NativeFunctionPtrs functions;
+};
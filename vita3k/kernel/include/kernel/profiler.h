@@ -0,0 +1,97 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <mem/util.h>
+#include <util/fs.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+struct KernelState;
+struct ThreadState;
+
+// Sampling profiler for guest code.
+// A host thread interrupts the CPU of every running guest thread at a fixed interval, which makes it publish the
+// PC it was stopped at for the next sample to pick up. HLE import calls are counted and timed per NID.
+// Stopping it writes a flat profile (profile.txt) and a collapsed stack file usable by flamegraph.pl
+// (profile.folded), symbolized with the loaded modules and their exports.
+class GuestProfiler {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    static constexpr std::uint32_t DEFAULT_INTERVAL_US = 1000;
+
+    struct ImportCall {
+        std::uint32_t previous_nid = 0;
+        Clock::time_point start;
+        bool profiled = false;
+    };
+
+    ~GuestProfiler();
+
+    void start(KernelState &kernel, const fs::path &output_dir, std::uint32_t interval_us = DEFAULT_INTERVAL_US);
+    // Writes the reports
+    void stop();
+    bool is_running() const {
+        return running;
+    }
+
+    // Around HLE calls made from guest code, only an atomic load when the profiler is not running
+    ImportCall begin_import(ThreadState &thread, std::uint32_t nid);
+    void end_import(ThreadState &thread, std::uint32_t nid, const ImportCall &call);
+
+    // Called by the guest thread itself each time its CPU stops, the sampling thread only ever interrupts it
+    void publish_pc(ThreadState &thread, Address pc);
+
+private:
+    struct ImportStats {
+        std::uint64_t calls = 0;
+        Clock::duration time{};
+    };
+
+    void thread_loop();
+    void sample();
+    void write_reports();
+
+    KernelState *kernel = nullptr;
+    fs::path output_dir;
+    std::chrono::microseconds interval{ DEFAULT_INTERVAL_US };
+
+    std::atomic<bool> running{ false };
+    std::unique_ptr<std::thread> thread;
+    std::mutex mutex;
+    std::condition_variable cond;
+    bool quit = false;
+
+    // Keyed by thread name, only touched by the sampling thread until it is joined
+    std::map<std::string, std::unordered_map<Address, std::uint64_t>> guest_samples;
+    std::map<std::string, std::unordered_map<std::uint32_t, std::uint64_t>> import_samples;
+    std::uint64_t sample_count = 0;
+
+    std::mutex import_mutex;
+    std::unordered_map<std::uint32_t, ImportStats> import_stats;
+};
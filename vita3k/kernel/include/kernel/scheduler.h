@@ -0,0 +1,88 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+struct ThreadState;
+class TimerWheel;
+
+// User cores available to games on the Vita
+constexpr std::size_t GUEST_CORE_COUNT = 3;
+
+enum class GuestCoreState {
+    idle, // Not holding a core
+    running, // Running guest code on its core
+    syscall, // Inside a HLE call, the core can be taken by a waiting thread
+    evicted, // Core taken away while inside a HLE call, must wait for one before going back to guest code
+};
+
+// Limits guest code to GUEST_CORE_COUNT threads at a time, handing the cores out by guest priority and
+// CPU affinity instead of letting the host timeslice every guest thread.
+// Threads give up their core at HLE calls when another thread is waiting, and a periodic check preempts
+// threads that keep a core from an equal or higher priority thread for longer than a quantum.
+// Disabled unless init is called with enabled set.
+class GuestScheduler {
+public:
+    void init(TimerWheel &timer_wheel, bool enabled);
+    bool is_enabled() const {
+        return enabled;
+    }
+
+    // Around guest code execution
+    void acquire(ThreadState &thread);
+    void release(ThreadState &thread);
+
+    // Around HLE calls made from guest code
+    void enter_syscall(ThreadState &thread);
+    void leave_syscall(ThreadState &thread);
+
+    // Changing these while the thread waits for a core moves it in the queue
+    void set_priority(ThreadState &thread, int priority);
+    void set_affinity_mask(ThreadState &thread, std::uint32_t affinity_mask);
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Core {
+        ThreadState *occupant = nullptr;
+        Clock::time_point since;
+    };
+
+    struct Waiter {
+        ThreadState *thread;
+        std::condition_variable cond;
+        bool granted = false;
+    };
+
+    bool can_run_on(const ThreadState &thread, std::size_t core) const;
+    bool take_core(ThreadState &thread);
+    void dispatch();
+    void preempt();
+
+    bool enabled = false;
+    std::mutex mutex;
+    std::vector<Core> cores;
+    std::vector<Waiter *> waiters; // Highest priority first, FIFO among equal priorities
+    std::atomic<std::size_t> waiter_count{ 0 };
+};
@@ -21,7 +21,11 @@
 #include <kernel/callback.h>
 #include <kernel/cpu_protocol.h>
 #include <kernel/debugger.h>
+#include <kernel/native_functions.h>
+#include <kernel/profiler.h>
+#include <kernel/scheduler.h>
 #include <kernel/sync_primitives.h>
+#include <kernel/timer_wheel.h>
 #include <kernel/types.h>
 #include <mem/allocator.h>
 #include <mem/ptr.h>
@@ -30,6 +34,7 @@
 #include <util/pool.h>
 
 #include <atomic>
+#include <initializer_list>
 #include <kernel/object_store.h>
 #include <map>
 #include <mutex>
@@ -95,6 +100,20 @@ struct TimerState {
     bool is_started = false;
     bool repeats = false;
     uint64_t time = 0;
+
+    // Timer event, fired from the kernel timer wheel while the timer is started.
+    // The fields below are protected by mutex.
+    std::mutex mutex;
+    WaitingThreadQueuePtr waiting_threads;
+    int32_t event_type = 0;
+    uint64_t event_interval = 0;
+    uint64_t next_event_time = 0;
+    TimerWheel::Handle event_handle = 0;
+    // Bumped whenever the event is rearmed or disabled, a callback from an older one is ignored
+    uint32_t event_generation = 0;
+    bool event_set = false;
+    // Bumped by sceKernelCancelTimer, so woken threads can tell they were cancelled
+    uint32_t cancel_count = 0;
 };
 
 typedef std::shared_ptr<TimerState> TimerPtr;
@@ -150,11 +169,16 @@ struct KernelState {
     uint64_t start_tick;
     SceRtcTick base_tick;
     TimerStates timers;
+    TimerWheel timer_wheel;
+    GuestScheduler scheduler;
+    bool guest_thread_scheduler = false;
     Ptr<uint32_t> process_param;
 
     NotFoundVars not_found_vars;
 
     Debugger debugger;
+    NativeFunctions native_functions;
+    GuestProfiler profiler;
 
     SceUID get_next_uid() {
         return next_uid++;
@@ -171,7 +195,7 @@ struct KernelState {
     Ptr<Ptr<void>> get_thread_tls_addr(MemState &mem, SceUID thread_id, int key);
     void exit_delete_all_threads();
 
-    int run_guest_function(Address callback_address, const std::vector<uint32_t> &args);
+    int run_guest_function(Address callback_address, std::initializer_list<uint32_t> args);
 
     void set_memory_watch(bool enabled);
     void invalidate_jit_cache(Address start, size_t length);
@@ -196,3 +196,14 @@ SceUID msgpipe_find(KernelState &kernel, const char *export_name, const char *na
 int msgpipe_recv(KernelState &kernel, const char *export_name, SceUID thread_id, SceUID msgpipe_id, SceUInt32 wait_mode, char *recv_buf, SceSize msg_size, SceUInt32 *timeout);
 int msgpipe_send(KernelState &kernel, const char *export_name, SceUID thread_id, SceUID msgpipe_id, SceUInt32 wait_mode, char *send_buf, SceSize msg_size, SceUInt32 *timeout);
 SceUID msgpipe_delete(KernelState &kernel, const char *export_name, const char *name, SceUID thread_id, SceUID msgpipe_id);
+
+// Timer
+int timer_delete(KernelState &kernel, const char *export_name, SceUID thread_id, SceUID timer_id);
+int timer_start(KernelState &kernel, const char *export_name, SceUID timer_id);
+int timer_stop(KernelState &kernel, const char *export_name, SceUID timer_id);
+int timer_set_event(KernelState &kernel, const char *export_name, SceUID timer_id, SceInt32 type, const SceKernelSysClock *interval, SceInt32 repeats);
+int timer_get_event_remaining_time(KernelState &kernel, const char *export_name, SceUID timer_id, SceKernelSysClock *remaining);
+int timer_wait(KernelState &kernel, const char *export_name, SceUID thread_id, SceUID timer_id, SceUInt32 *pResultPattern, SceUInt64 *pUserData, SceUInt32 *pTimeout);
+int timer_poll(KernelState &kernel, const char *export_name, SceUID thread_id, SceUID timer_id, SceUInt32 *pResultPattern, SceUInt64 *pUserData);
+int timer_clear(KernelState &kernel, const char *export_name, SceUID timer_id);
+int timer_cancel(KernelState &kernel, const char *export_name, SceUID timer_id, SceInt32 *pNumWaitThreads);
@@ -20,13 +20,15 @@
 #include <condition_variable>
 #include <cpu/state.h>
 #include <kernel/callback.h>
+#include <kernel/scheduler.h>
+#include <initializer_list>
 #include <kernel/types.h>
-#include <list>
 #include <mem/block.h>
 #include <mem/ptr.h>
 #include <mutex>
 #include <optional>
 #include <string>
+#include <vector>
 
 struct CPUState;
 struct CPUContext;
@@ -34,6 +36,7 @@ struct CPUContext;
 struct ThreadState;
 struct ThreadParams;
 struct KernelState;
+class GuestProfiler;
 
 typedef std::unique_ptr<CPUState, std::function<void(CPUState *)>> CPUStatePtr;
 typedef std::function<void(CPUState &, uint32_t, SceUID)> CallImport;
@@ -55,7 +58,33 @@ struct ThreadJob {
     bool in_progress = false;
 };
 
-typedef std::list<ThreadJob> RunQueue;
+// Double ended job queue backed by a ring buffer, so queueing jobs does not allocate once it has grown to its working size
+class RunQueue {
+public:
+    RunQueue();
+
+    bool empty() const {
+        return count == 0;
+    }
+    std::size_t size() const {
+        return count;
+    }
+
+    ThreadJob &front();
+    ThreadJob &operator[](std::size_t index);
+
+    void push_front(const ThreadJob &job);
+    void push_back(const ThreadJob &job);
+    void pop_front();
+    void clear();
+
+private:
+    void grow();
+
+    std::vector<ThreadJob> jobs;
+    std::size_t head = 0;
+    std::size_t count = 0;
+};
 
 enum class ThreadStatus {
     run, // Running
@@ -99,6 +128,16 @@ struct ThreadState {
     int priority;
     uint64_t start_tick;
 
+    // Guest core scheduling, see GuestScheduler
+    std::atomic<std::uint32_t> affinity_mask{ 0 };
+    int core = -1;
+    std::atomic<GuestCoreState> core_state{ GuestCoreState::idle };
+
+    // NID of the HLE call in progress, only tracked while the GuestProfiler is running
+    std::atomic<std::uint32_t> profiler_import_nid{ 0 };
+    // Guest PC published by the thread itself each time its CPU stops, taken by the GuestProfiler when sampling
+    std::atomic<Address> profiler_pc{ 0 };
+
     CPUStatePtr cpu;
     ThreadStatus status = ThreadStatus::dormant;
     RunQueue run_queue;
@@ -124,8 +163,8 @@ struct ThreadState {
     void flush_callback_requests();
     void raise_waiting_threads();
 
-    int run_guest_function(Address callback_address, const std::vector<uint32_t> &args);
-    void request_callback(Address callback_address, const std::vector<uint32_t> &args, const std::function<void(int res)> notify = nullptr);
+    int run_guest_function(Address callback_address, std::initializer_list<uint32_t> args);
+    void request_callback(Address callback_address, std::initializer_list<uint32_t> args, const std::function<void(int res)> notify = nullptr);
 
     void suspend();
     void resume(bool step = false);
@@ -133,11 +172,15 @@ struct ThreadState {
 
 private:
     void push_arguments(ThreadJob &job);
+    void run_front_job(std::unique_lock<std::mutex> &lock);
 
     CPUContext init_cpu_ctx;
     RunQueue callback_requests;
     ThreadToDo to_do = ThreadToDo::wait;
+    bool cpu_borrowed = false; // A caller of run_guest_function is running the CPU on its own host thread
     std::condition_variable something_to_do;
+    GuestScheduler *scheduler = nullptr;
+    GuestProfiler *profiler = nullptr;
 
     MemState &mem;
 };
@@ -0,0 +1,115 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct ThreadState;
+typedef std::shared_ptr<ThreadState> ThreadStatePtr;
+
+// Kernel owned clock and hierarchical timer wheel.
+// Every guest visible delay, wait timeout and timer goes through here, so guest time can be
+// scaled (e.g. to fast-forward loading screens) without touching the call sites.
+class TimerWheel {
+public:
+    typedef std::uint64_t Handle;
+    typedef std::function<void()> Callback;
+
+    TimerWheel();
+    ~TimerWheel();
+
+    void start();
+    void stop();
+
+    // Guest time in microseconds
+    std::uint64_t now() const;
+
+    // Ratio between guest time and host time, 1.0 being real time
+    void set_speed(double speed);
+    double get_speed() const;
+
+    // Callbacks are run on the wheel thread, without any wheel lock held.
+    // A non zero period makes the timer fire again every period_us microseconds until cancelled.
+    Handle schedule_at(std::uint64_t guest_time_us, Callback callback, std::uint64_t period_us = 0);
+    Handle schedule_after(std::uint64_t delay_us, Callback callback, std::uint64_t period_us = 0);
+
+    // Returns false if the timer has already fired (and is not periodic) or does not exist.
+    // Does not wait for a callback that is currently running.
+    bool cancel(Handle handle);
+
+    // Wait on the thread status_cond until pred returns true or timeout_us guest microseconds have passed.
+    // thread_lock must hold the thread mutex. Returns pred(), like std::condition_variable::wait_for.
+    bool wait_for(const ThreadStatePtr &thread, std::unique_lock<std::mutex> &thread_lock, std::uint64_t timeout_us, const std::function<bool()> &pred);
+
+    // Block the thread for delay_us guest microseconds
+    void sleep(const ThreadStatePtr &thread, std::uint64_t delay_us);
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    static constexpr std::uint64_t TICK_US = 100;
+    static constexpr int SLOT_BITS = 6;
+    static constexpr int SLOT_COUNT = 1 << SLOT_BITS;
+    static constexpr std::uint64_t SLOT_MASK = SLOT_COUNT - 1;
+    static constexpr int LEVEL_COUNT = 4;
+
+    struct Timer {
+        std::uint64_t deadline_us;
+        std::uint64_t period_us;
+        std::uint64_t expires_tick;
+        Callback callback;
+    };
+
+    struct Level {
+        std::array<std::vector<Handle>, SLOT_COUNT> slots;
+        std::uint64_t occupied = 0;
+    };
+
+    std::uint64_t now_locked() const;
+    Clock::time_point host_time_of(std::uint64_t guest_time_us) const;
+
+    void place(Handle handle, std::uint64_t expires_tick);
+    void cascade(int level, std::size_t slot);
+    void advance(std::vector<Callback> &due);
+    std::optional<std::uint64_t> next_event_tick() const;
+    void thread_loop();
+
+    mutable std::mutex mutex;
+    std::condition_variable cond;
+    std::unique_ptr<std::thread> thread;
+    bool quit = false;
+
+    Clock::time_point base_host;
+    std::uint64_t base_guest_us = 0;
+    double speed = 1.0;
+
+    std::array<Level, LEVEL_COUNT> levels;
+    std::unordered_map<Handle, Timer> timers;
+    std::uint64_t current_tick = 0;
+    Handle next_handle = 1;
+};
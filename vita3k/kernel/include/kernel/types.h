@@ -388,6 +388,15 @@ enum SceEventFlagWaitTypes {
     SCE_EVENT_WAITCLEAR_PAT = 4
 };
 
+enum SceKernelTimerEventType {
+    SCE_KERNEL_TIMER_TYPE_SET_EVENT = 0,
+    SCE_KERNEL_TIMER_TYPE_PULSE_EVENT = 1
+};
+
+enum SceKernelEventPattern {
+    SCE_KERNEL_EVENT_TIMER = 0x00000001
+};
+
 enum SceKernelMemBlockType {
     SCE_KERNEL_MEMBLOCK_TYPE_USER_RW_UNCACHE = 0x0C208060,
     SCE_KERNEL_MEMBLOCK_TYPE_USER_RX = 0x0C20D050,
@@ -67,8 +67,7 @@ bool Callback::execute() {
     if (!this->is_notified())
         return false; // We can't execute, so we don't want to be unregistered
 
-    std::vector<uint32_t> args = { (uint32_t)(this->notifier_id), this->num_notifications, (uint32_t)this->notification_arg, this->userdata.address() };
-    int cb_result = this->thread->run_guest_function(this->cb_func.address(), args);
+    int cb_result = this->thread->run_guest_function(this->cb_func.address(), { (uint32_t)(this->notifier_id), this->num_notifications, (uint32_t)this->notification_arg, this->userdata.address() });
     this->reset(); // Callbacks return to their default state after running
 
     return cb_result != 0; // A non-zero return value indicates the callback wants to be deleted
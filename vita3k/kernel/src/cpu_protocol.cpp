@@ -17,6 +17,7 @@
 
 #include <kernel/cpu_protocol.h>
 #include <kernel/state.h>
+#include <kernel/thread/thread_state.h>
 #include <util/lock_and_find.h>
 
 CPUProtocol::CPUProtocol(KernelState &kernel, MemState &mem, const CallImportFunc &func)
@@ -48,14 +49,24 @@ void CPUProtocol::call_svc(CPUState &cpu, uint32_t svc, Address pc, SceUID threa
         return;
     }
 
-    // This is usual service call
-    uint32_t nid = *Ptr<uint32_t>(pc + 4).get(*mem);
-    call_import(cpu, nid, thread_id);
+    // 3. Guest function replaced by a host implementation
+    if (svc == NATIVE_FUNCTION_SVC) {
+        kernel->native_functions.call(cpu, *mem, pc);
+        return;
+    }
 
     // TODO: just supply ThreadStatePtr to call_import
     // the only benefit of using thread_id instead--namely less locking--is now gone.
     ThreadStatePtr thread = lock_and_find(thread_id, kernel->threads, kernel->mutex);
 
+    // This is usual service call
+    uint32_t nid = *Ptr<uint32_t>(pc + 4).get(*mem);
+    kernel->scheduler.enter_syscall(*thread);
+    const GuestProfiler::ImportCall profiled_call = kernel->profiler.begin_import(*thread, nid);
+    call_import(cpu, nid, thread_id);
+    kernel->profiler.end_import(*thread, nid, profiled_call);
+    kernel->scheduler.leave_syscall(*thread);
+
     // Add callback jobs requested inside hle implementation
     thread->flush_callback_requests();
 
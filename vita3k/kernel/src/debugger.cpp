@@ -17,6 +17,7 @@
 
 #include <kernel/debugger.h>
 #include <kernel/state.h>
+#include <mem/functions.h>
 #include <util/align.h>
 #include <util/arm.h>
 #include <util/log.h>
@@ -124,14 +125,21 @@ Debugger::Debugger(KernelState &kernel)
     : parent(kernel) {
 }
 
-void Debugger::add_watch_memory_addr(Address addr, size_t size) {
+void Debugger::add_watch_memory_addr(MemState &mem, Address addr, size_t size) {
     std::lock_guard<std::mutex> lock(mutex);
-    watch_memory_addrs.emplace(addr, WatchMemory{ addr, size });
+    if (watch_memory_addrs.emplace(addr, WatchMemory{ addr, size }).second) {
+        // Keep the JIT on its logging callbacks for these pages only
+        set_slow_pages(mem, addr, size, true);
+    }
 }
 
-void Debugger::remove_watch_memory_addr(KernelState &state, Address addr) {
+void Debugger::remove_watch_memory_addr(MemState &mem, Address addr) {
     std::lock_guard<std::mutex> lock(mutex);
-    watch_memory_addrs.erase(addr);
+    const auto it = watch_memory_addrs.find(addr);
+    if (it != watch_memory_addrs.end()) {
+        set_slow_pages(mem, it->second.start, it->second.size, false);
+        watch_memory_addrs.erase(it);
+    }
 }
 
 // TODO use boost icl or interval tree instead if this turns out to be a significant bottleneck
@@ -71,13 +71,19 @@ static int SDLCALL thread_function(void *data) {
 }
 
 KernelState::KernelState()
-    : debugger(*this) {
+    : debugger(*this)
+    , native_functions(*this) {
 }
 
 bool KernelState::init(MemState &mem, CallImportFunc call_import, CPUBackend cpu_backend, bool cpu_opt) {
     constexpr std::size_t MAX_CORE_COUNT = 150;
 
     corenum_allocator.set_max_core_count(MAX_CORE_COUNT);
+    // Pooled jits belong to the previous exclusive monitor and memory
+    clear_jit_pool();
+    reset_interpreter_fallback_stats();
+    // Functions patched in the modules of a previous run
+    native_functions.clear();
     exclusive_monitor = new_exclusive_monitor(MAX_CORE_COUNT);
     start_tick = rtc_get_ticks(rtc_base_ticks());
     base_tick = { rtc_base_ticks() };
@@ -85,6 +91,8 @@ bool KernelState::init(MemState &mem, CallImportFunc call_import, CPUBackend cpu
     this->cpu_backend = cpu_backend;
     this->cpu_opt = cpu_opt;
     guest_func_runner = create_thread(mem, "guest function runner");
+    timer_wheel.start();
+    scheduler.init(timer_wheel, guest_thread_scheduler);
 
     return true;
 }
@@ -117,6 +125,7 @@ void KernelState::invalidate_jit_cache(Address start, size_t length) {
     for (auto thread : threads) {
         ::invalidate_jit_cache(*thread.second->cpu, start, length);
     }
+    invalidate_pooled_jit_cache(start, length);
 }
 
 ThreadStatePtr KernelState::get_thread(SceUID thread_id) {
@@ -171,9 +180,11 @@ void KernelState::exit_delete_all_threads() {
     for (auto [_, thread] : threads) {
         exit_delete_thread(thread);
     }
+    log_interpreter_fallback_report();
+    profiler.stop();
 }
 
-int KernelState::run_guest_function(Address callback_address, const std::vector<uint32_t> &args) {
+int KernelState::run_guest_function(Address callback_address, std::initializer_list<uint32_t> args) {
     return this->guest_func_runner->run_guest_function(callback_address, args);
 }
 
@@ -208,7 +208,7 @@ static bool load_imports(const sce_module_info_raw &module, Ptr<const void> segm
     return true;
 }
 
-static bool load_func_exports(Ptr<const void> &entry_point, const uint32_t *nids, const Ptr<uint32_t> *entries, size_t count, KernelState &kernel) {
+static bool load_func_exports(Ptr<const void> &entry_point, const uint32_t *nids, const Ptr<uint32_t> *entries, size_t count, KernelState &kernel, MemState &mem) {
     for (size_t i = 0; i < count; ++i) {
         const uint32_t nid = nids[i];
         const Ptr<uint32_t> entry = entries[i];
@@ -223,6 +223,7 @@ static bool load_func_exports(Ptr<const void> &entry_point, const uint32_t *nids
 
         kernel.export_nids.emplace(nid, entry.address());
         kernel.nid_from_export.emplace(entry.address(), nid);
+        kernel.native_functions.patch(mem, entry.address(), nid);
 
         if (kernel.debugger.log_exports) {
             const char *const name = import_name(nid);
@@ -282,7 +283,7 @@ static bool load_exports(Ptr<const void> &entry_point, const sce_module_info_raw
 
         const uint32_t *const nids = Ptr<const uint32_t>(exports->nid_table).get(mem);
         const Ptr<uint32_t> *const entries = Ptr<Ptr<uint32_t>>(exports->entry_table).get(mem);
-        if (!load_func_exports(entry_point, nids, entries, exports->num_syms_funcs, kernel)) {
+        if (!load_func_exports(entry_point, nids, entries, exports->num_syms_funcs, kernel, mem)) {
             return false;
         }
 
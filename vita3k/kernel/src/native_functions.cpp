@@ -0,0 +1,277 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <kernel/native_functions.h>
+
+#include <kernel/state.h>
+
+#include <cpu/functions.h>
+#include <mem/functions.h>
+#include <mem/ptr.h>
+#include <mem/state.h>
+#include <util/log.h>
+
+#include <algorithm>
+#include <cstring>
+
+constexpr uint64_t HOST_PAGE_SIZE = uint64_t(1) << HOST_PAGE_BITS;
+
+// Only pages mapped and not watched by the debugger have a host page table entry
+static bool is_direct_range(MemState &mem, uint64_t addr, uint64_t size) {
+    if (!size)
+        return true;
+    if (addr + size > (uint64_t(1) << 32))
+        return false;
+
+    const HostPageTable &table = *mem.host_page_table;
+    for (uint64_t page = addr >> HOST_PAGE_BITS; page <= (addr + size - 1) >> HOST_PAGE_BITS; page++) {
+        if (!table[page])
+            return false;
+    }
+    return true;
+}
+
+// Bytes readable directly from addr up to the end of its page, 0 if the page isn't directly accessible
+static uint64_t direct_bytes_in_page(MemState &mem, uint64_t addr) {
+    if ((addr >= (uint64_t(1) << 32)) || !(*mem.host_page_table)[addr >> HOST_PAGE_BITS])
+        return 0;
+    return HOST_PAGE_SIZE - (addr & (HOST_PAGE_SIZE - 1));
+}
+
+static bool native_memcpy(CPUState &cpu, MemState &mem) {
+    const Address dst = read_reg(cpu, 0);
+    const Address src = read_reg(cpu, 1);
+    const uint32_t size = read_reg(cpu, 2);
+    if (!is_direct_range(mem, dst, size) || !is_direct_range(mem, src, size) || is_write_protected(mem, dst, size))
+        return false;
+
+    // Overlapping buffers are undefined for memcpy, don't let them be undefined on the host side too
+    std::memmove(&mem.memory[dst], &mem.memory[src], size);
+    return true;
+}
+
+static bool native_memmove(CPUState &cpu, MemState &mem) {
+    return native_memcpy(cpu, mem);
+}
+
+static bool native_memset(CPUState &cpu, MemState &mem) {
+    const Address dst = read_reg(cpu, 0);
+    const uint8_t value = static_cast<uint8_t>(read_reg(cpu, 1));
+    const uint32_t size = read_reg(cpu, 2);
+    if (!is_direct_range(mem, dst, size) || is_write_protected(mem, dst, size))
+        return false;
+
+    std::memset(&mem.memory[dst], value, size);
+    return true;
+}
+
+static bool native_strlen(CPUState &cpu, MemState &mem) {
+    const Address str = read_reg(cpu, 0);
+    for (uint64_t addr = str;;) {
+        const uint64_t available = direct_bytes_in_page(mem, addr);
+        if (!available)
+            return false;
+
+        const uint8_t *const start = &mem.memory[addr];
+        const void *const end = std::memchr(start, 0, available);
+        if (end) {
+            write_reg(cpu, 0, static_cast<uint32_t>(addr - str + (static_cast<const uint8_t *>(end) - start)));
+            return true;
+        }
+        addr += available;
+    }
+}
+
+static bool native_strcmp(CPUState &cpu, MemState &mem) {
+    uint64_t lhs = read_reg(cpu, 0);
+    uint64_t rhs = read_reg(cpu, 1);
+    for (;;) {
+        const uint64_t available = std::min(direct_bytes_in_page(mem, lhs), direct_bytes_in_page(mem, rhs));
+        if (!available)
+            return false;
+
+        for (uint64_t i = 0; i < available; i++) {
+            const uint8_t a = mem.memory[lhs + i];
+            const uint8_t b = mem.memory[rhs + i];
+            if ((a != b) || !a) {
+                write_reg(cpu, 0, static_cast<uint32_t>(int32_t(a) - int32_t(b)));
+                return true;
+            }
+        }
+        lhs += available;
+        rhs += available;
+    }
+}
+
+struct NativeFunctionEntry {
+    uint32_t nid;
+    const char *name;
+    NativeFunctionImpl impl;
+};
+
+// SceLibc exports. memcpy, memmove and memset return their destination, which is already in r0.
+static constexpr NativeFunctionEntry NATIVE_FUNCTION_TABLE[] = {
+    { 0x7205BFDB, "memcpy", native_memcpy },
+    { 0xAF5C218D, "memmove", native_memmove },
+    { 0x6DC1F0D8, "memset", native_memset },
+    { 0x8AECC873, "strlen", native_strlen },
+    { 0x1B58FA3B, "strcmp", native_strcmp },
+};
+
+static bool is_thumb16(uint16_t first_half) {
+    return (first_half & 0xF800) < 0xE800;
+}
+
+bool is_movable_arm(uint32_t inst) {
+    if ((inst >> 28) != 0xE) // Conditional
+        return false;
+    if (((inst >> 25) & 7) == 5) // B, BL
+        return false;
+    if (((inst >> 26) & 3) == 3) // Coprocessor, SVC
+        return false;
+    if ((((inst >> 25) & 7) == 4) && (inst & 0x8000)) // LDM/STM with PC in the list, PUSH {r4, pc} for one
+        return false;
+    // No PC operand or destination
+    return ((inst >> 16) & 0xF) != 15 && ((inst >> 12) & 0xF) != 15 && (inst & 0xF) != 15;
+}
+
+bool is_movable_thumb16(uint16_t inst) {
+    if ((inst & 0xFE00) == 0xB400) // PUSH
+        return true;
+    if (inst < 0x4000) // Shifts, ADD/SUB, MOV/CMP immediate
+        return true;
+    if ((inst & 0xFC00) == 0x4000) // Data processing
+        return true;
+    if ((inst & 0xFC00) == 0x4400 && (inst & 0xFF00) != 0x4700) { // High register ADD/CMP/MOV, not BX/BLX
+        const uint16_t rm = (inst >> 3) & 0xF;
+        const uint16_t rdn = ((inst >> 4) & 8) | (inst & 7);
+        return rm != 15 && rdn != 15;
+    }
+    return false;
+}
+
+bool is_movable_thumb32(uint32_t inst) {
+    // PUSH.W without PC
+    return (inst & 0xFFFF) == 0xE92D && !((inst >> 16) & 0x8000);
+}
+
+NativeFunctions::NativeFunctions(KernelState &kernel)
+    : parent(kernel) {
+}
+
+bool NativeFunctions::patch(MemState &mem, Address addr, uint32_t nid) {
+    if (!enabled)
+        return false;
+
+    const auto entry = std::find_if(std::begin(NATIVE_FUNCTION_TABLE), std::end(NATIVE_FUNCTION_TABLE), [nid](const NativeFunctionEntry &entry) {
+        return entry.nid == nid;
+    });
+    if (entry == std::end(NATIVE_FUNCTION_TABLE))
+        return false;
+
+    std::unique_ptr<NativeFunction> function = std::make_unique<NativeFunction>();
+    function->name = entry->name;
+    function->impl = entry->impl;
+    function->thumb_mode = addr & 1;
+    function->addr = addr & ~1;
+
+    uint32_t *inst = Ptr<uint32_t>(function->addr).get(mem);
+    function->original = *inst;
+
+    uint32_t patched_inst;
+    uint32_t back_inst;
+    Address resume_addr;
+    const uint16_t first_half = function->original & 0xFFFF;
+    if (function->thumb_mode && is_thumb16(first_half)) {
+        if (!is_movable_thumb16(first_half)) {
+            LOG_WARN("Can't replace {} at {}, first instruction {} can't be moved", entry->name, log_hex(function->addr), log_hex(first_half));
+            return false;
+        }
+        patched_inst = (function->original & 0xFFFF0000) | 0xDF00 | NATIVE_FUNCTION_SVC; // SVC 0x55
+        back_inst = 0xBF000000 | first_half; // original thumb16 instruction + nop
+        resume_addr = (function->addr + 2) | 1;
+    } else if (function->thumb_mode) {
+        if (!is_movable_thumb32(function->original)) {
+            LOG_WARN("Can't replace {} at {}, first instruction {} can't be moved", entry->name, log_hex(function->addr), log_hex(function->original));
+            return false;
+        }
+        patched_inst = 0xBF000000 | 0xDF00 | NATIVE_FUNCTION_SVC; // SVC 0x55 + nop, never reached
+        back_inst = function->original;
+        resume_addr = (function->addr + 4) | 1;
+    } else {
+        if (!is_movable_arm(function->original)) {
+            LOG_WARN("Can't replace {} at {}, first instruction {} can't be moved", entry->name, log_hex(function->addr), log_hex(function->original));
+            return false;
+        }
+        patched_inst = 0xEF000000 | NATIVE_FUNCTION_SVC; // SVC 0x55
+        back_inst = function->original;
+        resume_addr = function->addr + 4;
+    }
+
+    // The host implementations look up the page table to tell which memory they can touch directly
+    get_host_page_table(mem);
+
+    function->fallback_code = alloc_block(mem, 12, "native function fallback");
+    function->fallback_addr = function->fallback_code.get();
+    uint32_t *fallback_insts = Ptr<uint32_t>(function->fallback_addr).get(mem);
+    fallback_insts[0] = back_inst;
+    fallback_insts[1] = function->thumb_mode ? 0xF000F8DF : 0xE51FF004; // LDR PC, [PC] reading the next word
+    fallback_insts[2] = resume_addr;
+    if (function->thumb_mode)
+        function->fallback_addr |= 1;
+
+    *inst = patched_inst;
+    LOG_INFO("Replaced {} at {} with a host implementation", entry->name, log_hex(function->addr));
+
+    const Address patched_addr = function->addr;
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        functions.emplace(patched_addr, std::move(function));
+    }
+    parent.invalidate_jit_cache(patched_addr, 4);
+
+    return true;
+}
+
+void NativeFunctions::clear() {
+    const std::lock_guard<std::mutex> lock(mutex);
+    // Frees the fallback code of each function along with it
+    functions.clear();
+}
+
+bool NativeFunctions::call(CPUState &cpu, MemState &mem, Address pc) {
+    NativeFunction *function = nullptr;
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        // The SVC is 2 bytes long in thumb code and 4 in ARM code
+        auto it = functions.find(pc - 2);
+        if (it != functions.end() && it->second->thumb_mode)
+            function = it->second.get();
+        it = functions.find(pc - 4);
+        if (!function && it != functions.end() && !it->second->thumb_mode)
+            function = it->second.get();
+    }
+    if (!function)
+        return false;
+
+    if (function->impl(cpu, mem))
+        write_pc(cpu, read_lr(cpu));
+    else
+        write_pc(cpu, function->fallback_addr);
+
+    return true;
+}
@@ -0,0 +1,255 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <kernel/profiler.h>
+
+#include <kernel/state.h>
+#include <kernel/thread/thread_state.h>
+
+#include <cpu/functions.h>
+
+#include <nids/functions.h>
+#include <util/log.h>
+
+#include <spdlog/fmt/fmt.h>
+
+#include <algorithm>
+#include <vector>
+
+GuestProfiler::~GuestProfiler() {
+    stop();
+}
+
+void GuestProfiler::start(KernelState &kernel, const fs::path &output_dir, std::uint32_t interval_us) {
+    stop();
+
+    this->kernel = &kernel;
+    this->output_dir = output_dir;
+    interval = std::chrono::microseconds(std::max<std::uint32_t>(interval_us, 100));
+    guest_samples.clear();
+    import_samples.clear();
+    sample_count = 0;
+    {
+        const std::lock_guard<std::mutex> guard(import_mutex);
+        import_stats.clear();
+    }
+
+    quit = false;
+    running = true;
+    thread = std::make_unique<std::thread>(&GuestProfiler::thread_loop, this);
+    LOG_INFO("Guest profiler started, sampling every {} us", interval.count());
+}
+
+void GuestProfiler::stop() {
+    if (!thread)
+        return;
+
+    {
+        const std::lock_guard<std::mutex> guard(mutex);
+        quit = true;
+    }
+    cond.notify_all();
+    thread->join();
+    thread.reset();
+    running = false;
+
+    write_reports();
+}
+
+GuestProfiler::ImportCall GuestProfiler::begin_import(ThreadState &thread, std::uint32_t nid) {
+    ImportCall call;
+    if (!running)
+        return call;
+
+    call.previous_nid = thread.profiler_import_nid.exchange(nid);
+    call.start = Clock::now();
+    call.profiled = true;
+    return call;
+}
+
+void GuestProfiler::end_import(ThreadState &thread, std::uint32_t nid, const ImportCall &call) {
+    if (!call.profiled)
+        return;
+
+    const Clock::duration elapsed = Clock::now() - call.start;
+    // Imports nest when a HLE function runs guest callbacks
+    thread.profiler_import_nid = call.previous_nid;
+
+    const std::lock_guard<std::mutex> guard(import_mutex);
+    ImportStats &stats = import_stats[nid];
+    stats.calls++;
+    stats.time += elapsed;
+}
+
+void GuestProfiler::publish_pc(ThreadState &thread, Address pc) {
+    if (running)
+        thread.profiler_pc.store(pc, std::memory_order_relaxed);
+}
+
+void GuestProfiler::thread_loop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    auto next = Clock::now() + interval;
+    while (!cond.wait_until(lock, next, [this] { return quit; })) {
+        lock.unlock();
+        sample();
+        lock.lock();
+
+        // Don't try to catch up on samples missed while the host was busy
+        next = std::max(next + interval, Clock::now());
+    }
+}
+
+void GuestProfiler::sample() {
+    std::vector<ThreadStatePtr> threads;
+    {
+        const std::lock_guard<std::mutex> guard(kernel->mutex);
+        threads.reserve(kernel->threads.size());
+        for (const auto &[_, thread] : kernel->threads)
+            threads.push_back(thread);
+    }
+
+    for (const ThreadStatePtr &thread : threads) {
+        const std::lock_guard<std::mutex> guard(thread->mutex);
+        if (thread->status != ThreadStatus::run)
+            continue;
+
+        const std::uint32_t nid = thread->profiler_import_nid;
+        if (nid) {
+            sample_count++;
+            import_samples[thread->name][nid]++;
+            continue;
+        }
+
+        // The PC the thread published when the interrupt of the previous sample stopped its CPU, a thread
+        // that didn't get back to guest code since then isn't sampled
+        const Address pc = thread->profiler_pc.exchange(0, std::memory_order_relaxed);
+        if (pc) {
+            sample_count++;
+            guest_samples[thread->name][pc & ~1]++;
+        }
+
+        // Stop it wherever it is in guest code, it publishes the live PC and resumes right away
+        interrupt(*thread->cpu);
+    }
+}
+
+namespace {
+
+struct Symbolizer {
+    KernelState &kernel;
+    std::vector<std::pair<Address, std::uint32_t>> exports; // Sorted by address
+    std::unordered_map<Address, std::pair<std::string, std::string>> cache;
+
+    explicit Symbolizer(KernelState &kernel)
+        : kernel(kernel) {
+        {
+            const std::lock_guard<std::mutex> guard(kernel.mutex);
+            for (const auto &[address, nid] : kernel.nid_from_export)
+                exports.emplace_back(address & ~1, nid);
+        }
+        std::sort(exports.begin(), exports.end());
+    }
+
+    // Module and closest exported function at or before the address, in the same module
+    const std::pair<std::string, std::string> &resolve(Address address) {
+        const auto cached = cache.find(address);
+        if (cached != cache.end())
+            return cached->second;
+
+        std::pair<std::string, std::string> symbol{ "[unknown]", fmt::format("0x{:08X}", address) };
+        const auto module = kernel.find_module_by_addr(address);
+        if (module) {
+            symbol.first = module->module_name;
+            symbol.second = "[unknown]";
+
+            auto it = std::upper_bound(exports.begin(), exports.end(), std::make_pair(address, UINT32_MAX));
+            if (it != exports.begin()) {
+                --it;
+                if (kernel.find_module_by_addr(it->first) == module)
+                    symbol.second = import_name(it->second);
+            }
+        }
+
+        return cache.emplace(address, std::move(symbol)).first->second;
+    }
+};
+
+// Frames are separated by ';' in the collapsed stack format, and it has no escape
+std::string folded_frame(std::string name) {
+    std::replace(name.begin(), name.end(), ';', ':');
+    return name;
+}
+
+std::string nid_name(std::uint32_t nid) {
+    const std::string name = import_name(nid);
+    return name == "UNRECOGNISED" ? fmt::format("nid_{:08X}", nid) : name;
+}
+
+} // namespace
+
+void GuestProfiler::write_reports() {
+    fs::create_directories(output_dir);
+    Symbolizer symbolizer(*kernel);
+
+    std::map<std::pair<std::string, std::string>, std::uint64_t> flat;
+    std::map<std::string, std::uint64_t> collapsed;
+    for (const auto &[thread_name, samples] : guest_samples) {
+        for (const auto &[pc, count] : samples) {
+            const auto &[module, function] = symbolizer.resolve(pc);
+            flat[{ module, function }] += count;
+            collapsed[fmt::format("{};{};{}", folded_frame(thread_name), folded_frame(module), folded_frame(function))] += count;
+        }
+    }
+    for (const auto &[thread_name, samples] : import_samples) {
+        for (const auto &[nid, count] : samples) {
+            flat[{ "[HLE]", nid_name(nid) }] += count;
+            collapsed[fmt::format("{};[HLE];{}", folded_frame(thread_name), folded_frame(nid_name(nid)))] += count;
+        }
+    }
+
+    std::vector<std::pair<std::pair<std::string, std::string>, std::uint64_t>> flat_sorted(flat.begin(), flat.end());
+    std::sort(flat_sorted.begin(), flat_sorted.end(), [](const auto &a, const auto &b) { return a.second > b.second; });
+
+    std::vector<std::pair<std::uint32_t, ImportStats>> imports;
+    {
+        const std::lock_guard<std::mutex> guard(import_mutex);
+        imports.assign(import_stats.begin(), import_stats.end());
+    }
+    std::sort(imports.begin(), imports.end(), [](const auto &a, const auto &b) { return a.second.time > b.second.time; });
+
+    const fs::path profile_path = output_dir / "profile.txt";
+    fs::ofstream profile(profile_path);
+    profile << fmt::format("{} samples, every {} us\n\n", sample_count, interval.count());
+    profile << fmt::format("{:>10} {:>7}  {:<28} {}\n", "samples", "%", "module", "function");
+    for (const auto &[symbol, count] : flat_sorted) {
+        const double percent = sample_count ? 100.0 * count / sample_count : 0.0;
+        profile << fmt::format("{:>10} {:>7.2f}  {:<28} {}\n", count, percent, symbol.first, symbol.second);
+    }
+
+    profile << fmt::format("\n{:>10} {:>12} {:>10}  {:<10} {}\n", "calls", "total ms", "avg us", "nid", "function");
+    for (const auto &[nid, stats] : imports) {
+        const double total_us = std::chrono::duration<double, std::micro>(stats.time).count();
+        profile << fmt::format("{:>10} {:>12.3f} {:>10.3f}  0x{:08X} {}\n", stats.calls, total_us / 1000.0, total_us / stats.calls, nid, nid_name(nid));
+    }
+
+    const fs::path folded_path = output_dir / "profile.folded";
+    fs::ofstream folded(folded_path);
+    for (const auto &[stack, count] : collapsed)
+        folded << stack << ' ' << count << '\n';
+
+    LOG_INFO("Guest profile written to {} and {}", profile_path.string(), folded_path.string());
+}
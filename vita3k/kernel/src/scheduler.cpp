@@ -0,0 +1,209 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <kernel/scheduler.h>
+
+#include <kernel/thread/thread_state.h>
+#include <kernel/timer_wheel.h>
+
+#include <cpu/functions.h>
+
+#include <algorithm>
+#include <optional>
+
+static constexpr std::uint64_t SCHEDULER_QUANTUM_US = 4000;
+static constexpr std::uint32_t CPU_AFFINITY_MASK_USER_0 = 0x10000;
+
+void GuestScheduler::init(TimerWheel &timer_wheel, bool enabled) {
+    this->enabled = enabled;
+    if (!enabled)
+        return;
+
+    cores.resize(GUEST_CORE_COUNT);
+    timer_wheel.schedule_after(
+        SCHEDULER_QUANTUM_US, [this]() { preempt(); }, SCHEDULER_QUANTUM_US);
+}
+
+bool GuestScheduler::can_run_on(const ThreadState &thread, std::size_t core) const {
+    const std::uint32_t user_mask = (CPU_AFFINITY_MASK_USER_0 << GUEST_CORE_COUNT) - CPU_AFFINITY_MASK_USER_0;
+    const std::uint32_t mask = thread.affinity_mask & user_mask;
+    // No user core in the mask means any core
+    return !mask || (mask & (CPU_AFFINITY_MASK_USER_0 << core));
+}
+
+bool GuestScheduler::take_core(ThreadState &thread) {
+    std::optional<std::size_t> found;
+    for (std::size_t core = 0; core < cores.size(); core++) {
+        if (!cores[core].occupant && can_run_on(thread, core)) {
+            found = core;
+            break;
+        }
+    }
+
+    // Otherwise take the core of a thread that is busy in a HLE call
+    if (!found) {
+        for (std::size_t core = 0; core < cores.size(); core++) {
+            ThreadState *occupant = cores[core].occupant;
+            if (!occupant || !can_run_on(thread, core))
+                continue;
+
+            GuestCoreState expected = GuestCoreState::syscall;
+            if (occupant->core_state.compare_exchange_strong(expected, GuestCoreState::evicted)) {
+                occupant->core = -1;
+                found = core;
+                break;
+            }
+        }
+    }
+
+    if (!found)
+        return false;
+
+    cores[*found].occupant = &thread;
+    cores[*found].since = Clock::now();
+    thread.core = static_cast<int>(*found);
+    thread.core_state = GuestCoreState::running;
+    return true;
+}
+
+void GuestScheduler::dispatch() {
+    for (auto it = waiters.begin(); it != waiters.end();) {
+        Waiter *waiter = *it;
+        if (!take_core(*waiter->thread)) {
+            ++it;
+            continue;
+        }
+
+        waiter->granted = true;
+        waiter->cond.notify_one();
+        it = waiters.erase(it);
+        waiter_count--;
+    }
+}
+
+void GuestScheduler::acquire(ThreadState &thread) {
+    if (!enabled)
+        return;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    if (waiters.empty() && take_core(thread))
+        return;
+
+    Waiter waiter{ &thread };
+    const auto position = std::find_if(waiters.begin(), waiters.end(), [&](const Waiter *other) {
+        return other->thread->priority > thread.priority;
+    });
+    waiters.insert(position, &waiter);
+    waiter_count++;
+
+    dispatch();
+    waiter.cond.wait(lock, [&]() { return waiter.granted; });
+}
+
+void GuestScheduler::release(ThreadState &thread) {
+    if (!enabled)
+        return;
+
+    const std::lock_guard<std::mutex> lock(mutex);
+    if (thread.core >= 0) {
+        cores[thread.core].occupant = nullptr;
+        thread.core = -1;
+    }
+    thread.core_state = GuestCoreState::idle;
+    dispatch();
+}
+
+void GuestScheduler::enter_syscall(ThreadState &thread) {
+    if (!enabled)
+        return;
+
+    thread.core_state = GuestCoreState::syscall;
+    if (waiter_count) {
+        const std::lock_guard<std::mutex> lock(mutex);
+        dispatch();
+    }
+}
+
+void GuestScheduler::leave_syscall(ThreadState &thread) {
+    if (!enabled)
+        return;
+
+    GuestCoreState expected = GuestCoreState::syscall;
+    if (!thread.core_state.compare_exchange_strong(expected, GuestCoreState::running))
+        acquire(thread);
+}
+
+void GuestScheduler::set_priority(ThreadState &thread, int priority) {
+    if (!enabled) {
+        thread.priority = priority;
+        return;
+    }
+
+    const std::lock_guard<std::mutex> lock(mutex);
+    thread.priority = priority;
+
+    const auto current = std::find_if(waiters.begin(), waiters.end(), [&](const Waiter *waiter) {
+        return waiter->thread == &thread;
+    });
+    if (current == waiters.end())
+        return;
+
+    Waiter *waiter = *current;
+    waiters.erase(current);
+    const auto position = std::find_if(waiters.begin(), waiters.end(), [&](const Waiter *other) {
+        return other->thread->priority > priority;
+    });
+    waiters.insert(position, waiter);
+    dispatch();
+}
+
+void GuestScheduler::set_affinity_mask(ThreadState &thread, std::uint32_t affinity_mask) {
+    if (!enabled) {
+        thread.affinity_mask = affinity_mask;
+        return;
+    }
+
+    const std::lock_guard<std::mutex> lock(mutex);
+    thread.affinity_mask = affinity_mask;
+    // The thread may now fit on a free core
+    dispatch();
+}
+
+void GuestScheduler::preempt() {
+    const std::lock_guard<std::mutex> lock(mutex);
+    dispatch();
+
+    const Clock::time_point now = Clock::now();
+    for (const Waiter *waiter : waiters) {
+        for (std::size_t core = 0; core < cores.size(); core++) {
+            ThreadState *occupant = cores[core].occupant;
+            if (!occupant || !can_run_on(*waiter->thread, core) || (occupant->core_state != GuestCoreState::running))
+                continue;
+
+            // Lower value is higher priority: round robin among equals, never preempt for a lower priority thread
+            if (occupant->priority < waiter->thread->priority)
+                continue;
+            if (now - cores[core].since < std::chrono::microseconds(SCHEDULER_QUANTUM_US))
+                continue;
+
+            // The thread gives its core back once its CPU stops, and queues again behind the waiter
+            cores[core].since = now;
+            stop(*occupant->cpu);
+            break;
+        }
+    }
+}
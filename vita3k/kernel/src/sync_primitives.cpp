@@ -75,13 +75,12 @@ inline int find_condvar(CondvarPtr &condvar_out, CondvarPtrs **condvars_out, Ker
     return SCE_KERNEL_OK;
 }
 
-// TODO: Write remaining time to timeout ptr when it's successfully signaled
-
-inline int handle_timeout(const ThreadStatePtr &thread, std::unique_lock<std::mutex> &thread_lock,
+inline int handle_timeout(KernelState &kernel, const ThreadStatePtr &thread, std::unique_lock<std::mutex> &thread_lock,
     std::unique_lock<std::mutex> &primitive_lock, WaitingThreadQueuePtr &queue,
     const WaitingThreadData &data, const char *export_name, SceUInt *const timeout) {
     if (timeout && *timeout > 0) {
-        auto status = thread->status_cond.wait_for(thread_lock, std::chrono::microseconds{ *timeout }, [&] { return thread->status == ThreadStatus::run; });
+        const std::uint64_t wait_start = kernel.timer_wheel.now();
+        auto status = kernel.timer_wheel.wait_for(thread, thread_lock, *timeout, [&] { return thread->status == ThreadStatus::run; });
 
         if (!status) {
             *timeout = 0; // Time run out, so remaining time is 0
@@ -95,6 +94,9 @@ inline int handle_timeout(const ThreadStatePtr &thread, std::unique_lock<std::mu
 
             return RET_ERROR(SCE_KERNEL_ERROR_WAIT_TIMEOUT);
         }
+
+        const std::uint64_t waited = kernel.timer_wheel.now() - wait_start;
+        *timeout = waited < *timeout ? static_cast<SceUInt>(*timeout - waited) : 0;
     } else {
         thread->status_cond.wait(thread_lock, [&] { return thread->status == ThreadStatus::run; });
     }
@@ -211,7 +213,7 @@ inline int mutex_lock_impl(KernelState &kernel, MemState &mem, const char *expor
         mutex->waiting_threads->push(data);
         mutex_lock.unlock();
 
-        int res = handle_timeout(thread, thread_lock, mutex_lock, mutex->waiting_threads, data, export_name, timeout);
+        int res = handle_timeout(kernel, thread, thread_lock, mutex_lock, mutex->waiting_threads, data, export_name, timeout);
 
         if (weight == SyncWeight::Light) {
             mutex->workarea.get(mem)->lockCount = mutex->lock_count;
@@ -413,7 +415,7 @@ int semaphore_wait(KernelState &kernel, const char *export_name, SceUID thread_i
         semaphore->waiting_threads->push(data);
         semaphore_lock.unlock();
 
-        return handle_timeout(thread, thread_lock, semaphore_lock, semaphore->waiting_threads, data, export_name, timeout);
+        return handle_timeout(kernel, thread, thread_lock, semaphore_lock, semaphore->waiting_threads, data, export_name, timeout);
     } else {
         semaphore->val -= signal;
     }
@@ -560,7 +562,7 @@ int condvar_wait(KernelState &kernel, MemState &mem, const char *export_name, Sc
     condvar->waiting_threads->push(data);
     condition_variable_lock.unlock();
 
-    if (auto error = handle_timeout(thread, thread_lock, condition_variable_lock, condvar->waiting_threads, data, export_name, timeout))
+    if (auto error = handle_timeout(kernel, thread, thread_lock, condition_variable_lock, condvar->waiting_threads, data, export_name, timeout))
         return error;
 
     thread_lock.unlock();
@@ -741,7 +743,7 @@ static int eventflag_waitorpoll(KernelState &kernel, const char *export_name, Sc
         event->waiting_threads->push(data);
         event_lock.unlock();
 
-        return handle_timeout(thread, thread_lock, event_lock, event->waiting_threads, data, export_name, timeout);
+        return handle_timeout(kernel, thread, thread_lock, event_lock, event->waiting_threads, data, export_name, timeout);
     }
 
     return SCE_KERNEL_OK;
@@ -978,7 +980,7 @@ int msgpipe_recv(KernelState &kernel, const char *export_name, SceUID thread_id,
 
             return finish();
         } else { // There's a timeout - wait until we can fill buffer or timeout
-            auto status = thread->status_cond.wait_for(thread_lock, std::chrono::microseconds{ *timeout }, [&] { return thread->status == ThreadStatus::run; });
+            auto status = kernel.timer_wheel.wait_for(thread, thread_lock, *timeout, [&] { return thread->status == ThreadStatus::run; });
             if (msgpipe->beingDeleted) {
                 std::atomic_fetch_add(&msgpipe->remainingThreads, -1);
                 return SCE_KERNEL_ERROR_WAIT_DELETE;
@@ -1078,7 +1080,7 @@ int msgpipe_send(KernelState &kernel, const char *export_name, SceUID thread_id,
 
             return finish();
         } else { // There's a timeout - wait until we can fill buffer or timeout
-            auto status = thread->status_cond.wait_for(thread_lock, std::chrono::microseconds{ *timeout }, [&] { return thread->status == ThreadStatus::run; });
+            auto status = kernel.timer_wheel.wait_for(thread, thread_lock, *timeout, [&] { return thread->status == ThreadStatus::run; });
             if (msgpipe->beingDeleted) {
                 std::atomic_fetch_add(&msgpipe->remainingThreads, -1);
                 return SCE_KERNEL_ERROR_WAIT_DELETE;
@@ -1130,3 +1132,281 @@ SceUID msgpipe_delete(KernelState &kernel, const char *export_name, const char *
 
     return SCE_KERNEL_OK;
 }
+
+// *********
+// * Timer *
+// *********
+
+// Wakes the threads waiting for the timer event, all of them unless only_one is set.
+// Returns the number of threads woken.
+static int timer_wake_waiting_threads(TimerState &timer, std::unique_lock<std::mutex> &timer_lock, bool only_one) {
+    int woken = 0;
+
+    bool retry;
+    do {
+        retry = false;
+        for (auto it = timer.waiting_threads->begin(); it != timer.waiting_threads->end();) {
+            const ThreadStatePtr waiting_thread = (*it).thread;
+
+            // A thread timing out holds its own mutex before taking the timer one, let it go and come back
+            const std::unique_lock<std::mutex> waiting_thread_lock(waiting_thread->mutex, std::try_to_lock);
+            if (!waiting_thread_lock) {
+                retry = true;
+                ++it;
+                continue;
+            }
+
+            // Already timed out, it removes itself from the queue
+            if (waiting_thread->status != ThreadStatus::wait) {
+                ++it;
+                continue;
+            }
+
+            waiting_thread->update_status(ThreadStatus::run, ThreadStatus::wait);
+            timer.waiting_threads->erase(it++);
+            woken++;
+
+            if (only_one)
+                return woken;
+        }
+
+        if (retry) {
+            timer_lock.unlock();
+            std::this_thread::yield();
+            timer_lock.lock();
+        }
+    } while (retry);
+
+    return woken;
+}
+
+static void timer_fire(const std::weak_ptr<TimerState> &weak_timer, uint32_t generation) {
+    const TimerPtr timer = weak_timer.lock();
+    if (!timer)
+        return;
+
+    std::unique_lock<std::mutex> timer_lock(timer->mutex);
+    // Cancelled or rearmed while the callback was about to run
+    if (timer->event_generation != generation)
+        return;
+
+    if (timer->repeats) {
+        timer->next_event_time += timer->event_interval;
+    } else {
+        timer->event_handle = 0;
+        timer->next_event_time = 0;
+    }
+
+    const bool auto_reset = timer->reset_behaviour == TimerState::ResetBehaviour::AUTOMATIC;
+    const int woken = timer_wake_waiting_threads(*timer, timer_lock, auto_reset);
+
+    // A set event stays signaled until a waiting thread consumes it (automatic reset) or it is cleared
+    if ((timer->event_type == SCE_KERNEL_TIMER_TYPE_SET_EVENT) && !(auto_reset && woken))
+        timer->event_set = true;
+}
+
+// timer->mutex must be held
+static void timer_arm_event(KernelState &kernel, const TimerPtr &timer) {
+    const uint32_t generation = ++timer->event_generation;
+    if (timer->event_handle) {
+        kernel.timer_wheel.cancel(timer->event_handle);
+        timer->event_handle = 0;
+        timer->next_event_time = 0;
+    }
+
+    if (!timer->is_started || !timer->event_interval)
+        return;
+
+    const std::weak_ptr<TimerState> weak_timer = timer;
+    timer->next_event_time = kernel.timer_wheel.now() + timer->event_interval;
+    timer->event_handle = kernel.timer_wheel.schedule_at(
+        timer->next_event_time, [weak_timer, generation]() { timer_fire(weak_timer, generation); }, timer->repeats ? timer->event_interval : 0);
+}
+
+int timer_delete(KernelState &kernel, const char *export_name, SceUID thread_id, SceUID timer_id) {
+    const TimerPtr timer = lock_and_find(timer_id, kernel.timers, kernel.mutex);
+    if (!timer) {
+        return RET_ERROR(SCE_KERNEL_ERROR_UNKNOWN_TIMER_ID);
+    }
+
+    std::unique_lock<std::mutex> timer_lock(timer->mutex);
+    timer->is_started = false;
+    timer_arm_event(kernel, timer);
+
+    if (!timer->waiting_threads->empty()) {
+        // TODO:
+        LOG_WARN("Deleting timer {} with waiting threads, releasing them.", timer->name);
+        timer->cancel_count++;
+        timer_wake_waiting_threads(*timer, timer_lock, false);
+    }
+    timer_lock.unlock();
+
+    const std::lock_guard<std::mutex> kernel_lock(kernel.mutex);
+    kernel.timers.erase(timer_id);
+
+    return SCE_KERNEL_OK;
+}
+
+int timer_start(KernelState &kernel, const char *export_name, SceUID timer_id) {
+    const TimerPtr timer = lock_and_find(timer_id, kernel.timers, kernel.mutex);
+    if (!timer) {
+        return RET_ERROR(SCE_KERNEL_ERROR_UNKNOWN_TIMER_ID);
+    }
+
+    const std::lock_guard<std::mutex> timer_lock(timer->mutex);
+    if (timer->is_started)
+        return false;
+
+    timer->is_started = true;
+    timer->time = kernel.timer_wheel.now();
+    timer_arm_event(kernel, timer);
+
+    return true;
+}
+
+int timer_stop(KernelState &kernel, const char *export_name, SceUID timer_id) {
+    const TimerPtr timer = lock_and_find(timer_id, kernel.timers, kernel.mutex);
+    if (!timer) {
+        return RET_ERROR(SCE_KERNEL_ERROR_UNKNOWN_TIMER_ID);
+    }
+
+    const std::lock_guard<std::mutex> timer_lock(timer->mutex);
+    if (!timer->is_started)
+        return false;
+
+    timer->is_started = false;
+    timer->time = kernel.timer_wheel.now();
+    timer_arm_event(kernel, timer);
+
+    return true;
+}
+
+int timer_set_event(KernelState &kernel, const char *export_name, SceUID timer_id, SceInt32 type, const SceKernelSysClock *interval, SceInt32 repeats) {
+    const TimerPtr timer = lock_and_find(timer_id, kernel.timers, kernel.mutex);
+    if (!timer) {
+        return RET_ERROR(SCE_KERNEL_ERROR_UNKNOWN_TIMER_ID);
+    }
+
+    if ((type != SCE_KERNEL_TIMER_TYPE_SET_EVENT) && (type != SCE_KERNEL_TIMER_TYPE_PULSE_EVENT)) {
+        return RET_ERROR(SCE_KERNEL_ERROR_ILLEGAL_TYPE);
+    }
+
+    const std::lock_guard<std::mutex> timer_lock(timer->mutex);
+    timer->event_type = type;
+    // No interval disables the event
+    timer->event_interval = interval ? *interval : 0;
+    timer->repeats = repeats;
+    timer_arm_event(kernel, timer);
+
+    return SCE_KERNEL_OK;
+}
+
+int timer_get_event_remaining_time(KernelState &kernel, const char *export_name, SceUID timer_id, SceKernelSysClock *remaining) {
+    const TimerPtr timer = lock_and_find(timer_id, kernel.timers, kernel.mutex);
+    if (!timer) {
+        return RET_ERROR(SCE_KERNEL_ERROR_UNKNOWN_TIMER_ID);
+    }
+
+    const std::lock_guard<std::mutex> timer_lock(timer->mutex);
+    if (!timer->event_handle) {
+        return RET_ERROR(SCE_KERNEL_ERROR_TIMER_STOPPED);
+    }
+
+    const std::uint64_t now = kernel.timer_wheel.now();
+    if (remaining) {
+        *remaining = timer->next_event_time > now ? timer->next_event_time - now : 0;
+    }
+
+    return SCE_KERNEL_OK;
+}
+
+static int timer_wait_or_poll(KernelState &kernel, const char *export_name, SceUID thread_id, SceUID timer_id, SceUInt32 *pResultPattern, SceUInt64 *pUserData, SceUInt32 *pTimeout, bool dowait) {
+    const TimerPtr timer = lock_and_find(timer_id, kernel.timers, kernel.mutex);
+    if (!timer) {
+        return RET_ERROR(SCE_KERNEL_ERROR_UNKNOWN_TIMER_ID);
+    }
+
+    if (pResultPattern) {
+        *pResultPattern = SCE_KERNEL_EVENT_TIMER;
+    }
+    if (pUserData) {
+        *pUserData = 0;
+    }
+
+    const ThreadStatePtr thread = lock_and_find(thread_id, kernel.threads, kernel.mutex);
+    if (!thread) {
+        return RET_ERROR(SCE_KERNEL_ERROR_UNKNOWN_THREAD_ID);
+    }
+
+    std::unique_lock<std::mutex> timer_lock(timer->mutex);
+
+    if (timer->event_set) {
+        if (timer->reset_behaviour == TimerState::ResetBehaviour::AUTOMATIC)
+            timer->event_set = false;
+        return SCE_KERNEL_OK;
+    }
+
+    if (!dowait) {
+        return RET_ERROR(SCE_KERNEL_ERROR_EVENT_COND);
+    }
+
+    std::unique_lock<std::mutex> thread_lock(thread->mutex);
+    thread->update_status(ThreadStatus::wait, ThreadStatus::run);
+
+    WaitingThreadData data;
+    data.thread = thread;
+    data.priority = (timer->thread_behaviour == TimerState::ThreadBehaviour::FIFO) ? 0 : thread->priority;
+
+    const uint32_t cancel_count = timer->cancel_count;
+    timer->waiting_threads->push(data);
+    timer_lock.unlock();
+
+    const int result = handle_timeout(kernel, thread, thread_lock, timer_lock, timer->waiting_threads, data, export_name, pTimeout);
+    if (result < 0) {
+        return result;
+    }
+
+    timer_lock.lock();
+    if (timer->cancel_count != cancel_count) {
+        return RET_ERROR(SCE_KERNEL_ERROR_WAIT_CANCEL);
+    }
+
+    return SCE_KERNEL_OK;
+}
+
+int timer_wait(KernelState &kernel, const char *export_name, SceUID thread_id, SceUID timer_id, SceUInt32 *pResultPattern, SceUInt64 *pUserData, SceUInt32 *pTimeout) {
+    return timer_wait_or_poll(kernel, export_name, thread_id, timer_id, pResultPattern, pUserData, pTimeout, true);
+}
+
+int timer_poll(KernelState &kernel, const char *export_name, SceUID thread_id, SceUID timer_id, SceUInt32 *pResultPattern, SceUInt64 *pUserData) {
+    return timer_wait_or_poll(kernel, export_name, thread_id, timer_id, pResultPattern, pUserData, nullptr, false);
+}
+
+int timer_clear(KernelState &kernel, const char *export_name, SceUID timer_id) {
+    const TimerPtr timer = lock_and_find(timer_id, kernel.timers, kernel.mutex);
+    if (!timer) {
+        return RET_ERROR(SCE_KERNEL_ERROR_UNKNOWN_TIMER_ID);
+    }
+
+    const std::lock_guard<std::mutex> timer_lock(timer->mutex);
+    timer->event_set = false;
+
+    return SCE_KERNEL_OK;
+}
+
+int timer_cancel(KernelState &kernel, const char *export_name, SceUID timer_id, SceInt32 *pNumWaitThreads) {
+    const TimerPtr timer = lock_and_find(timer_id, kernel.timers, kernel.mutex);
+    if (!timer) {
+        return RET_ERROR(SCE_KERNEL_ERROR_UNKNOWN_TIMER_ID);
+    }
+
+    std::unique_lock<std::mutex> timer_lock(timer->mutex);
+    timer->cancel_count++;
+    const int woken = timer_wake_waiting_threads(*timer, timer_lock, false);
+
+    if (pNumWaitThreads) {
+        *pNumWaitThreads = woken;
+    }
+
+    return SCE_KERNEL_OK;
+}
@@ -29,10 +29,12 @@
 #include <spdlog/fmt/fmt.h>
 #include <util/log.h>
 
+#include <atomic>
 #include <cassert>
 #include <cstring>
 #include <memory>
 #include <sstream>
+#include <thread>
 
 void ThreadSignal::wait() {
     std::unique_lock<std::mutex> lock(mutex);
@@ -50,6 +52,115 @@ bool ThreadSignal::send() {
     return true;
 }
 
+static constexpr std::size_t RUN_QUEUE_INITIAL_CAPACITY = 8;
+
+RunQueue::RunQueue()
+    : jobs(RUN_QUEUE_INITIAL_CAPACITY) {
+}
+
+ThreadJob &RunQueue::front() {
+    assert(count > 0);
+    return jobs[head];
+}
+
+ThreadJob &RunQueue::operator[](std::size_t index) {
+    assert(index < count);
+    return jobs[(head + index) % jobs.size()];
+}
+
+void RunQueue::grow() {
+    std::vector<ThreadJob> grown(jobs.size() * 2);
+    for (std::size_t i = 0; i < count; i++)
+        grown[i] = std::move(jobs[(head + i) % jobs.size()]);
+
+    jobs = std::move(grown);
+    head = 0;
+}
+
+void RunQueue::push_front(const ThreadJob &job) {
+    if (count == jobs.size())
+        grow();
+
+    head = (head + jobs.size() - 1) % jobs.size();
+    jobs[head] = job;
+    count++;
+}
+
+void RunQueue::push_back(const ThreadJob &job) {
+    if (count == jobs.size())
+        grow();
+
+    jobs[(head + count) % jobs.size()] = job;
+    count++;
+}
+
+void RunQueue::pop_front() {
+    assert(count > 0);
+    // Release what the notify callback captured
+    jobs[head] = ThreadJob();
+    head = (head + 1) % jobs.size();
+    count--;
+}
+
+void RunQueue::clear() {
+    while (!empty())
+        pop_front();
+    head = 0;
+}
+
+// Completion slot of a guest function call. The waiter spins briefly, since most callbacks are short,
+// before blocking on the condition variable.
+struct GuestCallCompletion {
+    static constexpr int SPIN_COUNT = 2000;
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::atomic<bool> done{ false };
+    int result = 0;
+
+    void complete(int res) {
+        result = res;
+        {
+            const std::lock_guard<std::mutex> lock(mutex);
+            done.store(true, std::memory_order_release);
+        }
+        cond.notify_one();
+    }
+
+    int wait() {
+        for (int i = 0; i < SPIN_COUNT; i++) {
+            if (done.load(std::memory_order_acquire))
+                return result;
+            std::this_thread::yield();
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        cond.wait(lock, [&]() { return done.load(std::memory_order_acquire); });
+        return result;
+    }
+};
+
+// Completion slots are reused by each host thread across calls. Guest code run by a call can make nested calls,
+// so there is one slot per nesting depth.
+static thread_local std::vector<std::unique_ptr<GuestCallCompletion>> guest_call_completions;
+static thread_local std::size_t guest_call_depth = 0;
+
+struct GuestCallScope {
+    GuestCallCompletion *completion;
+
+    GuestCallScope() {
+        if (guest_call_depth == guest_call_completions.size())
+            guest_call_completions.push_back(std::make_unique<GuestCallCompletion>());
+
+        completion = guest_call_completions[guest_call_depth++].get();
+        completion->done.store(false, std::memory_order_relaxed);
+    }
+
+    ~GuestCallScope() {
+        guest_call_depth--;
+    }
+};
+
 int ThreadState::init(KernelState &kernel, const char *name, Ptr<const void> entry_point, int init_priority, int stack_size, const SceKernelThreadOptParam *option = nullptr) {
     constexpr size_t KERNEL_TLS_SIZE = 0x800;
 
@@ -70,6 +181,8 @@ int ThreadState::init(KernelState &kernel, const char *name, Ptr<const void> ent
     }
     this->stack_size = stack_size;
     start_tick = rtc_get_ticks(kernel.base_tick.tick);
+    scheduler = &kernel.scheduler;
+    profiler = &kernel.profiler;
 
     cpu = init_cpu(kernel.cpu_backend, kernel.cpu_opt, id, static_cast<std::size_t>(core_num), mem, kernel.cpu_protocol.get());
     if (!cpu) {
@@ -114,17 +227,16 @@ int ThreadState::init(KernelState &kernel, const char *name, Ptr<const void> ent
 
 void ThreadState::flush_callback_requests() {
     if (!callback_requests.empty()) {
-        const auto current = run_queue.begin();
-        // Add resuming job
+        // Replace the current job by a resuming job
+        ThreadJob &current = run_queue.front();
         ThreadJob job;
         job.ctx = save_context(*cpu);
-        job.notify = current->notify;
-        run_queue.erase(current);
-        run_queue.push_front(job);
+        job.notify = std::move(current.notify);
+        current = std::move(job);
 
         // Add requested callback jobs
-        for (auto it = callback_requests.rbegin(); it != callback_requests.rend(); ++it) {
-            run_queue.push_front(*it);
+        for (std::size_t i = callback_requests.size(); i > 0; i--) {
+            run_queue.push_front(callback_requests[i - 1]);
         }
         callback_requests.clear();
         stop(*cpu);
@@ -180,8 +292,6 @@ int ThreadState::start(KernelState &kernel, SceSize arglen, const Ptr<void> &arg
 }
 
 bool ThreadState::run_loop() {
-    int res = 0;
-    RunQueue::iterator current_job;
     std::unique_lock<std::mutex> lock(mutex);
     while (true) {
         switch (to_do) {
@@ -190,6 +300,12 @@ bool ThreadState::run_loop() {
             return true;
         case ThreadToDo::run:
         case ThreadToDo::step:
+            // The CPU is lent to a run_guest_function caller, it hands back what is left when done
+            if (cpu_borrowed) {
+                something_to_do.wait(lock);
+                break;
+            }
+
             // Pop a job to do
             if (run_queue.empty()) {
                 update_status(ThreadStatus::dormant);
@@ -197,53 +313,7 @@ bool ThreadState::run_loop() {
                 break;
             }
 
-            current_job = run_queue.begin();
-            if (!current_job->in_progress) {
-                push_arguments(*current_job);
-                load_context(*cpu, current_job->ctx);
-                current_job->in_progress = true;
-            }
-            update_status(ThreadStatus::run);
-
-            // Run the cpu
-            lock.unlock();
-            if (to_do == ThreadToDo::step) {
-                res = step(*cpu);
-                to_do = ThreadToDo::suspend;
-
-            } else
-                res = run(*cpu);
-            lock.lock();
-
-            // Handle errors
-            if (to_do == ThreadToDo::exit)
-                continue;
-
-            if (res < 0) {
-                LOG_ERROR("Thread {} experienced a unicorn error.", name);
-                if (current_job->notify) {
-                    current_job->notify(0xDEADDEAD);
-                }
-                run_queue.erase(current_job);
-                break;
-            }
-
-            if (hit_breakpoint(*cpu) || to_do == ThreadToDo::suspend) {
-                ThreadJob job;
-                job.ctx = save_context(*cpu);
-                job.notify = current_job->notify;
-                run_queue.erase(current_job);
-                run_queue.push_front(job);
-                update_status(ThreadStatus::suspend);
-                to_do = ThreadToDo::wait;
-            }
-
-            if (res) {
-                if (current_job->notify) {
-                    current_job->notify(read_reg(*cpu, 0));
-                }
-                run_queue.erase(current_job);
-            }
+            run_front_job(lock);
             break;
         case ThreadToDo::wait:
             something_to_do.wait(lock);
@@ -252,6 +322,62 @@ bool ThreadState::run_loop() {
     }
 }
 
+void ThreadState::run_front_job(std::unique_lock<std::mutex> &lock) {
+    ThreadJob *current_job = &run_queue.front();
+    if (!current_job->in_progress) {
+        push_arguments(*current_job);
+        load_context(*cpu, current_job->ctx);
+        current_job->in_progress = true;
+    }
+    update_status(ThreadStatus::run);
+
+    // Run the cpu
+    int res = 0;
+    lock.unlock();
+    scheduler->acquire(*this);
+    if (to_do == ThreadToDo::step) {
+        res = step(*cpu);
+        to_do = ThreadToDo::suspend;
+
+    } else
+        res = run(*cpu);
+    profiler->publish_pc(*this, read_pc(*cpu));
+    scheduler->release(*this);
+    lock.lock();
+
+    // Handle errors
+    if (to_do == ThreadToDo::exit)
+        return;
+
+    // Callbacks requested during the run may have replaced the front job
+    current_job = &run_queue.front();
+
+    if (res < 0) {
+        LOG_ERROR("Thread {} experienced a unicorn error.", name);
+        if (current_job->notify) {
+            current_job->notify(0xDEADDEAD);
+        }
+        run_queue.pop_front();
+        return;
+    }
+
+    if (hit_breakpoint(*cpu) || to_do == ThreadToDo::suspend) {
+        ThreadJob job;
+        job.ctx = save_context(*cpu);
+        job.notify = std::move(current_job->notify);
+        *current_job = std::move(job);
+        update_status(ThreadStatus::suspend);
+        to_do = ThreadToDo::wait;
+    }
+
+    if (res) {
+        if (current_job->notify) {
+            current_job->notify(read_reg(*cpu, 0));
+        }
+        run_queue.pop_front();
+    }
+}
+
 void ThreadState::push_arguments(ThreadJob &job) {
     Address sp = job.ctx.get_sp();
     for (size_t i = 0; i < std::min(job.args_size, static_cast<size_t>(4)); i++) {
@@ -266,7 +392,12 @@ void ThreadState::push_arguments(ThreadJob &job) {
     job.ctx.set_sp(sp);
 }
 
-int ThreadState::run_guest_function(Address callback_address, const std::vector<uint32_t> &args) {
+int ThreadState::run_guest_function(Address callback_address, std::initializer_list<uint32_t> args) {
+    assert(args.size() <= MAX_ARGS_WORDS);
+
+    GuestCallScope scope;
+    GuestCallCompletion *completion = scope.completion;
+
     std::unique_lock<std::mutex> thread_lock(mutex);
     ThreadJob job;
     CPUContext ctx = init_cpu_ctx;
@@ -275,30 +406,35 @@ int ThreadState::run_guest_function(Address callback_address, const std::vector<
     ctx.set_pc(callback_address);
     ctx.set_lr(cpu->halt_instruction_pc);
     job.ctx = ctx;
+    job.notify = [completion](int res) { completion->complete(res); };
 
-    std::mutex notify_mutex;
-    std::condition_variable notify_cond;
-    bool notify_done = false;
-    int notify_res = 0;
-
-    job.notify = [&](int res) {
-        std::lock_guard<std::mutex> lock(notify_mutex);
-        notify_done = true;
-        notify_res = res;
-        notify_cond.notify_one();
-    };
-
-    // Push a job
-    to_do = ThreadToDo::run;
-    run_queue.push_back(job);
-    something_to_do.notify_one();
+    if ((to_do == ThreadToDo::wait) && run_queue.empty() && !cpu_borrowed) {
+        // Nobody is using the CPU: run the job on the calling host thread instead of
+        // waking up the thread and waiting for it.
+        cpu_borrowed = true;
+        to_do = ThreadToDo::run;
+        run_queue.push_back(job);
+        while (!completion->done.load(std::memory_order_acquire) && (to_do == ThreadToDo::run) && !run_queue.empty())
+            run_front_job(thread_lock);
+        cpu_borrowed = false;
+
+        if ((to_do == ThreadToDo::run) && run_queue.empty()) {
+            update_status(ThreadStatus::dormant);
+            to_do = ThreadToDo::wait;
+        } else {
+            // Suspended, exiting or more jobs queued meanwhile: let the thread take over
+            something_to_do.notify_one();
+        }
+    } else {
+        // Push a job
+        to_do = ThreadToDo::run;
+        run_queue.push_back(job);
+        something_to_do.notify_one();
+    }
 
     // Wait until job finishes
     thread_lock.unlock();
-    std::unique_lock<std::mutex> lock(notify_mutex);
-    notify_cond.wait(lock, [&]() { return notify_done; });
-
-    return notify_res;
+    return completion->wait();
 }
 
 void ThreadState::stop_loop() {
@@ -336,15 +472,17 @@ Address ThreadState::stack_top() const {
 void ThreadState::clear_run_queue() {
     const auto lock = std::lock_guard(mutex);
     if (!run_queue.empty()) {
-        const auto top = run_queue.begin();
-        if (top->notify) {
-            top->notify(read_reg(*cpu, 0));
+        ThreadJob &top = run_queue.front();
+        if (top.notify) {
+            top.notify(read_reg(*cpu, 0));
         }
         run_queue.clear();
     }
 }
 
-void ThreadState::request_callback(Address callback_address, const std::vector<uint32_t> &args, const std::function<void(int res)> notify) {
+void ThreadState::request_callback(Address callback_address, std::initializer_list<uint32_t> args, const std::function<void(int res)> notify) {
+    assert(args.size() <= MAX_ARGS_WORDS);
+
     const auto thread_lock = std::lock_guard(mutex);
     ThreadJob job;
     CPUContext ctx = save_context(*cpu);
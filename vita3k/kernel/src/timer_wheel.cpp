@@ -0,0 +1,292 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <kernel/timer_wheel.h>
+
+#include <kernel/thread/thread_state.h>
+
+#include <util/log.h>
+
+#include <algorithm>
+
+TimerWheel::TimerWheel() {
+    base_host = Clock::now();
+    base_guest_us = std::chrono::duration_cast<std::chrono::microseconds>(base_host.time_since_epoch()).count();
+    current_tick = base_guest_us / TICK_US;
+}
+
+TimerWheel::~TimerWheel() {
+    stop();
+}
+
+void TimerWheel::start() {
+    const std::lock_guard<std::mutex> guard(mutex);
+    if (thread)
+        return;
+
+    quit = false;
+    thread = std::make_unique<std::thread>(&TimerWheel::thread_loop, this);
+}
+
+void TimerWheel::stop() {
+    {
+        const std::lock_guard<std::mutex> guard(mutex);
+        if (!thread)
+            return;
+
+        quit = true;
+    }
+    cond.notify_all();
+    thread->join();
+
+    // Release everything still waiting on a one shot timer, so no guest thread stays blocked forever
+    std::vector<Callback> pending;
+    {
+        const std::lock_guard<std::mutex> guard(mutex);
+        thread.reset();
+        for (auto &[_, timer] : timers) {
+            if (!timer.period_us)
+                pending.push_back(std::move(timer.callback));
+        }
+        timers.clear();
+        for (auto &level : levels) {
+            for (auto &slot : level.slots)
+                slot.clear();
+            level.occupied = 0;
+        }
+    }
+
+    for (auto &callback : pending)
+        callback();
+}
+
+std::uint64_t TimerWheel::now_locked() const {
+    const std::chrono::duration<double, std::micro> host_elapsed = Clock::now() - base_host;
+    return base_guest_us + static_cast<std::uint64_t>(host_elapsed.count() * speed);
+}
+
+std::uint64_t TimerWheel::now() const {
+    const std::lock_guard<std::mutex> guard(mutex);
+    return now_locked();
+}
+
+TimerWheel::Clock::time_point TimerWheel::host_time_of(std::uint64_t guest_time_us) const {
+    if (guest_time_us <= base_guest_us)
+        return base_host;
+
+    const std::chrono::duration<double, std::micro> host_offset((guest_time_us - base_guest_us) / speed);
+    return base_host + std::chrono::duration_cast<Clock::duration>(host_offset);
+}
+
+void TimerWheel::set_speed(double speed) {
+    if (speed <= 0.0) {
+        LOG_WARN("Ignoring invalid timer speed {}", speed);
+        return;
+    }
+
+    {
+        const std::lock_guard<std::mutex> guard(mutex);
+        // Rebase so that guest time stays continuous across the change
+        const Clock::time_point host_now = Clock::now();
+        base_guest_us = now_locked();
+        base_host = host_now;
+        this->speed = speed;
+    }
+    cond.notify_all();
+}
+
+double TimerWheel::get_speed() const {
+    const std::lock_guard<std::mutex> guard(mutex);
+    return speed;
+}
+
+void TimerWheel::place(Handle handle, std::uint64_t expires_tick) {
+    const std::uint64_t delta = expires_tick - current_tick;
+
+    int level = 0;
+    while ((level < LEVEL_COUNT - 1) && (delta >= (1ULL << (SLOT_BITS * (level + 1)))))
+        level++;
+
+    // Timers beyond the wheel range sit in the furthest slot and get placed again when it is cascaded
+    if (delta >= (1ULL << (SLOT_BITS * LEVEL_COUNT)))
+        expires_tick = current_tick + (1ULL << (SLOT_BITS * LEVEL_COUNT)) - 1;
+
+    const std::size_t slot = (expires_tick >> (SLOT_BITS * level)) & SLOT_MASK;
+    levels[level].slots[slot].push_back(handle);
+    levels[level].occupied |= 1ULL << slot;
+}
+
+void TimerWheel::cascade(int level, std::size_t slot) {
+    std::vector<Handle> handles;
+    std::swap(handles, levels[level].slots[slot]);
+    levels[level].occupied &= ~(1ULL << slot);
+
+    for (const Handle handle : handles)
+        place(handle, timers[handle].expires_tick);
+}
+
+void TimerWheel::advance(std::vector<Callback> &due) {
+    current_tick++;
+
+    for (int level = 1; level < LEVEL_COUNT; level++) {
+        if ((current_tick >> (SLOT_BITS * (level - 1))) & SLOT_MASK)
+            break;
+        cascade(level, (current_tick >> (SLOT_BITS * level)) & SLOT_MASK);
+    }
+
+    const std::size_t slot = current_tick & SLOT_MASK;
+    std::vector<Handle> handles;
+    std::swap(handles, levels[0].slots[slot]);
+    levels[0].occupied &= ~(1ULL << slot);
+
+    for (const Handle handle : handles) {
+        const auto timer = timers.find(handle);
+        if (timer->second.period_us) {
+            due.push_back(timer->second.callback);
+            timer->second.deadline_us += timer->second.period_us;
+            timer->second.expires_tick = std::max((timer->second.deadline_us + TICK_US - 1) / TICK_US, current_tick + 1);
+            place(handle, timer->second.expires_tick);
+        } else {
+            due.push_back(std::move(timer->second.callback));
+            timers.erase(timer);
+        }
+    }
+}
+
+std::optional<std::uint64_t> TimerWheel::next_event_tick() const {
+    std::optional<std::uint64_t> next;
+
+    for (int level = 0; level < LEVEL_COUNT; level++) {
+        if (!levels[level].occupied)
+            continue;
+
+        // For upper levels this is the tick the slot gets cascaded at
+        const int shift = SLOT_BITS * level;
+        const std::uint64_t base = current_tick >> shift;
+        for (std::uint64_t i = 1; i <= SLOT_COUNT; i++) {
+            if (levels[level].occupied & (1ULL << ((base + i) & SLOT_MASK))) {
+                const std::uint64_t tick = (base + i) << shift;
+                if (!next || (tick < *next))
+                    next = tick;
+                break;
+            }
+        }
+    }
+
+    return next;
+}
+
+void TimerWheel::thread_loop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    std::vector<Callback> due;
+
+    while (!quit) {
+        const std::uint64_t target_tick = now_locked() / TICK_US;
+        while (current_tick < target_tick) {
+            // Jump straight over the ticks where nothing is due
+            const auto next = next_event_tick();
+            if (!next || (*next > target_tick)) {
+                current_tick = target_tick;
+                break;
+            }
+            current_tick = *next - 1;
+            advance(due);
+        }
+
+        if (!due.empty()) {
+            lock.unlock();
+            for (auto &callback : due)
+                callback();
+            due.clear();
+            lock.lock();
+            continue;
+        }
+
+        const auto next = next_event_tick();
+        if (next)
+            cond.wait_until(lock, host_time_of(*next * TICK_US));
+        else
+            cond.wait(lock);
+    }
+}
+
+TimerWheel::Handle TimerWheel::schedule_at(std::uint64_t guest_time_us, Callback callback, std::uint64_t period_us) {
+    Handle handle;
+    {
+        const std::lock_guard<std::mutex> guard(mutex);
+        handle = next_handle++;
+
+        const std::uint64_t expires_tick = std::max((guest_time_us + TICK_US - 1) / TICK_US, current_tick + 1);
+        timers.emplace(handle, Timer{ guest_time_us, period_us, expires_tick, std::move(callback) });
+        place(handle, expires_tick);
+    }
+    cond.notify_all();
+
+    return handle;
+}
+
+TimerWheel::Handle TimerWheel::schedule_after(std::uint64_t delay_us, Callback callback, std::uint64_t period_us) {
+    return schedule_at(now() + delay_us, std::move(callback), period_us);
+}
+
+bool TimerWheel::cancel(Handle handle) {
+    const std::lock_guard<std::mutex> guard(mutex);
+    const auto timer = timers.find(handle);
+    if (timer == timers.end())
+        return false;
+
+    for (auto &level : levels) {
+        for (std::size_t slot = 0; slot < SLOT_COUNT; slot++) {
+            auto &handles = level.slots[slot];
+            const auto found = std::find(handles.begin(), handles.end(), handle);
+            if (found == handles.end())
+                continue;
+
+            handles.erase(found);
+            if (handles.empty())
+                level.occupied &= ~(1ULL << slot);
+            timers.erase(timer);
+            return true;
+        }
+    }
+
+    timers.erase(timer);
+    return true;
+}
+
+bool TimerWheel::wait_for(const ThreadStatePtr &thread, std::unique_lock<std::mutex> &thread_lock, std::uint64_t timeout_us, const std::function<bool()> &pred) {
+    if (pred())
+        return true;
+
+    // Only touched with the thread mutex held
+    const auto expired = std::make_shared<bool>(false);
+    const Handle handle = schedule_after(timeout_us, [thread, expired]() {
+        const std::lock_guard<std::mutex> guard(thread->mutex);
+        *expired = true;
+        thread->status_cond.notify_all();
+    });
+
+    thread->status_cond.wait(thread_lock, [&] { return *expired || pred(); });
+    cancel(handle);
+
+    return pred();
+}
+
+void TimerWheel::sleep(const ThreadStatePtr &thread, std::uint64_t delay_us) {
+    std::unique_lock<std::mutex> thread_lock(thread->mutex);
+    wait_for(thread, thread_lock, delay_us, [] { return false; });
+}
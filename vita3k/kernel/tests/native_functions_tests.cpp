@@ -0,0 +1,61 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <kernel/native_functions.h>
+
+#include <gtest/gtest.h>
+
+TEST(native_functions, arm_movable) {
+    EXPECT_TRUE(is_movable_arm(0xE92D4010)); // PUSH {r4, lr}
+    EXPECT_TRUE(is_movable_arm(0xE1A00001)); // MOV r0, r1
+    EXPECT_TRUE(is_movable_arm(0xE3520000)); // CMP r2, #0
+}
+
+TEST(native_functions, arm_not_movable) {
+    EXPECT_FALSE(is_movable_arm(0xE92D8010)); // PUSH {r4, pc}
+    EXPECT_FALSE(is_movable_arm(0xE8BD8010)); // POP {r4, pc}
+    EXPECT_FALSE(is_movable_arm(0x01A00001)); // MOVEQ r0, r1
+    EXPECT_FALSE(is_movable_arm(0xEA000000)); // B
+    EXPECT_FALSE(is_movable_arm(0xEB000000)); // BL
+    EXPECT_FALSE(is_movable_arm(0xEF000055)); // SVC 0x55
+    EXPECT_FALSE(is_movable_arm(0xE28F0004)); // ADD r0, pc, #4
+    EXPECT_FALSE(is_movable_arm(0xE59F0004)); // LDR r0, [pc, #4]
+    EXPECT_FALSE(is_movable_arm(0xE1A0F00E)); // MOV pc, lr
+}
+
+TEST(native_functions, thumb16_movable) {
+    EXPECT_TRUE(is_movable_thumb16(0xB510)); // PUSH {r4, lr}
+    EXPECT_TRUE(is_movable_thumb16(0x2000)); // MOVS r0, #0
+    EXPECT_TRUE(is_movable_thumb16(0x4008)); // ANDS r0, r1
+    EXPECT_TRUE(is_movable_thumb16(0x4608)); // MOV r0, r1
+}
+
+TEST(native_functions, thumb16_not_movable) {
+    EXPECT_FALSE(is_movable_thumb16(0x4678)); // MOV r0, pc
+    EXPECT_FALSE(is_movable_thumb16(0x4770)); // BX lr
+    EXPECT_FALSE(is_movable_thumb16(0x4801)); // LDR r0, [pc, #4]
+    EXPECT_FALSE(is_movable_thumb16(0xBD10)); // POP {r4, pc}
+    EXPECT_FALSE(is_movable_thumb16(0xE000)); // B
+    EXPECT_FALSE(is_movable_thumb16(0xDF55)); // SVC 0x55
+}
+
+TEST(native_functions, thumb32_movable) {
+    EXPECT_TRUE(is_movable_thumb32(0x4FF0E92D)); // PUSH.W {r4-r11, lr}
+    EXPECT_FALSE(is_movable_thumb32(0x8FF0E92D)); // PUSH.W with pc in the list
+    EXPECT_FALSE(is_movable_thumb32(0x0000F04F)); // MOV.W r0, #0
+    EXPECT_FALSE(is_movable_thumb32(0xF800F000)); // BL
+}
@@ -0,0 +1,127 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <kernel/timer_wheel.h>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+// Records which timers fired, in order, along with the guest time they fired at
+struct FireLog {
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::vector<int> ids;
+    std::vector<std::uint64_t> times;
+
+    TimerWheel::Callback record(TimerWheel &wheel, int id) {
+        return [this, &wheel, id]() {
+            const std::lock_guard<std::mutex> lock(mutex);
+            ids.push_back(id);
+            times.push_back(wheel.now());
+            cond.notify_all();
+        };
+    }
+
+    bool wait_for_count(std::size_t count) {
+        std::unique_lock<std::mutex> lock(mutex);
+        return cond.wait_for(lock, std::chrono::seconds(5), [&] { return ids.size() >= count; });
+    }
+};
+
+} // namespace
+
+TEST(timer_wheel, expires_in_deadline_order) {
+    TimerWheel wheel;
+    wheel.set_speed(100.0);
+    wheel.start();
+
+    FireLog log;
+    const std::uint64_t now = wheel.now();
+    wheel.schedule_at(now + 30000, log.record(wheel, 3));
+    wheel.schedule_at(now + 10000, log.record(wheel, 1));
+    wheel.schedule_at(now + 20000, log.record(wheel, 2));
+
+    ASSERT_TRUE(log.wait_for_count(3));
+    wheel.stop();
+
+    EXPECT_EQ(log.ids, (std::vector<int>{ 1, 2, 3 }));
+    EXPECT_GE(log.times[0], now + 10000);
+    EXPECT_GE(log.times[1], now + 20000);
+    EXPECT_GE(log.times[2], now + 30000);
+}
+
+TEST(timer_wheel, cancelled_timer_does_not_fire) {
+    TimerWheel wheel;
+    wheel.set_speed(100.0);
+    wheel.start();
+
+    FireLog log;
+    const TimerWheel::Handle cancelled = wheel.schedule_after(10000, log.record(wheel, 1));
+    const TimerWheel::Handle fired = wheel.schedule_after(20000, log.record(wheel, 2));
+    EXPECT_TRUE(wheel.cancel(cancelled));
+    EXPECT_FALSE(wheel.cancel(cancelled));
+
+    ASSERT_TRUE(log.wait_for_count(1));
+    wheel.stop();
+
+    EXPECT_EQ(log.ids, (std::vector<int>{ 2 }));
+    EXPECT_FALSE(wheel.cancel(fired));
+}
+
+TEST(timer_wheel, cascades_from_upper_levels) {
+    TimerWheel wheel;
+    wheel.set_speed(1000.0);
+    wheel.start();
+
+    // One deadline per level: 100us ticks with 64 slots per level
+    FireLog log;
+    const std::uint64_t now = wheel.now();
+    const std::uint64_t deadlines[] = { 3000, 300000, 3000000, 30000000 };
+    for (int i = 3; i >= 0; --i)
+        wheel.schedule_at(now + deadlines[i], log.record(wheel, i));
+
+    ASSERT_TRUE(log.wait_for_count(4));
+    wheel.stop();
+
+    EXPECT_EQ(log.ids, (std::vector<int>{ 0, 1, 2, 3 }));
+    for (int i = 0; i < 4; ++i)
+        EXPECT_GE(log.times[i], now + deadlines[i]);
+}
+
+TEST(timer_wheel, periodic_timer_fires_until_cancelled) {
+    TimerWheel wheel;
+    wheel.set_speed(100.0);
+    wheel.start();
+
+    FireLog log;
+    const std::uint64_t now = wheel.now();
+    const TimerWheel::Handle handle = wheel.schedule_at(now + 10000, log.record(wheel, 1), 10000);
+
+    ASSERT_TRUE(log.wait_for_count(3));
+    EXPECT_TRUE(wheel.cancel(handle));
+    wheel.stop();
+
+    for (std::size_t i = 0; i < 3; ++i)
+        EXPECT_GE(log.times[i], now + 10000 * (i + 1));
+}
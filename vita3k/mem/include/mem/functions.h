@@ -29,6 +29,7 @@ Address alloc(MemState &state, size_t size, const char *name);
 Address alloc(MemState &state, size_t size, const char *name, unsigned int alignment);
 bool add_write_protect(MemState &state, Address addr, const size_t size, WriteProtectCallback callback);
 bool remove_write_protect(MemState &state, Address addr);
+bool is_write_protected(MemState &state, Address addr, size_t size);
 bool is_valid_addr(const MemState &state, Address addr);
 bool is_valid_addr_range(const MemState &state, Address start, Address end);
 bool handle_access_violation(MemState &state, uint8_t *addr, bool write) noexcept;
@@ -37,3 +38,8 @@ Address alloc_at(MemState &state, Address address, size_t size, const char *name
 void free(MemState &state, Address address);
 uint32_t mem_available(MemState &state);
 const char *mem_name(Address address, MemState &state);
+
+// Guest page table for the JIT when fastmem can't be used
+HostPageTable *get_host_page_table(MemState &state);
+// Route accesses to the pages covering this range through the JIT memory callbacks (nestable)
+void set_slow_pages(MemState &state, Address addr, size_t size, bool slow);
@@ -24,6 +24,7 @@
 #include <map>
 #include <mutex>
 #include <set>
+#include <vector>
 
 struct MemPage {
     uint32_t allocated : 4;
@@ -68,5 +69,9 @@ struct MemState {
     BitmapAllocator allocator;
     WriteProtectTree write_protect_tree;
 
+    // Only built once a CPU asks for it, see get_host_page_table
+    std::unique_ptr<HostPageTable> host_page_table;
+    std::vector<uint32_t> slow_page_refs;
+
     PageNameMap page_name_map;
 };
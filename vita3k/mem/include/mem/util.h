@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <array>
 #include <functional>
 #include <map>
 #include <memory>
@@ -29,6 +30,12 @@ struct MemState;
 typedef uint32_t Address;
 typedef std::function<void()> WriteProtectCallback;
 
+// Host pointer of each 4 KB guest page, in the layout the JIT page table expects.
+// Null entries (unmapped pages and pages flagged slow) make the JIT go through its memory callbacks.
+constexpr size_t HOST_PAGE_BITS = 12;
+constexpr size_t HOST_PAGE_TABLE_SIZE = size_t(1) << (32 - HOST_PAGE_BITS);
+typedef std::array<uint8_t *, HOST_PAGE_TABLE_SIZE> HostPageTable;
+
 constexpr size_t KB(size_t kb) {
     return kb * 1024;
 }
@@ -46,6 +46,7 @@ static void register_access_violation_handler(AccessViolationHandler handler);
 
 static Address alloc_inner(MemState &state, uint32_t start_page, int page_count, const char *name, const bool force);
 static void delete_memory(uint8_t *memory);
+static void update_host_page_table(MemState &state, Address addr, size_t size);
 static void delete_pagetable(MemPage *page_table);
 
 bool init(MemState &state) {
@@ -165,9 +166,59 @@ static Address alloc_inner(MemState &state, uint32_t start_page, int page_count,
         state.page_name_map.emplace(page_num, name);
     }
 
+    update_host_page_table(state, addr, size);
+
     return addr;
 }
 
+static void update_host_page_table(MemState &state, Address addr, size_t size) {
+    if (!state.host_page_table)
+        return;
+
+    HostPageTable &table = *state.host_page_table;
+    const size_t first = addr >> HOST_PAGE_BITS;
+    const size_t last = std::min((static_cast<size_t>(addr) + size + (size_t(1) << HOST_PAGE_BITS) - 1) >> HOST_PAGE_BITS, HOST_PAGE_TABLE_SIZE);
+    for (size_t page = first; page < last; page++) {
+        const Address page_addr = static_cast<Address>(page << HOST_PAGE_BITS);
+        const size_t mem_page = page_addr / state.page_size;
+        // The null page is allocated but never accessible
+        const bool mapped = (mem_page != 0) && (state.allocator.free_slot_count(mem_page, mem_page + 1) == 0);
+        table[page] = (mapped && !state.slow_page_refs[page]) ? &state.memory[page_addr] : nullptr;
+    }
+}
+
+HostPageTable *get_host_page_table(MemState &state) {
+    const std::lock_guard<std::mutex> lock(state.generation_mutex);
+    if (!state.host_page_table) {
+        state.host_page_table = std::make_unique<HostPageTable>();
+        // Pages may have been flagged slow before the first JIT needed the table
+        if (state.slow_page_refs.empty())
+            state.slow_page_refs.assign(HOST_PAGE_TABLE_SIZE, 0);
+        update_host_page_table(state, 0, TOTAL_MEM_SIZE);
+    }
+
+    return state.host_page_table.get();
+}
+
+void set_slow_pages(MemState &state, Address addr, size_t size, bool slow) {
+    const std::lock_guard<std::mutex> lock(state.generation_mutex);
+    if (!size)
+        return;
+
+    if (state.slow_page_refs.empty())
+        state.slow_page_refs.assign(HOST_PAGE_TABLE_SIZE, 0);
+
+    const size_t first = addr >> HOST_PAGE_BITS;
+    const size_t last = std::min((static_cast<size_t>(addr) + size + (size_t(1) << HOST_PAGE_BITS) - 1) >> HOST_PAGE_BITS, HOST_PAGE_TABLE_SIZE);
+    for (size_t page = first; page < last; page++) {
+        if (slow)
+            state.slow_page_refs[page]++;
+        else if (state.slow_page_refs[page])
+            state.slow_page_refs[page]--;
+    }
+    update_host_page_table(state, first << HOST_PAGE_BITS, (last - first) << HOST_PAGE_BITS);
+}
+
 Address alloc(MemState &state, size_t size, const char *name, unsigned int alignment) {
     if (alignment == 0)
         return alloc(state, size, name);
@@ -187,6 +238,7 @@ Address alloc(MemState &state, size_t size, const char *name, unsigned int align
         page.allocated = 0;
         align_page.allocated = 1;
         align_page.size = page.size - remnant_front;
+        update_host_page_table(state, addr, remnant_front * state.page_size);
     }
 
     return align_addr;
@@ -309,6 +361,23 @@ bool remove_write_protect(MemState &state, Address addr) {
     return true;
 }
 
+bool is_write_protected(MemState &state, Address addr, size_t size) {
+    const std::lock_guard<std::mutex> lock(state.protect_mutex);
+    if (!size || state.write_protect_tree.empty())
+        return false;
+
+    // Protected ranges never overlap, start from the last one beginning at or before addr
+    const uint64_t end = static_cast<uint64_t>(addr) + size;
+    auto it = state.write_protect_tree.upper_bound(WriteProtect(addr));
+    if (it != state.write_protect_tree.begin())
+        --it;
+    for (; it != state.write_protect_tree.end() && it->addr < end; ++it) {
+        if (it->addr + it->size > addr)
+            return true;
+    }
+    return false;
+}
+
 Address alloc(MemState &state, size_t size, const char *name) {
     const std::lock_guard<std::mutex> lock(state.generation_mutex);
     const size_t page_count = align(size, state.page_size) / state.page_size;
@@ -356,6 +425,8 @@ void free(MemState &state, Address address) {
 #else
     mprotect(memory, page.size * state.page_size, PROT_NONE);
 #endif
+
+    update_host_page_table(state, page_num * state.page_size, page.size * state.page_size);
 }
 
 uint32_t mem_available(MemState &state) {
@@ -17,6 +17,7 @@
 
 #include "SceAudio.h"
 
+#include <audio/functions.h>
 #include <util/lock_and_find.h>
 
 enum SceAudioOutMode {
@@ -81,19 +82,11 @@ EXPORT(int, sceAudioOutOpenPort, SceAudioOutPortType type, int len, int freq, Sc
     }
 
     const int channels = (mode == SCE_AUDIO_OUT_MODE_MONO) ? 1 : 2;
-    const AudioStreamPtr stream(SDL_NewAudioStream(AUDIO_S16LSB, channels, freq, host.audio.ro.spec.format, host.audio.ro.spec.channels, host.audio.ro.spec.freq), SDL_FreeAudioStream);
-    if (!stream) {
+    const int port_id = open_out_port(host.audio, len, freq, channels);
+    if (!port_id) {
         return RET_ERROR(SCE_AUDIO_OUT_ERROR_NOT_OPENED);
     }
 
-    const AudioOutPortPtr port = std::make_shared<AudioOutPort>();
-    port->ro.len_bytes = len * channels * sizeof(int16_t);
-    port->shared.stream = stream;
-
-    const std::lock_guard<std::mutex> lock(host.audio.shared.mutex);
-    const int port_id = host.audio.shared.next_port_id++;
-    host.audio.shared.out_ports.emplace(port_id, port);
-
     return port_id;
 }
 
@@ -108,22 +101,11 @@ EXPORT(int, sceAudioOutOutput, int port, const void *buf) {
         return RET_ERROR(SCE_AUDIO_OUT_ERROR_INVALID_PORT);
     }
 
-    // Put audio to the port's stream and see how much is left to play.
-    std::unique_lock<std::mutex> lock(prt->shared.mutex);
-    SDL_AudioStreamPut(prt->shared.stream.get(), buf, prt->ro.len_bytes);
-    const int available = SDL_AudioStreamAvailable(prt->shared.stream.get());
-
-    // If there's lots of audio left to play, stop this thread.
-    // The audio callback will wake it up later when it's running out of data.
-    if (available > host.audio.ro.spec.size) {
-        prt->shared.thread = thread_id;
-        lock.unlock();
-
-        std::unique_lock<std::mutex> mlock(thread->mutex);
-        if (thread->status != ThreadStatus::run)
-            return 0;
-        thread->status = ThreadStatus::wait;
-        thread->status_cond.wait(mlock, [&]() { return thread->status == ThreadStatus::run; });
+    // Queue the audio and block like the hardware does, until the port takes the grain in.
+    const uint64_t now = host.kernel.timer_wheel.now();
+    const uint64_t accepted = output_to_port(host.audio, *prt, buf, now);
+    if (accepted > now) {
+        host.kernel.timer_wheel.sleep(thread, accepted - now);
     }
 
     return 0;
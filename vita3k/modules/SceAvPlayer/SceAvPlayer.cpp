@@ -79,19 +79,30 @@ struct SceAvPlayerEventManager {
     Ptr<void> event_callback;
 };
 
+// Guest buffers the player decodes into, allocated once it knows their size
+struct PlayerBuffers {
+    uint32_t size = 0;
+    std::vector<Ptr<uint8_t>> buffers;
+
+    // Replaced buffers the guest may still read the last frames from, freed once as many frames were delivered
+    // from the new ones as the player reserves
+    std::vector<Ptr<uint8_t>> retired;
+    uint32_t retired_deliveries_left = 0;
+};
+
 struct PlayerInfoState {
     PlayerState player;
 
-    // Framebuffer count is defined in info. I'm being safe now and forcing it to 4 (even though its usually 2).
-    constexpr static uint32_t RING_BUFFER_COUNT = 4;
-
-    uint32_t video_buffer_ring_index = 0;
-    uint32_t video_buffer_size = 0;
-    std::array<Ptr<uint8_t>, RING_BUFFER_COUNT> video_buffer;
+    PlayerBuffers video_buffers;
+    PlayerBuffers audio_buffers;
 
-    uint32_t audio_buffer_ring_index = 0;
-    uint32_t audio_buffer_size = 0;
-    std::array<Ptr<uint8_t>, RING_BUFFER_COUNT> audio_buffer;
+    // Last frames given to the guest, with the buffer they were delivered in
+    bool has_video_frame = false;
+    PlayerFrame video_frame;
+    Ptr<uint8_t> video_data;
+    bool has_audio_frame = false;
+    PlayerFrame audio_frame;
+    Ptr<uint8_t> audio_data;
 
     bool do_loop = false;
     bool paused = false;
@@ -201,28 +212,44 @@ static inline uint64_t current_time() {
         .count();
 }
 
-static Ptr<uint8_t> get_buffer(const PlayerPtr &player, MediaType media_type,
-    MemState &mem, uint32_t size, bool new_frame = true) {
-    uint32_t &buffer_size = media_type == MediaType::VIDEO ? player->video_buffer_size : player->audio_buffer_size;
-    uint32_t &ring_index = media_type == MediaType::VIDEO ? player->video_buffer_ring_index : player->audio_buffer_ring_index;
-    auto &buffers = media_type == MediaType::VIDEO ? player->video_buffer : player->audio_buffer;
-
-    if (buffer_size < size) {
-        buffer_size = size;
-        for (uint32_t a = 0; a < PlayerInfoState::RING_BUFFER_COUNT; a++) {
-            if (buffers[a])
-                free(mem, buffers[a]);
-            std::string alloc_name = fmt::format("AvPlayer {} Media Ring {}",
-                media_type == MediaType::VIDEO ? "Video" : "Audio", a);
-
-            buffers[a] = alloc(mem, size, alloc_name.c_str());
-        }
+// Replaces the buffers of a stream when the player waits for bigger ones
+static void update_buffers(const PlayerPtr &player, MediaType media_type, MemState &mem) {
+    const PlayerMediaType type = media_type == MediaType::VIDEO ? PlayerMediaType::VIDEO : PlayerMediaType::AUDIO;
+    const uint32_t size = player->player.get_required_buffer_size(type);
+    if (!size)
+        return;
+
+    PlayerBuffers &ring = media_type == MediaType::VIDEO ? player->video_buffers : player->audio_buffers;
+    auto &buffers = ring.buffers;
+    const uint32_t count = media_type == MediaType::VIDEO ? PlayerState::VIDEO_BUFFER_COUNT : PlayerState::AUDIO_BUFFER_COUNT;
+
+    // The frames delivered last may be in use by the guest, keep the old buffers until they are replaced
+    ring.retired.insert(ring.retired.end(), buffers.begin(), buffers.end());
+    ring.retired_deliveries_left = PlayerState::RESERVED_BUFFERS;
+
+    ring.size = size;
+    buffers.resize(count);
+    std::vector<uint8_t *> host_buffers(count);
+    for (uint32_t a = 0; a < count; a++) {
+        std::string alloc_name = fmt::format("AvPlayer {} Media Ring {}",
+            media_type == MediaType::VIDEO ? "Video" : "Audio", a);
+
+        buffers[a] = alloc(mem, size, alloc_name.c_str());
+        host_buffers[a] = buffers[a].get(mem);
+    }
+
+    player->player.set_buffers(type, host_buffers, size);
+}
+
+// Returns the guest buffer holding a frame just received, freeing the retired buffers the guest is done with
+static Ptr<uint8_t> deliver_frame(PlayerBuffers &ring, const PlayerFrame &frame, MemState &mem) {
+    if (!ring.retired.empty() && (--ring.retired_deliveries_left == 0)) {
+        for (const Ptr<uint8_t> &buffer : ring.retired)
+            free(mem, buffer.address());
+        ring.retired.clear();
     }
 
-    if (new_frame)
-        ring_index++;
-    Ptr<uint8_t> buffer = buffers[ring_index % PlayerInfoState::RING_BUFFER_COUNT];
-    return buffer;
+    return ring.buffers[frame.buffer_index];
 }
 
 void run_event_callback(HostState &host, SceUID thread_id, const PlayerPtr player_info, uint32_t event_id, uint32_t source_id, Ptr<void> event_data) {
@@ -295,7 +322,7 @@ EXPORT(uint64_t, sceAvPlayerCurrentTime, SceUID player_handle) {
     const auto state = host.kernel.obj_store.get<AvPlayerState>();
     const PlayerPtr &player_info = lock_and_find(player_handle, state->players, state->mutex);
 
-    return player_info->player.last_timestamp;
+    return player_info->video_frame.timestamp;
 }
 
 EXPORT(int, sceAvPlayerDisableStream) {
@@ -323,31 +350,33 @@ EXPORT(bool, sceAvPlayerGetAudioData, SceUID player_handle, SceAvPlayerFrameInfo
     if (!player_info) {
         return false;
     }
-    Ptr<uint8_t> buffer;
 
     if (player_info->paused) {
         if (REJECT_DATA_ON_PAUSE) {
             return false;
-        } else {
-            // This is probably incorrect and will make weird noises :P
-            buffer = get_buffer(player_info, MediaType::AUDIO, host.mem,
-                player_info->player.last_sample_count * sizeof(int16_t) * player_info->player.last_channels, true);
         }
+        // Otherwise this is probably incorrect and will make weird noises :P
     } else {
-        std::vector<int16_t> data = player_info->player.receive_audio();
-
-        if (data.empty())
+        PlayerFrame frame;
+        if (!player_info->player.receive(PlayerMediaType::AUDIO, frame)) {
+            update_buffers(player_info, MediaType::AUDIO, host.mem);
             return false;
+        }
 
-        buffer = get_buffer(player_info, MediaType::AUDIO, host.mem, (uint32_t)data.size() * sizeof(int16_t), false);
-        std::memcpy(buffer.get(host.mem), data.data(), data.size() * sizeof(int16_t));
+        player_info->audio_frame = frame;
+        player_info->audio_data = deliver_frame(player_info->audio_buffers, frame, host.mem);
+        player_info->has_audio_frame = true;
     }
 
-    frame_info->timestamp = player_info->player.last_timestamp;
-    frame_info->stream_details.audio.channels = player_info->player.last_channels;
-    frame_info->stream_details.audio.sample_rate = player_info->player.last_sample_rate;
-    frame_info->stream_details.audio.size = player_info->player.last_channels * player_info->player.last_sample_count * sizeof(int16_t);
-    frame_info->data = buffer;
+    if (!player_info->has_audio_frame)
+        return false;
+
+    const PlayerFrame &frame = player_info->audio_frame;
+    frame_info->timestamp = frame.timestamp;
+    frame_info->stream_details.audio.channels = frame.channels;
+    frame_info->stream_details.audio.sample_rate = frame.sample_rate;
+    frame_info->stream_details.audio.size = frame.size;
+    frame_info->data = player_info->audio_data;
 
     strcpy(frame_info->stream_details.audio.language, "ENG");
     return true;
@@ -371,11 +400,11 @@ EXPORT(uint32_t, sceAvPlayerGetStreamInfo, SceUID player_handle, uint stream_no,
         stream_info->stream_details.video.aspect_ratio = static_cast<float>(size.width) / static_cast<float>(size.height);
         strcpy(stream_info->stream_details.video.language, "ENG");
     } else if (stream_no == 1) { // audio
-        player_info->player.receive_audio(); // TODO: Get audio info without skipping data frames
+        const PlayerFrame format = player_info->player.get_audio_format();
         stream_info->stream_type = MediaType::AUDIO;
-        stream_info->stream_details.audio.channels = player_info->player.last_channels;
-        stream_info->stream_details.audio.sample_rate = player_info->player.last_sample_rate;
-        stream_info->stream_details.audio.size = player_info->player.last_channels * player_info->player.last_sample_count * sizeof(int16_t);
+        stream_info->stream_details.audio.channels = format.channels;
+        stream_info->stream_details.audio.sample_rate = format.sample_rate;
+        stream_info->stream_details.audio.size = format.size;
         strcpy(stream_info->stream_details.audio.language, "ENG");
     } else {
         return SCE_AVPLAYER_ERROR_INVALID_ARGUMENT;
@@ -390,11 +419,8 @@ EXPORT(bool, sceAvPlayerGetVideoData, SceUID player_handle, SceAvPlayerFrameInfo
         return false;
     }
 
-    Ptr<uint8_t> buffer;
-
-    DecoderSize size = player_info->player.get_size();
-
-    uint64_t framerate = player_info->player.get_framerate_microseconds();
+    // Shown for as long as the frame delivered last lasts, the first one is taken right away
+    const uint64_t framerate = player_info->has_video_frame ? player_info->video_frame.duration_microseconds : 0;
 
     // needs new frame
     if (player_info->last_frame_time + framerate < current_time()) {
@@ -406,27 +432,32 @@ EXPORT(bool, sceAvPlayerGetVideoData, SceUID player_handle, SceAvPlayerFrameInfo
         if (player_info->paused) {
             if (REJECT_DATA_ON_PAUSE)
                 return false;
-            else
-                buffer = get_buffer(player_info, MediaType::VIDEO, host.mem, H264DecoderState::buffer_size(size), false);
         } else {
-            buffer = get_buffer(player_info, MediaType::VIDEO, host.mem, H264DecoderState::buffer_size(size), true);
-
-            std::vector<uint8_t> data = player_info->player.receive_video();
-            std::memcpy(buffer.get(host.mem), data.data(), data.size());
+            // Frames are decoded ahead, if the player fell behind the last one is shown again
+            PlayerFrame frame;
+            if (player_info->player.receive(PlayerMediaType::VIDEO, frame)) {
+                player_info->video_frame = frame;
+                player_info->video_data = deliver_frame(player_info->video_buffers, frame, host.mem);
+                player_info->has_video_frame = true;
+            } else {
+                update_buffers(player_info, MediaType::VIDEO, host.mem);
+            }
         }
-    } else {
-        buffer = get_buffer(player_info, MediaType::VIDEO, host.mem, H264DecoderState::buffer_size(size), false);
     }
     // TODO: catch eof error and call
     // uint32_t buf = SCE_AVPLAYER_ERROR_MAYBE_EOF;
     // run_event_callback(host, thread_id, player_info, SCE_AVPLAYER_STATE_ERROR, 0, &buf);
 
-    frame_info->timestamp = player_info->player.last_timestamp;
-    frame_info->stream_details.video.width = size.width;
-    frame_info->stream_details.video.height = size.height;
-    frame_info->stream_details.video.aspect_ratio = static_cast<float>(size.width) / static_cast<float>(size.height);
+    if (!player_info->has_video_frame)
+        return false;
+
+    const PlayerFrame &frame = player_info->video_frame;
+    frame_info->timestamp = frame.timestamp;
+    frame_info->stream_details.video.width = frame.width;
+    frame_info->stream_details.video.height = frame.height;
+    frame_info->stream_details.video.aspect_ratio = static_cast<float>(frame.width) / static_cast<float>(frame.height);
     strcpy(frame_info->stream_details.video.language, "ENG");
-    frame_info->data = buffer;
+    frame_info->data = player_info->video_data;
     return true;
 }
 
@@ -462,7 +493,7 @@ EXPORT(bool, sceAvPlayerIsActive, SceUID player_handle) {
     const auto state = host.kernel.obj_store.get<AvPlayerState>();
     const PlayerPtr &player_info = lock_and_find(player_handle, state->players, state->mutex);
 
-    return !player_info->player.video_playing.empty();
+    return player_info->player.is_active();
 }
 
 EXPORT(int, sceAvPlayerJumpToTime) {
@@ -506,9 +537,7 @@ EXPORT(int, sceAvPlayerSetTrickSpeed) {
 EXPORT(int, sceAvPlayerStart, SceUID player_handle) {
     const auto state = host.kernel.obj_store.get<AvPlayerState>();
     const PlayerPtr &player_info = lock_and_find(player_handle, state->players, state->mutex);
-    if (!player_info->player.videos_queue.empty()) {
-        player_info->player.pop_video();
-    }
+    player_info->player.pop_video();
     run_event_callback(host, thread_id, player_info, SCE_AVPLAYER_STATE_PLAY, 0, Ptr<void>(0));
     return 0;
 }
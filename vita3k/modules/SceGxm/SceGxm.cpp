@@ -59,6 +59,17 @@ struct SceGxmCommandDataCopyInfo {
 };
 #pragma pack(pop)
 
+// Uniform blocks last sent to the renderer by an immediate context for one shader stage. The renderer keeps
+// the storage of the previous draw, so blocks whose content did not change since then are not sent again.
+struct UniformBufferUploadCache {
+    const SceGxmProgram *program = nullptr;
+    std::array<std::vector<std::uint8_t>, SCE_GXM_REAL_MAX_UNIFORM_BUFFER> blocks;
+
+    void invalidate() {
+        program = nullptr;
+    }
+};
+
 struct SceGxmContext {
     GxmContextState state;
 
@@ -77,6 +88,9 @@ struct SceGxmContext {
     BitmapAllocator command_allocator;
     bool last_precomputed = false;
 
+    UniformBufferUploadCache vertex_uniform_upload_cache;
+    UniformBufferUploadCache fragment_uniform_upload_cache;
+
     explicit SceGxmContext(std::mutex &callback_lock_)
         : callback_lock(callback_lock_) {
     }
@@ -1025,12 +1039,38 @@ EXPORT(int, sceGxmDisplayQueueFinish) {
 }
 
 static void gxmSetUniformBuffers(renderer::State &state, SceGxmContext *context, const SceGxmProgram &program, const UniformBuffers &buffers, const UniformBufferSizes &sizes, KernelState &kern, const MemState &mem, const SceUID current_thread) {
+    // Command lists can be executed in any order, so only immediate draws can rely on what has been sent before
+    UniformBufferUploadCache *upload_cache = nullptr;
+    if (context->state.type == SCE_GXM_CONTEXT_TYPE_IMMEDIATE) {
+        upload_cache = program.is_fragment() ? &context->fragment_uniform_upload_cache : &context->vertex_uniform_upload_cache;
+
+        if (upload_cache->program != &program) {
+            // The layout of the renderer storage changes with the program, send everything again
+            upload_cache->program = &program;
+            for (auto &block : upload_cache->blocks) {
+                block.clear();
+            }
+        }
+    }
+
     for (std::size_t i = 0; i < buffers.size(); i++) {
         if (!buffers[i] || sizes.at(i) == 0) {
             continue;
         }
 
         std::uint32_t bytes_to_copy = sizes.at(i) * 4;
+
+        if (upload_cache) {
+            const std::uint8_t *source = buffers[i].cast<const std::uint8_t>().get(mem);
+            std::vector<std::uint8_t> &last_sent = upload_cache->blocks[i];
+
+            if ((last_sent.size() == bytes_to_copy) && (std::memcmp(last_sent.data(), source, bytes_to_copy) == 0)) {
+                continue;
+            }
+
+            last_sent.assign(source, source + bytes_to_copy);
+        }
+
         std::uint8_t **dest = renderer::set_uniform_buffer(state, context->renderer.get(), !program.is_fragment(), i, bytes_to_copy);
 
         if (dest) {
@@ -1471,6 +1511,10 @@ EXPORT(int, sceGxmExecuteCommandList, SceGxmContext *context, SceGxmCommandList
     imm_cmds.last->next = commandList->list->first;
     imm_cmds.last = commandList->list->last;
 
+    // The command list overwrote the uniform storage of the renderer context
+    context->vertex_uniform_upload_cache.invalidate();
+    context->fragment_uniform_upload_cache.invalidate();
+
     // Restore back our GXM state
     gxmContextStateRestore(*host.renderer, host.mem, context, true);
 
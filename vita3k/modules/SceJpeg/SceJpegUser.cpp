@@ -19,7 +19,7 @@
 
 #include <codec/state.h>
 
-typedef std::shared_ptr<DecoderState> DecoderPtr;
+typedef std::shared_ptr<MjpegDecoderState> DecoderPtr;
 
 struct MJpegState {
     bool initialized = false;
@@ -103,7 +103,7 @@ EXPORT(int, sceJpegGetOutputInfo, const uint8_t *jpeg_data, uint32_t jpeg_size,
 EXPORT(int, sceJpegInitMJpeg, int32_t decoder_count) {
     host.kernel.obj_store.create<MJpegState>();
     const auto state = host.kernel.obj_store.get<MJpegState>();
-    state->decoder = std::make_shared<MjpegDecoderState>();
+    state->decoder = std::make_shared<MjpegDecoderState>(host.cfg.video_decoder_threads);
 
     return 0;
 }
@@ -111,7 +111,7 @@ EXPORT(int, sceJpegInitMJpeg, int32_t decoder_count) {
 EXPORT(int, sceJpegInitMJpegWithParam, const SceJpegMJpegInitInfo *info) {
     host.kernel.obj_store.create<MJpegState>();
     const auto state = host.kernel.obj_store.get<MJpegState>();
-    state->decoder = std::make_shared<MjpegDecoderState>();
+    state->decoder = std::make_shared<MjpegDecoderState>(host.cfg.video_decoder_threads);
 
     return 0;
 }
@@ -121,6 +121,7 @@ EXPORT(int, sceJpegMJpegCsc, uint8_t *rgba, const uint8_t *yuv,
     uint32_t width = size >> 16u;
     uint32_t height = size & (~0u >> 16u);
 
+    // Doesn't touch the decoder, games may convert without initializing one or after finishing it
     convert_yuv_to_rgb(yuv, rgba, width, height);
 
     return 0;
@@ -26,13 +26,9 @@
 
 #include <SDL_timer.h>
 
-#include <chrono>
-#include <thread>
-
-inline uint64_t get_current_time() {
-    return std::chrono::duration_cast<std::chrono::microseconds>(
-        std::chrono::high_resolution_clock::now().time_since_epoch())
-        .count();
+// Timers are the only events besides simple events, which are event flags here
+static bool is_timer(HostState &host, SceUID event_id) {
+    return lock_and_find(event_id, host.kernel.timers, host.kernel.mutex) != nullptr;
 }
 
 EXPORT(int, __sceKernelCreateLwMutex, Ptr<SceKernelLwMutexWork> workarea, const char *name, unsigned int attr, Ptr<SceKernelCreateLwMutex_opt> opt) {
@@ -71,8 +67,8 @@ EXPORT(int, _sceKernelCancelSema) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, _sceKernelCancelTimer) {
-    return UNIMPLEMENTED();
+EXPORT(int, _sceKernelCancelTimer, SceUID timer_handle, SceInt32 *pNumWaitThreads) {
+    return timer_cancel(host.kernel, export_name, timer_handle, pNumWaitThreads);
 }
 
 EXPORT(SceUID, _sceKernelCreateCond, const char *pName, SceUInt32 attr, SceUID mutexId, const SceKernelCondOptParam *pOptParam) {
@@ -396,8 +392,8 @@ EXPORT(int, _sceKernelGetTimerBase) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, _sceKernelGetTimerEventRemainingTime) {
-    return UNIMPLEMENTED();
+EXPORT(int, _sceKernelGetTimerEventRemainingTime, SceUID timer_handle, SceKernelSysClock *remaining) {
+    return timer_get_event_remaining_time(host.kernel, export_name, timer_handle, remaining);
 }
 
 EXPORT(int, _sceKernelGetTimerInfo) {
@@ -444,8 +440,11 @@ EXPORT(int, _sceKernelPMonThreadGetCounter) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, _sceKernelPollEvent) {
-    return UNIMPLEMENTED();
+EXPORT(int, _sceKernelPollEvent, SceUID event_id, SceUInt32 bitPattern, SceUInt32 *pResultPattern, SceUInt64 *pUserData) {
+    if (is_timer(host, event_id))
+        return timer_poll(host.kernel, export_name, thread_id, event_id, pResultPattern, pUserData);
+
+    return eventflag_poll(host.kernel, export_name, thread_id, event_id, bitPattern, SCE_EVENT_WAITOR, pResultPattern);
 }
 
 EXPORT(int, _sceKernelPollEventFlag, SceUID event_id, unsigned int flags, unsigned int wait, unsigned int *outBits) {
@@ -504,8 +503,8 @@ EXPORT(int, _sceKernelSetThreadContextForVM, SceUID threadId, Ptr<SceKernelThrea
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, _sceKernelSetTimerEvent) {
-    return UNIMPLEMENTED();
+EXPORT(int, _sceKernelSetTimerEvent, SceUID timer_handle, SceInt32 type, const SceKernelSysClock *interval, SceInt32 repeats) {
+    return timer_set_event(host.kernel, export_name, timer_handle, type, interval, repeats);
 }
 
 EXPORT(int, _sceKernelSetTimerTime) {
@@ -567,12 +566,16 @@ EXPORT(int, _sceKernelWaitCondCB) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, _sceKernelWaitEvent) {
-    return UNIMPLEMENTED();
+EXPORT(int, _sceKernelWaitEvent, SceUID event_id, SceUInt32 waitPattern, SceUInt32 *pResultPattern, SceUInt64 *pUserData, SceUInt32 *pTimeout) {
+    if (is_timer(host, event_id))
+        return timer_wait(host.kernel, export_name, thread_id, event_id, pResultPattern, pUserData, pTimeout);
+
+    return eventflag_wait(host.kernel, export_name, thread_id, event_id, waitPattern, SCE_EVENT_WAITOR, pResultPattern, pTimeout);
 }
 
-EXPORT(int, _sceKernelWaitEventCB) {
-    return UNIMPLEMENTED();
+EXPORT(int, _sceKernelWaitEventCB, SceUID event_id, SceUInt32 waitPattern, SceUInt32 *pResultPattern, SceUInt64 *pUserData, SceUInt32 *pTimeout) {
+    STUBBED("no CB");
+    return CALL_EXPORT(_sceKernelWaitEvent, event_id, waitPattern, pResultPattern, pUserData, pTimeout);
 }
 
 EXPORT(SceInt32, _sceKernelWaitEventFlag, SceUID evfId, SceUInt32 bitPattern, SceUInt32 waitMode, SceUInt32 *pResultPat, SceUInt32 *pTimeout) {
@@ -683,8 +686,19 @@ EXPORT(int, sceKernelChangeActiveCpuMask) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, sceKernelChangeThreadCpuAffinityMask) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceKernelChangeThreadCpuAffinityMask, SceUID thid, int mask) {
+    if (mask > 0x70000)
+        return RET_ERROR(SCE_KERNEL_ERROR_INVALID_CPU_AFFINITY);
+
+    const ThreadStatePtr thread = lock_and_find(thid ? thid : thread_id, host.kernel.threads, host.kernel.mutex);
+    if (!thread)
+        return RET_ERROR(SCE_KERNEL_ERROR_UNKNOWN_THREAD_ID);
+
+    const std::lock_guard<std::mutex> lock(thread->mutex);
+    const int old_mask = thread->affinity_mask;
+    host.kernel.scheduler.set_affinity_mask(*thread, mask);
+
+    return old_mask;
 }
 
 EXPORT(int, sceKernelChangeThreadPriority, SceUID thid, int priority) {
@@ -692,7 +706,7 @@ EXPORT(int, sceKernelChangeThreadPriority, SceUID thid, int priority) {
 
     const ThreadStatePtr thread = lock_and_find(thid ? thid : thread_id, host.kernel.threads, host.kernel.mutex);
     const std::lock_guard<std::mutex> lock(thread->mutex);
-    thread.get()->priority = priority;
+    host.kernel.scheduler.set_priority(*thread, priority);
 
     return SCE_KERNEL_OK;
 }
@@ -729,6 +743,9 @@ EXPORT(int, sceKernelCheckWaitableStatus) {
 }
 
 EXPORT(SceInt32, sceKernelClearEvent, SceUID eventId, SceUInt32 clearPattern) {
+    if (is_timer(host, eventId))
+        return timer_clear(host.kernel, export_name, eventId);
+
     return eventflag_clear(host.kernel, export_name, eventId, clearPattern);
 }
 
@@ -794,38 +811,42 @@ EXPORT(int, sceKernelCreateThreadForUser, const char *name, SceKernelThreadEntry
     const ThreadStatePtr thread = host.kernel.create_thread(host.mem, name, entry.cast<void>(), init_priority, options->stack_size, options->option.get(host.mem));
     if (!thread)
         return RET_ERROR(SCE_KERNEL_ERROR_ERROR);
+    thread->affinity_mask = options->cpu_affinity_mask;
     return thread->id;
 }
 
-int delay_thread(SceUInt delay_us) {
+int delay_thread(KernelState &kernel, SceUID thread_id, SceUInt delay_us) {
     if (delay_us == 0)
         return SCE_KERNEL_ERROR_INVALID_ARGUMENT;
 
-    std::this_thread::sleep_for(std::chrono::microseconds(delay_us));
+    const ThreadStatePtr thread = kernel.get_thread(thread_id);
+    if (!thread)
+        return SCE_KERNEL_ERROR_UNKNOWN_THREAD_ID;
+
+    kernel.timer_wheel.sleep(thread, delay_us);
 
     return SCE_KERNEL_OK;
 }
 
 int delay_thread_cb(HostState &host, SceUID thread_id, SceUInt delay_us) {
-    auto start = std::chrono::high_resolution_clock::now(); // Meseaure the time taken to process callbacks
+    const uint64_t start = host.kernel.timer_wheel.now(); // Meseaure the time taken to process callbacks
     process_callbacks(host, thread_id);
-    auto end = std::chrono::high_resolution_clock::now();
-    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+    const uint64_t elapsed = host.kernel.timer_wheel.now() - start;
 
-    if (delay_us > elapsed.count()) // If we spent less time than requested processing callbacks, sleep the remaining time
-        return delay_thread(delay_us - elapsed.count());
+    if (delay_us > elapsed) // If we spent less time than requested processing callbacks, sleep the remaining time
+        return delay_thread(host.kernel, thread_id, static_cast<SceUInt>(delay_us - elapsed));
     else // Else return directly
         return SCE_KERNEL_OK;
 }
 
 EXPORT(int, sceKernelDelayThread, SceUInt delay) {
-    return delay_thread(delay);
+    return delay_thread(host.kernel, thread_id, delay);
 }
 
 EXPORT(int, sceKernelDelayThread200, SceUInt delay) {
     if (delay < 201)
         delay = 201;
-    return delay_thread(delay);
+    return delay_thread(host.kernel, thread_id, delay);
 }
 
 EXPORT(int, sceKernelDelayThreadCB, SceUInt delay) {
@@ -881,9 +902,7 @@ EXPORT(int, sceKernelDeleteThread, SceUID thid) {
 }
 
 EXPORT(int, sceKernelDeleteTimer, SceUID timer_handle) {
-    host.kernel.timers.erase(timer_handle);
-
-    return 0;
+    return timer_delete(host.kernel, export_name, thread_id, timer_handle);
 }
 
 EXPORT(int, sceKernelExitDeleteThread, int status) {
@@ -912,11 +931,15 @@ EXPORT(int, sceKernelGetProcessId) {
 }
 
 EXPORT(uint64_t, sceKernelGetSystemTimeWide) {
-    return get_current_time();
+    return host.kernel.timer_wheel.now();
 }
 
-EXPORT(int, sceKernelGetThreadCpuAffinityMask) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceKernelGetThreadCpuAffinityMask, SceUID thid) {
+    const ThreadStatePtr thread = lock_and_find(thid ? thid : thread_id, host.kernel.threads, host.kernel.mutex);
+    if (!thread)
+        return RET_ERROR(SCE_KERNEL_ERROR_UNKNOWN_THREAD_ID);
+
+    return thread->affinity_mask;
 }
 
 EXPORT(int, sceKernelGetThreadStackFreeSize) {
@@ -946,7 +969,7 @@ EXPORT(uint64_t, sceKernelGetTimerTimeWide, SceUID timer_handle) {
     if (!timer_info)
         return -1;
 
-    return get_current_time() - timer_info->time;
+    return host.kernel.timer_wheel.now() - timer_info->time;
 }
 
 EXPORT(SceInt32, sceKernelNotifyCallback, SceUID callbackId, SceInt32 notifyArg) {
@@ -1087,27 +1110,11 @@ EXPORT(int, sceKernelSignalSema, SceUID semaid, int signal) {
 }
 
 EXPORT(int, sceKernelStartTimer, SceUID timer_handle) {
-    const TimerPtr &timer_info = host.kernel.timers[timer_handle];
-
-    if (timer_info->is_started)
-        return false;
-
-    timer_info->is_started = true;
-    timer_info->time = get_current_time();
-
-    return true;
+    return timer_start(host.kernel, export_name, timer_handle);
 }
 
 EXPORT(int, sceKernelStopTimer, SceUID timer_handle) {
-    const TimerPtr timer_info = lock_and_find(timer_handle, host.kernel.timers, host.kernel.mutex);
-
-    if (!timer_info->is_started)
-        return false;
-
-    timer_info->is_started = false;
-    timer_info->time = get_current_time();
-
-    return true;
+    return timer_stop(host.kernel, export_name, timer_handle);
 }
 
 EXPORT(int, sceKernelSuspendThreadForVM, SceUID threadId) {
@@ -37,6 +37,12 @@ EXPORT(SceInt32, _sceKernelGetSemaInfo, SceUID semaId, Ptr<SceKernelSemaInfo> pI
 EXPORT(int, _sceKernelWaitSema, SceUID semaid, int signal, SceUInt *timeout);
 EXPORT(SceInt32, _sceKernelGetEventFlagInfo, SceUID evfId, Ptr<SceKernelEventFlagInfo> pInfo);
 EXPORT(int, _sceKernelPollEventFlag, SceUID event_id, unsigned int flags, unsigned int wait, unsigned int *outBits);
+EXPORT(int, _sceKernelCancelTimer, SceUID timer_handle, SceInt32 *pNumWaitThreads);
+EXPORT(int, _sceKernelGetTimerEventRemainingTime, SceUID timer_handle, SceKernelSysClock *remaining);
+EXPORT(int, _sceKernelSetTimerEvent, SceUID timer_handle, SceInt32 type, const SceKernelSysClock *interval, SceInt32 repeats);
+EXPORT(int, _sceKernelWaitEvent, SceUID event_id, SceUInt32 waitPattern, SceUInt32 *pResultPattern, SceUInt64 *pUserData, SceUInt32 *pTimeout);
+EXPORT(int, _sceKernelWaitEventCB, SceUID event_id, SceUInt32 waitPattern, SceUInt32 *pResultPattern, SceUInt64 *pUserData, SceUInt32 *pTimeout);
+EXPORT(int, _sceKernelPollEvent, SceUID event_id, SceUInt32 bitPattern, SceUInt32 *pResultPattern, SceUInt64 *pUserData);
 EXPORT(int, _sceKernelWaitThreadEnd, SceUID thid, int *stat, SceUInt *timeout);
 EXPORT(int, _sceKernelWaitThreadEndCB, SceUID thid, int *stat, SceUInt *timeout);
 EXPORT(int, _sceKernelWaitSignal, uint32_t unknown, uint32_t delay, uint32_t timeout);
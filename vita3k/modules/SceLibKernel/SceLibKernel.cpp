@@ -49,12 +49,6 @@ enum class TimerFlags : uint32_t {
     OPENABLE = 0x00000080,
 };
 
-inline uint64_t get_current_time() {
-    return std::chrono::duration_cast<std::chrono::microseconds>(
-        std::chrono::high_resolution_clock::now().time_since_epoch())
-        .count();
-}
-
 EXPORT(int, __sce_aeabi_idiv0) {
     return UNIMPLEMENTED();
 }
@@ -864,8 +858,8 @@ EXPORT(int, sceKernelCancelSema) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, sceKernelCancelTimer) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceKernelCancelTimer, SceUID timer_handle, SceInt32 *pNumWaitThreads) {
+    return CALL_EXPORT(_sceKernelCancelTimer, timer_handle, pNumWaitThreads);
 }
 
 EXPORT(int, sceKernelChangeCurrentThreadAttr) {
@@ -973,10 +967,13 @@ EXPORT(SceUID, sceKernelCreateTimer, const char *name, uint32_t flags, const voi
 
     timer_info->name = name;
 
-    if (flags & static_cast<uint32_t>(TimerFlags::PRIORITY_THREAD))
+    if (flags & static_cast<uint32_t>(TimerFlags::PRIORITY_THREAD)) {
         timer_info->thread_behaviour = TimerState::ThreadBehaviour::PRIORITY;
-    else
+        timer_info->waiting_threads = std::make_unique<PriorityThreadDataQueue<WaitingThreadData>>();
+    } else {
         timer_info->thread_behaviour = TimerState::ThreadBehaviour::FIFO;
+        timer_info->waiting_threads = std::make_unique<FIFOThreadDataQueue<WaitingThreadData>>();
+    }
 
     if (flags & static_cast<uint32_t>(TimerFlags::AUTOMATIC_RESET))
         timer_info->reset_behaviour = TimerState::ResetBehaviour::AUTOMATIC;
@@ -1170,8 +1167,8 @@ EXPORT(int, sceKernelGetTimerBase, SceUID timer_handle, SceKernelSysClock *time)
     return 0;
 }
 
-EXPORT(int, sceKernelGetTimerEventRemainingTime) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceKernelGetTimerEventRemainingTime, SceUID timer_handle, SceKernelSysClock *remaining) {
+    return CALL_EXPORT(_sceKernelGetTimerEventRemainingTime, timer_handle, remaining);
 }
 
 EXPORT(int, sceKernelGetTimerInfo) {
@@ -1184,7 +1181,7 @@ EXPORT(int, sceKernelGetTimerTime, SceUID timer_handle, SceKernelSysClock *time)
     if (!timer_info)
         return SCE_KERNEL_ERROR_UNKNOWN_TIMER_ID;
 
-    *time = get_current_time() - timer_info->time;
+    *time = host.kernel.timer_wheel.now() - timer_info->time;
 
     return 0;
 }
@@ -1239,8 +1236,8 @@ EXPORT(int, sceKernelPMonThreadGetCounter) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, sceKernelPollEvent) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceKernelPollEvent, SceUID event_id, SceUInt32 bitPattern, SceUInt32 *pResultPattern, SceUInt64 *pUserData) {
+    return CALL_EXPORT(_sceKernelPollEvent, event_id, bitPattern, pResultPattern, pUserData);
 }
 
 EXPORT(int, sceKernelPollEventFlag, SceUID event_id, unsigned int flags, unsigned int wait, unsigned int *outBits) {
@@ -1314,18 +1311,7 @@ EXPORT(int, sceKernelSetThreadContextForVM, SceUID threadId, Ptr<SceKernelThread
 }
 
 EXPORT(int, sceKernelSetTimerEvent, SceUID timer_handle, int32_t type, SceKernelSysClock *clock, int32_t repeats) {
-    STUBBED("Type not implemented.");
-
-    const TimerPtr timer_info = lock_and_find(timer_handle, host.kernel.timers, host.kernel.mutex);
-
-    if (!timer_info)
-        return SCE_KERNEL_ERROR_UNKNOWN_TIMER_ID;
-
-    // TODO: Timer values for type.
-
-    timer_info->repeats = repeats;
-
-    return SCE_KERNEL_OK;
+    return CALL_EXPORT(_sceKernelSetTimerEvent, timer_handle, type, clock, repeats);
 }
 
 EXPORT(int, sceKernelSetTimerTime) {
@@ -1421,12 +1407,12 @@ EXPORT(int, sceKernelWaitCondCB, SceUID cond_id, SceUInt32 *timeout) {
     return condvar_wait(host.kernel, host.mem, export_name, thread_id, cond_id, timeout, SyncWeight::Heavy);
 }
 
-EXPORT(int, sceKernelWaitEvent) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceKernelWaitEvent, SceUID event_id, SceUInt32 waitPattern, SceUInt32 *pResultPattern, SceUInt64 *pUserData, SceUInt32 *pTimeout) {
+    return CALL_EXPORT(_sceKernelWaitEvent, event_id, waitPattern, pResultPattern, pUserData, pTimeout);
 }
 
-EXPORT(int, sceKernelWaitEventCB) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceKernelWaitEventCB, SceUID event_id, SceUInt32 waitPattern, SceUInt32 *pResultPattern, SceUInt64 *pUserData, SceUInt32 *pTimeout) {
+    return CALL_EXPORT(_sceKernelWaitEventCB, event_id, waitPattern, pResultPattern, pUserData, pTimeout);
 }
 
 EXPORT(SceInt32, sceKernelWaitEventFlag, SceUID evfId, SceUInt32 bitPattern, SceUInt32 waitMode, SceUInt32 *pResultPat, SceUInt32 *pTimeout) {
@@ -19,7 +19,7 @@
 #include <codec/state.h>
 #include <util/lock_and_find.h>
 
-typedef std::shared_ptr<DecoderState> DecoderPtr;
+typedef std::shared_ptr<H264DecoderState> DecoderPtr;
 typedef std::map<SceUID, DecoderPtr> DecoderStates;
 
 struct VideodecState {
@@ -36,6 +36,14 @@ struct SceVideodecTimeStamp {
     uint32_t lower;
 };
 
+enum SceAvcdecPixelFormat {
+    SCE_AVCDEC_PIXELFORMAT_RGBA8888 = 0x00,
+    SCE_AVCDEC_PIXELFORMAT_RGBA565 = 0x01,
+    SCE_AVCDEC_PIXELFORMAT_RGBA5551 = 0x02,
+    SCE_AVCDEC_PIXELFORMAT_YUV420_RASTER = 0x10,
+    SCE_AVCDEC_PIXELFORMAT_YUV420_PACKED_RASTER = 0x20
+};
+
 struct SceAvcdecFrameOptionRGBA {
     uint8_t alpha;
     uint8_t cscCoefficient;
@@ -125,13 +133,27 @@ struct SceAvcdecArrayPicture {
     Ptr<Ptr<SceAvcdecPicture>> pPicture;
 };
 
+static void receive_pictures(HostState &host, const DecoderPtr &decoder, SceAvcdecArrayPicture *picture) {
+    Ptr<SceAvcdecPicture> *pictures = picture->pPicture.get(host.mem);
+    while (picture->numOfOutput < picture->numOfElm) {
+        const SceAvcdecFrame &frame = pictures[picture->numOfOutput].get(host.mem)->frame;
+        uint8_t *output = frame.pPicture[0].cast<uint8_t>().get(host.mem);
+        // Written as the YUV420 texture the guest draws it with, the renderer converts it to RGB.
+        // TODO: RGBA pixel types are still given YUV420 planes.
+        decoder->chroma_interleaved = (frame.pixelType == SCE_AVCDEC_PIXELFORMAT_YUV420_PACKED_RASTER);
+        if (!decoder->receive(output, nullptr))
+            break;
+        picture->numOfOutput++;
+    }
+}
+
 EXPORT(int, sceAvcdecCreateDecoder, uint32_t codec_type, SceAvcdecCtrl *decoder, const SceAvcdecQueryDecoderInfo *query) {
     assert(codec_type == SCE_VIDEODEC_TYPE_HW_AVCDEC);
     const auto state = host.kernel.obj_store.get<VideodecState>();
     SceUID handle = host.kernel.get_next_uid();
     decoder->handle = handle;
 
-    state->decoders[handle] = std::make_shared<H264DecoderState>(query->horizontal, query->vertical);
+    state->decoders[handle] = std::make_shared<H264DecoderState>(query->horizontal, query->vertical, host.cfg.video_decoder_threads, host.cfg.video_decoder_frame_threading);
 
     return 0;
 }
@@ -162,15 +184,12 @@ EXPORT(int, sceAvcdecDecode, SceAvcdecCtrl *decoder, const SceAvcdecAu *au, SceA
     options.dts_upper = au->dts.upper;
     options.dts_lower = au->dts.lower;
 
-    // This is quite long...
-    uint8_t *output = picture->pPicture.get(host.mem)[0].get(host.mem)->frame.pPicture[0].cast<uint8_t>().get(host.mem);
-
-    // TODO: decoding can be done async I think
     decoder_info->configure(&options);
     decoder_info->send(reinterpret_cast<uint8_t *>(au->es.pBuf.get(host.mem)), au->es.size);
-    decoder_info->receive(output);
 
-    picture->numOfOutput++;
+    // With frame threading a picture comes out a few access units after its own, the rest are returned by sceAvcdecDecodeStop
+    picture->numOfOutput = 0;
+    receive_pictures(host, decoder_info, picture);
 
     return 0;
 }
@@ -240,8 +259,10 @@ EXPORT(int, sceAvcdecDecodeStop, SceAvcdecCtrl *decoder, SceAvcdecArrayPicture *
     const auto state = host.kernel.obj_store.get<VideodecState>();
     const DecoderPtr &decoder_info = lock_and_find(decoder->handle, state->decoders, state->mutex);
 
-    uint8_t *output = picture->pPicture.get(host.mem)[0].get(host.mem)->frame.pPicture[0].cast<uint8_t>().get(host.mem);
-    decoder_info->receive(output);
+    // Called until no picture is returned
+    picture->numOfOutput = 0;
+    decoder_info->drain();
+    receive_pictures(host, decoder_info, picture);
 
     return 0;
 }
@@ -0,0 +1,124 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+/**
+ * @file biquad.h
+ * @brief NGS biquad filters
+ * @details Second order IIR filters following the Audio EQ Cookbook, used as a cascade
+ * by the equalizer module. Coefficients are only computed again when the filter
+ * settings change, and the filter glides to them over one block instead of jumping.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace ngs::dsp::biquad {
+enum class FilterMode : std::int32_t {
+    OFF = 0,
+    LOWPASS_RESONANT = 1,
+    HIGHPASS_RESONANT = 2,
+    BANDPASS_PEAK = 3,
+    BANDPASS_ZERO = 4,
+    NOTCH = 5,
+    PEAK = 6,
+    HIGH_SHELF = 7,
+    LOW_SHELF = 8,
+    LOWPASS_ONEPOLE = 9,
+    HIGHPASS_ONEPOLE = 10,
+    ALLPASS = 11,
+    LOWPASS_RESONANT_NORMALIZED = 12
+};
+
+/**
+ * @brief Filter settings, the gain being a linear amplitude
+ */
+struct FilterSettings {
+    FilterMode mode = FilterMode::OFF;
+    float frequency = 1000.0f;
+    float resonance = 0.707f;
+    float gain = 1.0f;
+
+    bool operator==(const FilterSettings &other) const {
+        return (mode == other.mode) && (frequency == other.frequency) && (resonance == other.resonance) && (gain == other.gain);
+    }
+    bool operator!=(const FilterSettings &other) const {
+        return !(*this == other);
+    }
+};
+
+/**
+ * @brief Normalized coefficients, a0 being 1
+ */
+struct Coefficients {
+    float b0 = 1.0f;
+    float b1 = 0.0f;
+    float b2 = 0.0f;
+    float a1 = 0.0f;
+    float a2 = 0.0f;
+};
+
+/**
+ * @brief Compute the coefficients of a filter, sanitizing settings out of range
+ *
+ * @param settings Filter settings
+ * @param sample_rate Sample rate in Hz
+ */
+Coefficients compute_coefficients(const FilterSettings &settings, float sample_rate);
+
+/**
+ * @brief Stereo biquad filter working on interleaved samples, in direct form I
+ * so that its state stays meaningful while the coefficients move
+ */
+class Filter {
+    FilterSettings settings;
+    float sample_rate = 0.0f;
+    bool configured = false;
+
+    Coefficients current;
+    Coefficients target;
+    bool gliding = false;
+
+    float x1[2] = {};
+    float x2[2] = {};
+    float y1[2] = {};
+    float y2[2] = {};
+
+public:
+    /**
+     * @brief Apply filter settings, nothing gets computed when they didn't change
+     */
+    void configure(const FilterSettings &settings, float sample_rate);
+
+    /**
+     * @brief Clear the filter history and jump to the target coefficients
+     */
+    void reset();
+
+    /**
+     * @brief True when the filter is off and done gliding, so processing can be skipped
+     */
+    bool is_bypassed() const {
+        return (settings.mode == FilterMode::OFF) && !gliding;
+    }
+
+    /**
+     * @brief Filter a block of interleaved stereo frames in place
+     */
+    void process(float *samples, std::uint32_t frames);
+};
+} // namespace ngs::dsp::biquad
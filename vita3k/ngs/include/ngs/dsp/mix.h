@@ -0,0 +1,65 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+/**
+ * @file mix.h
+ * @brief NGS mixing and sample format conversion kernels
+ * @details Vectorized versions are picked at runtime for the host CPU, the
+ * scalar ones are kept as the reference they must match.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace ngs::dsp::mix {
+/**
+ * @brief Volume matrix of a patch, matrix[from][to] being the gain applied to
+ * the source channel `from` when mixed into the destination channel `to`
+ */
+typedef float VolumeMatrix[2][2];
+
+/**
+ * @brief Mix interleaved stereo frames into a destination, applying the volume
+ * matrix and clamping every resulting sample to [-1, 1]
+ *
+ * @param dest Interleaved stereo frames being mixed into
+ * @param source Interleaved stereo frames to mix in
+ * @param volume_matrix Gains applied to the source
+ * @param frames Amount of frames
+ */
+void mix_stereo(float *dest, const float *source, const VolumeMatrix &volume_matrix, std::uint32_t frames);
+
+/**
+ * @brief Convert float samples to s16, saturating anything outside of [-1, 1)
+ *
+ * @param source Float samples
+ * @param dest Destination of the s16 samples
+ * @param samples Amount of samples, of all channels
+ */
+void float_to_s16(const float *source, std::int16_t *dest, std::uint32_t samples);
+
+namespace reference {
+void mix_stereo(float *dest, const float *source, const VolumeMatrix &volume_matrix, std::uint32_t frames);
+void float_to_s16(const float *source, std::int16_t *dest, std::uint32_t samples);
+} // namespace reference
+
+/**
+ * @brief Name of the instruction set used by the kernels on this host
+ */
+const char *kernels_name();
+} // namespace ngs::dsp::mix
@@ -27,7 +27,6 @@
 #pragma once
 
 #include <SoundTouch.h>
-#include <ngs/modules/player.h>
 
 #include <vector>
 
@@ -45,48 +44,73 @@ struct scaling_settings {
 
     // Source audio channels
     unsigned int channels = 2;
+
+    bool operator==(const scaling_settings &other) const {
+        return (scaling_factor == other.scaling_factor) && (source_playback_rate == other.source_playback_rate) && (channels == other.channels);
+    }
+    bool operator!=(const scaling_settings &other) const {
+        return !(*this == other);
+    }
 };
 
 /**
  * @brief Playback rate scaler abstraction class
+ * @details Meant to be kept for a whole voice and fed the audio as it gets decoded, so that
+ * consecutive buffers are scaled as one continuous stream.
+ * Slowing down only needs interpolation between input samples, which is done by a cheap linear
+ * resampler. Speeding up goes through SoundTouch, whose anti-alias filter keeps the dropped high
+ * frequencies from folding back.
  */
 class Scaler {
-    // Actual scaler object
+    // Actual scaler object, used when speeding up
     soundtouch::SoundTouch scaler;
+    bool use_soundtouch = false;
+
+    // Settings currently applied, nothing is applied before the first configure call
+    ngs::dsp::playback_rate::scaling_settings settings;
+    bool configured = false;
 
-    // Pointer to decoder state used to get settings
-    ngs::dsp::playback_rate::scaling_settings *settings = nullptr;
+    // Linear resampler state: last input frame of the previous call and position of the
+    // next output frame, in input frames from that last frame
+    std::vector<float> history;
+    double position = 1.0;
 
-    // Result of the scaling process in floating-point values
-    // To be set by Scaler::scale once the process is finished and then get
-    // reutilized by Scaler::receive
+    // Result of the last scaling process in interleaved floating-point values
     std::vector<float> fsamples_output;
 
+    unsigned int scale_linear(const float *input, unsigned int frames);
+    unsigned int scale_soundtouch(const float *input, unsigned int frames);
+
 public:
     /**
-     * @brief Construct a new Scaler object
+     * @brief Apply scaling settings, keeping the state of the stream when they don't change
+     * @details The scaling factor is clamped to a positive range, a non finite one is taken as 1.
      *
      * @param settings Scaling settings
      */
-    Scaler(ngs::dsp::playback_rate::scaling_settings *settings);
+    void configure(const ngs::dsp::playback_rate::scaling_settings &settings);
 
     /**
-     * @brief Take an audio input buffer and apply playback rate scaling according to
-     * the settings of the provided decoder.
-     *
-     * @param audio_input Floating-point PCM audio samples that need to be scaled
-     * @return The size in samples of the resulting audio buffer due to the scaling
-     * process
+     * @brief Drop the state of the stream, next input is treated as the start of a new one
      */
-    unsigned int scale(std::vector<std::uint8_t> *audio_input);
+    void reset();
 
     /**
-     * @brief Get audio data resulting of the scaling process
+     * @brief Take audio input frames and apply playback rate scaling to them according
+     * to the configured settings
      *
-     * @param audio_output Pointer to a vector with enough size to fit the amount of samples
-     * specified in the return of `Scaler::scale()`
+     * @param input Interleaved floating-point PCM audio frames that need to be scaled
+     * @param frames Amount of frames in the input
+     * @return The amount of frames resulting of the scaling process, ready in `Scaler::data()`
+     */
+    unsigned int scale(const float *input, unsigned int frames);
+
+    /**
+     * @brief Get audio data resulting of the last scaling process, valid until the next call
      */
-    int receive(std::vector<std::uint8_t> *audio_output);
+    const float *data() const {
+        return fsamples_output.data();
+    }
 };
 
 } // namespace ngs::dsp::playback_rate
@@ -0,0 +1,118 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+/**
+ * @file reverb.h
+ * @brief NGS reverb
+ * @details I3DL2 style reverb: early reflections tapped from a predelay line, followed by
+ * a late reverberation made of a diffusing allpass pair feeding a four line feedback delay
+ * network. The four lines are processed together so that the compiler can keep them in one
+ * vector register, and everything derived from the settings is cached until they change.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace ngs::dsp::reverb {
+/**
+ * @brief Reverb settings, levels being linear amplitudes
+ */
+struct Settings {
+    float dry = 1.0f;
+    float room = 0.316f; // -1000 mB
+    float room_hf = 1.0f; // Room level at hf_reference, relative to room
+    float decay_time = 1.5f; // Seconds
+    float decay_hf_ratio = 0.5f; // Decay time at hf_reference, relative to decay_time
+    float reflections = 0.3f;
+    float reflections_delay = 0.01f; // Seconds
+    float reverb = 0.5f;
+    float reverb_delay = 0.02f; // Seconds after the reflections
+    float diffusion = 1.0f; // 0 to 1
+    float density = 1.0f; // 0 to 1
+    float hf_reference = 5000.0f; // Hz
+
+    bool operator==(const Settings &other) const;
+    bool operator!=(const Settings &other) const {
+        return !(*this == other);
+    }
+};
+
+class Reverb {
+public:
+    static constexpr std::uint32_t LINE_COUNT = 4;
+
+    /**
+     * @brief Apply settings, only recomputing the derived values when they changed
+     */
+    void configure(const Settings &settings, float sample_rate);
+
+    /**
+     * @brief Silence every delay line
+     */
+    void reset();
+
+    /**
+     * @brief Process a block of interleaved stereo frames, input and output may be the same
+     */
+    void process(const float *input, float *output, std::uint32_t frames);
+
+private:
+    struct DelayLine {
+        std::vector<float> buffer;
+        std::uint32_t position = 0;
+
+        void resize(std::uint32_t length);
+        void clear();
+    };
+
+    // Levels moving from one block to the next
+    struct Levels {
+        float dry = 0.0f;
+        float reflections = 0.0f;
+        float reverb = 0.0f;
+    };
+
+    Settings settings;
+    float sample_rate = 0.0f;
+    bool configured = false;
+
+    Levels current;
+    Levels target;
+
+    // Predelay, early reflections are read from it and the late reverb is fed from it
+    DelayLine predelay;
+    std::uint32_t reflections_taps[2] = {};
+    std::uint32_t late_tap = 0;
+
+    // Input tone of the room
+    float room_lowpass = 0.0f;
+    float room_lowpass_state = 0.0f;
+
+    // Diffusion
+    DelayLine diffusers[2];
+    float diffusion_gain = 0.0f;
+
+    // Feedback delay network
+    std::array<DelayLine, LINE_COUNT> lines;
+    std::array<float, LINE_COUNT> line_gains = {};
+    std::array<float, LINE_COUNT> line_lowpass = {};
+    std::array<float, LINE_COUNT> line_lowpass_state = {};
+};
+} // namespace ngs::dsp::reverb
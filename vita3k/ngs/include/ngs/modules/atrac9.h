@@ -70,15 +70,20 @@ struct State {
 
     // INTERNAL
     std::int8_t current_loop_count = 0;
-    std::uint32_t decoded_samples_pending = 0;
-    std::uint32_t decoded_passed = 0;
 };
 
-struct Module : public ngs::Module {
-private:
+// Kept per voice, voices of a rack share the module
+struct VoiceContext {
     std::unique_ptr<Atrac9DecoderState> decoder;
-    std::uint32_t last_config;
+    std::uint32_t last_config = 0;
+
+    S16ToF32Converter converter;
+    std::vector<std::uint8_t> superframe_bytes; ///< Superframe split between two buffers.
+    std::vector<std::uint8_t> decoded;
+    SampleRingBuffer decoded_samples; ///< Converted samples not passed down the voice yet.
+};
 
+struct Module : public ngs::Module {
 public:
     explicit Module();
 
@@ -17,9 +17,34 @@
 
 #pragma once
 
+#include <ngs/dsp/biquad.h>
 #include <ngs/system.h>
 
+#include <array>
+
 namespace ngs::equalizer {
+#define MAX_FILTERS 4
+
+struct FilterParameters {
+    SceInt32 mode; ///< ngs::dsp::biquad::FilterMode
+    SceInt32 reserved;
+    SceFloat32 frequency;
+    SceFloat32 resonance;
+    SceFloat32 gain;
+};
+
+struct Parameters {
+    ngs::ParametersDescriptor descriptor;
+    FilterParameters filters[MAX_FILTERS];
+};
+
+static_assert(sizeof(Parameters) <= default_normal_parameter_size);
+
+// Kept per voice, voices of a rack share the module
+struct VoiceContext {
+    std::array<dsp::biquad::Filter, MAX_FILTERS> filters;
+};
+
 struct Module : public ngs::Module {
 public:
     explicit Module();
@@ -27,5 +52,6 @@ public:
     bool process(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data) override;
     std::uint32_t module_id() const override { return 0x5CEC; }
     std::size_t get_buffer_parameter_size() const override;
+    void on_state_change(ModuleData &data, const VoiceState previous) override;
 };
 } // namespace ngs::equalizer
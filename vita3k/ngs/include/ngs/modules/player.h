@@ -18,8 +18,11 @@
 #pragma once
 
 #include <codec/state.h>
+#include <ngs/dsp/playback_rate.h>
 #include <ngs/system.h>
 
+#include <atomic>
+
 namespace ngs::player {
 enum {
     SCE_NGS_PLAYER_CALLBACK_REASON_DONE_ALL = 0,
@@ -52,8 +55,6 @@ struct State {
 
     // INTERNAL
     std::int8_t current_loop_count = 0;
-    std::uint32_t decoded_gran_pending = 0;
-    std::uint32_t decoded_gran_passed = 0;
 };
 
 struct Parameters {
@@ -86,13 +87,23 @@ struct Parameters {
     SceInt8 padding[2];
 };
 
+// Kept per voice, voices of a rack share the module
+struct VoiceContext {
+    std::unique_ptr<PCMDecoderState> decoder;
+    SampleRingBuffer decoded_samples; ///< Decoded samples not passed down the voice yet.
+
+    // Playback rate scaling, fed continuously so buffers join without gaps or clicks
+    dsp::playback_rate::Scaler scaler;
+    std::vector<float> unscaled_samples;
+};
+
 struct Module : public ngs::Module {
 private:
-    std::unique_ptr<PCMDecoderState> decoder;
 
     // Logging flag to control over playback rate scaling
     // It gets set to false once playback rate scaling is requested to prevent log event repetition
-    bool LOG_PLAYBACK_SCALING = true;
+    // Voices of a rack are processed in parallel and share the module, so it is atomic
+    std::atomic<bool> LOG_PLAYBACK_SCALING = true;
 
 public:
     explicit Module();
@@ -0,0 +1,58 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <ngs/dsp/reverb.h>
+#include <ngs/system.h>
+
+namespace ngs::reverb {
+// I3DL2 parameters, levels in millibels
+struct Parameters {
+    ngs::ParametersDescriptor descriptor;
+    SceInt32 room;
+    SceInt32 room_hf;
+    SceFloat32 decay_time;
+    SceFloat32 decay_hf_ratio;
+    SceInt32 reflections;
+    SceFloat32 reflections_delay;
+    SceInt32 reverb;
+    SceFloat32 reverb_delay;
+    SceFloat32 diffusion; ///< Percent
+    SceFloat32 density; ///< Percent
+    SceFloat32 hf_reference;
+    SceInt32 dry;
+};
+
+static_assert(sizeof(Parameters) <= default_passthrough_parameter_size);
+
+// Kept per voice, voices of a rack share the module
+struct VoiceContext {
+    dsp::reverb::Reverb reverb;
+    std::vector<float> output;
+};
+
+struct Module : public ngs::Module {
+public:
+    explicit Module();
+
+    bool process(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data) override;
+    std::uint32_t module_id() const override { return 0x5CEB; }
+    std::size_t get_buffer_parameter_size() const override;
+    void on_state_change(ModuleData &data, const VoiceState previous) override;
+};
+} // namespace ngs::reverb
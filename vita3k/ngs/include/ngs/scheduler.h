@@ -21,9 +21,8 @@
 
 #include <mem/ptr.h>
 
-#include <thread>
-
-#include <optional>
+#include <atomic>
+#include <mutex>
 #include <vector>
 
 struct MemState;
@@ -33,21 +32,40 @@ namespace ngs {
 struct PatchSetupInfo;
 struct Voice;
 struct Patch;
+struct ModuleData;
 
+// Active voices are processed in levels: a voice only takes input from voices of lower levels, so the
+// voices of one level are independent and get processed in parallel. Their outputs are then delivered
+// one voice at a time in a fixed order, keeping the mix into shared inputs deterministic.
+// Guest callbacks raised while a level is processed are run on the updating thread once the level is done.
 struct VoiceScheduler {
+    struct DeferredCallback {
+        ModuleData *data;
+        std::uint32_t reason1;
+        std::uint32_t reason2;
+        Address reason_ptr;
+    };
+
     std::vector<Voice *> queue;
     std::vector<Voice *> pending_deque;
+    std::vector<Voice *> pending_enqueue;
 
     std::mutex lock;
-    std::optional<std::thread::id> updater;
+    std::mutex pending_lock;
 
 protected:
+    std::vector<std::vector<Voice *>> levels;
+    std::atomic<bool> levels_dirty{ true };
+    std::vector<std::uint8_t> finished;
+
+    std::vector<std::vector<DeferredCallback>> deferred_callbacks; ///< Per voice of the level being processed
+
     bool deque_voice(Voice *voice);
     bool deque_voice_impl(Voice *voice);
 
-    bool resort_to_respect_dependencies(const MemState &mem, Voice *source);
-
-    std::int32_t get_position(Voice *v);
+    bool is_updating() const;
+    void compile_levels(const MemState &mem);
+    bool process_voice(KernelState &kern, const MemState &mem, const SceUID thread_id, Voice *voice);
 
 public:
     bool play(const MemState &mem, Voice *voice);
@@ -58,6 +76,13 @@ public:
 
     void update(KernelState &kern, const MemState &mem, const SceUID thread_id);
 
+    // Returns false when no voice of this scheduler is being processed on this thread, the callback must run now
+    bool defer_callback(ModuleData *data, std::uint32_t reason1, std::uint32_t reason2, Address reason_ptr);
+
     Ptr<Patch> patch(const MemState &mem, PatchSetupInfo *info);
+    // Routing changed, levels are compiled again at the next update
+    void invalidate_levels() {
+        levels_dirty = true;
+    }
 };
 } // namespace ngs
@@ -19,6 +19,7 @@
 
 #include <array>
 #include <cstdint>
+#include <memory>
 #include <mutex>
 #include <vector>
 
@@ -77,6 +78,43 @@ struct CallbackInfo {
 
 typedef void (*ModuleCallback)(CallbackInfo *info);
 
+// Decoded interleaved float frames waiting to be passed down the voice.
+// Reads always get a contiguous span, the frames wrapping around are copied after the end of the ring
+// for it, and writes get one too, the part past the end being moved to the start once written.
+// The storage only grows when a write doesn't fit, so a voice stops allocating after its first buffers.
+class SampleRingBuffer {
+public:
+    explicit SampleRingBuffer(std::uint32_t channels = 2);
+
+    // Makes room for at least capacity frames, with spans of up to max_span frames
+    void reserve(std::uint32_t capacity, std::uint32_t max_span);
+    void clear();
+
+    std::uint32_t size() const {
+        return count;
+    }
+    std::uint32_t capacity() const {
+        return ring_frames;
+    }
+
+    // Room to write the given number of frames, end_write commits how many were actually written
+    float *begin_write(std::uint32_t frames);
+    void end_write(std::uint32_t frames);
+    void write_silence(std::uint32_t frames);
+
+    // The frames must be available, the span stays valid until the next write
+    float *read(std::uint32_t frames);
+    void consume(std::uint32_t frames);
+
+private:
+    std::vector<float> storage;
+    std::uint32_t channels;
+    std::uint32_t ring_frames = 0;
+    std::uint32_t span_frames = 0;
+    std::uint32_t read_pos = 0;
+    std::uint32_t count = 0;
+};
+
 struct ModuleData {
     Voice *parent;
     std::uint32_t index;
@@ -85,7 +123,7 @@ struct ModuleData {
     Ptr<void> user_data;
 
     std::vector<std::uint8_t> voice_state_data; ///< Voice state.
-    std::vector<std::uint8_t> extra_storage; ///< Local data storage for module.
+    std::shared_ptr<void> voice_context; ///< Host objects (decoders, scratch buffers) the module keeps for this voice.
 
     BufferParamsInfo info;
     std::vector<std::uint8_t> last_info;
@@ -108,6 +146,15 @@ struct ModuleData {
         return reinterpret_cast<T *>(&voice_state_data[0]);
     }
 
+    // Unlike the state, the context is a real object, constructed on first use and destroyed with the voice
+    template <typename T>
+    T *get_voice_context() {
+        if (!voice_context)
+            voice_context = std::make_shared<T>();
+
+        return static_cast<T *>(voice_context.get());
+    }
+
     template <typename T>
     T *get_parameters(const MemState &mem) {
         if (flags & PARAMS_LOCK) {
@@ -118,10 +165,11 @@ struct ModuleData {
         return info.data.cast<T>().get(mem);
     }
 
-    void fill_to_fit_granularity();
-
+    // Deferred to the end of the level when called while the voice scheduler processes the voice
     void invoke_callback(KernelState &kern, const MemState &mem, const SceUID thread_id, const std::uint32_t reason1,
         const std::uint32_t reason2, Address reason_ptr);
+    void run_callback(KernelState &kern, const MemState &mem, const SceUID thread_id, const std::uint32_t reason1,
+        const std::uint32_t reason2, Address reason_ptr);
 
     BufferParamsInfo *lock_params(const MemState &mem);
     bool unlock_params();
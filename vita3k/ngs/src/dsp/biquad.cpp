@@ -0,0 +1,250 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+/**
+ * @file biquad.cpp
+ * @brief NGS biquad filters
+ */
+
+#include <ngs/dsp/biquad.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace ngs::dsp::biquad {
+static constexpr float PI = 3.14159265358979f;
+
+Coefficients compute_coefficients(const FilterSettings &settings, float sample_rate) {
+    Coefficients result;
+    if ((settings.mode == FilterMode::OFF) || (sample_rate <= 0.0f)) {
+        return result;
+    }
+
+    const float frequency = std::clamp(settings.frequency, 10.0f, sample_rate * 0.49f);
+    const float q = std::clamp(settings.resonance, 0.05f, 40.0f);
+    const float gain = std::clamp(settings.gain, 0.0f, 64.0f);
+
+    const float w0 = 2.0f * PI * frequency / sample_rate;
+    const float cos_w0 = std::cos(w0);
+    const float alpha = std::sin(w0) / (2.0f * q);
+    // Shelves and peaks take the gain as their boost, everything else as an output gain
+    const float a = std::sqrt(std::max(gain, 1e-4f));
+
+    float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f;
+    float a0 = 1.0f, a1 = 0.0f, a2 = 0.0f;
+    float output_gain = gain;
+
+    switch (settings.mode) {
+    case FilterMode::LOWPASS_RESONANT:
+    case FilterMode::LOWPASS_RESONANT_NORMALIZED:
+        b0 = (1.0f - cos_w0) / 2.0f;
+        b1 = 1.0f - cos_w0;
+        b2 = b0;
+        a0 = 1.0f + alpha;
+        a1 = -2.0f * cos_w0;
+        a2 = 1.0f - alpha;
+        // Keep the resonance peak at the requested gain
+        if ((settings.mode == FilterMode::LOWPASS_RESONANT_NORMALIZED) && (q > 0.707f))
+            output_gain /= q;
+        break;
+    case FilterMode::HIGHPASS_RESONANT:
+        b0 = (1.0f + cos_w0) / 2.0f;
+        b1 = -(1.0f + cos_w0);
+        b2 = b0;
+        a0 = 1.0f + alpha;
+        a1 = -2.0f * cos_w0;
+        a2 = 1.0f - alpha;
+        break;
+    case FilterMode::BANDPASS_PEAK:
+        b0 = q * alpha;
+        b1 = 0.0f;
+        b2 = -q * alpha;
+        a0 = 1.0f + alpha;
+        a1 = -2.0f * cos_w0;
+        a2 = 1.0f - alpha;
+        break;
+    case FilterMode::BANDPASS_ZERO:
+        b0 = alpha;
+        b1 = 0.0f;
+        b2 = -alpha;
+        a0 = 1.0f + alpha;
+        a1 = -2.0f * cos_w0;
+        a2 = 1.0f - alpha;
+        break;
+    case FilterMode::NOTCH:
+        b0 = 1.0f;
+        b1 = -2.0f * cos_w0;
+        b2 = 1.0f;
+        a0 = 1.0f + alpha;
+        a1 = -2.0f * cos_w0;
+        a2 = 1.0f - alpha;
+        break;
+    case FilterMode::ALLPASS:
+        b0 = 1.0f - alpha;
+        b1 = -2.0f * cos_w0;
+        b2 = 1.0f + alpha;
+        a0 = 1.0f + alpha;
+        a1 = -2.0f * cos_w0;
+        a2 = 1.0f - alpha;
+        break;
+    case FilterMode::PEAK:
+        b0 = 1.0f + alpha * a;
+        b1 = -2.0f * cos_w0;
+        b2 = 1.0f - alpha * a;
+        a0 = 1.0f + alpha / a;
+        a1 = -2.0f * cos_w0;
+        a2 = 1.0f - alpha / a;
+        output_gain = 1.0f;
+        break;
+    case FilterMode::LOW_SHELF: {
+        const float beta = 2.0f * std::sqrt(a) * alpha;
+        b0 = a * ((a + 1.0f) - (a - 1.0f) * cos_w0 + beta);
+        b1 = 2.0f * a * ((a - 1.0f) - (a + 1.0f) * cos_w0);
+        b2 = a * ((a + 1.0f) - (a - 1.0f) * cos_w0 - beta);
+        a0 = (a + 1.0f) + (a - 1.0f) * cos_w0 + beta;
+        a1 = -2.0f * ((a - 1.0f) + (a + 1.0f) * cos_w0);
+        a2 = (a + 1.0f) + (a - 1.0f) * cos_w0 - beta;
+        output_gain = 1.0f;
+        break;
+    }
+    case FilterMode::HIGH_SHELF: {
+        const float beta = 2.0f * std::sqrt(a) * alpha;
+        b0 = a * ((a + 1.0f) + (a - 1.0f) * cos_w0 + beta);
+        b1 = -2.0f * a * ((a - 1.0f) + (a + 1.0f) * cos_w0);
+        b2 = a * ((a + 1.0f) + (a - 1.0f) * cos_w0 - beta);
+        a0 = (a + 1.0f) - (a - 1.0f) * cos_w0 + beta;
+        a1 = 2.0f * ((a - 1.0f) - (a + 1.0f) * cos_w0);
+        a2 = (a + 1.0f) - (a - 1.0f) * cos_w0 - beta;
+        output_gain = 1.0f;
+        break;
+    }
+    case FilterMode::LOWPASS_ONEPOLE: {
+        const float pole = std::exp(-w0);
+        b0 = 1.0f - pole;
+        a1 = -pole;
+        break;
+    }
+    case FilterMode::HIGHPASS_ONEPOLE: {
+        const float pole = std::exp(-w0);
+        b0 = (1.0f + pole) / 2.0f;
+        b1 = -b0;
+        a1 = -pole;
+        break;
+    }
+    default:
+        return result;
+    }
+
+    result.b0 = b0 * output_gain / a0;
+    result.b1 = b1 * output_gain / a0;
+    result.b2 = b2 * output_gain / a0;
+    result.a1 = a1 / a0;
+    result.a2 = a2 / a0;
+    return result;
+}
+
+void Filter::configure(const FilterSettings &settings, float sample_rate) {
+    if (configured && (settings == this->settings) && (sample_rate == this->sample_rate)) {
+        return;
+    }
+
+    const bool first = !configured;
+    this->settings = settings;
+    this->sample_rate = sample_rate;
+    configured = true;
+
+    target = compute_coefficients(settings, sample_rate);
+    if (first) {
+        current = target;
+        gliding = false;
+    } else {
+        gliding = true;
+    }
+}
+
+void Filter::reset() {
+    current = target;
+    gliding = false;
+    std::fill(std::begin(x1), std::end(x1), 0.0f);
+    std::fill(std::begin(x2), std::end(x2), 0.0f);
+    std::fill(std::begin(y1), std::end(y1), 0.0f);
+    std::fill(std::begin(y2), std::end(y2), 0.0f);
+}
+
+void Filter::process(float *samples, std::uint32_t frames) {
+    if (!frames || is_bypassed()) {
+        return;
+    }
+
+    Coefficients c = current;
+    Coefficients step;
+    if (gliding) {
+        // Linear glide from the previous coefficients, reaching the new ones at the end of the block
+        const float inverse = 1.0f / frames;
+        step.b0 = (target.b0 - c.b0) * inverse;
+        step.b1 = (target.b1 - c.b1) * inverse;
+        step.b2 = (target.b2 - c.b2) * inverse;
+        step.a1 = (target.a1 - c.a1) * inverse;
+        step.a2 = (target.a2 - c.a2) * inverse;
+    }
+
+    float lx1 = x1[0], lx2 = x2[0], ly1 = y1[0], ly2 = y2[0];
+    float rx1 = x1[1], rx2 = x2[1], ry1 = y1[1], ry2 = y2[1];
+
+    for (std::uint32_t i = 0; i < frames; i++) {
+        if (gliding) {
+            c.b0 += step.b0;
+            c.b1 += step.b1;
+            c.b2 += step.b2;
+            c.a1 += step.a1;
+            c.a2 += step.a2;
+        }
+
+        const float l = samples[i * 2];
+        const float r = samples[i * 2 + 1];
+        const float out_l = c.b0 * l + c.b1 * lx1 + c.b2 * lx2 - c.a1 * ly1 - c.a2 * ly2;
+        const float out_r = c.b0 * r + c.b1 * rx1 + c.b2 * rx2 - c.a1 * ry1 - c.a2 * ry2;
+
+        lx2 = lx1;
+        lx1 = l;
+        ly2 = ly1;
+        ly1 = out_l;
+        rx2 = rx1;
+        rx1 = r;
+        ry2 = ry1;
+        ry1 = out_r;
+
+        samples[i * 2] = out_l;
+        samples[i * 2 + 1] = out_r;
+    }
+
+    // Flush denormals that the decaying history would otherwise end up in
+    auto flush = [](float value) { return std::abs(value) < 1e-15f ? 0.0f : value; };
+    x1[0] = lx1;
+    x2[0] = lx2;
+    y1[0] = flush(ly1);
+    y2[0] = flush(ly2);
+    x1[1] = rx1;
+    x2[1] = rx2;
+    y1[1] = flush(ry1);
+    y2[1] = flush(ry2);
+
+    current = target;
+    gliding = false;
+}
+} // namespace ngs::dsp::biquad
@@ -0,0 +1,213 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+/**
+ * @file mix.cpp
+ * @brief NGS mixing and sample format conversion kernels
+ */
+
+#include <ngs/dsp/mix.h>
+
+#include <util/log.h>
+
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define NGS_MIX_X86
+#include <immintrin.h>
+#include <util/instrset_detect.h>
+// MSVC lets any intrinsic be used, other compilers need the functions using AVX2 to be marked
+#if defined(_MSC_VER) && !defined(__clang__)
+#define NGS_MIX_TARGET_AVX2
+#else
+#define NGS_MIX_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define NGS_MIX_NEON
+#include <arm_neon.h>
+#endif
+
+namespace ngs::dsp::mix {
+namespace reference {
+// Each output sample is its own channel of the source, then the other one, added to the destination
+void mix_stereo(float *dest, const float *source, const VolumeMatrix &volume_matrix, std::uint32_t frames) {
+    for (std::uint32_t i = 0; i < frames; i++) {
+        const float left = source[i * 2];
+        const float right = source[i * 2 + 1];
+        dest[i * 2] = std::clamp(dest[i * 2] + left * volume_matrix[0][0] + right * volume_matrix[1][0], -1.0f, 1.0f);
+        dest[i * 2 + 1] = std::clamp(dest[i * 2 + 1] + right * volume_matrix[1][1] + left * volume_matrix[0][1], -1.0f, 1.0f);
+    }
+}
+
+void float_to_s16(const float *source, std::int16_t *dest, std::uint32_t samples) {
+    for (std::uint32_t i = 0; i < samples; i++) {
+        dest[i] = static_cast<std::int16_t>(std::clamp(source[i] * 32768.0f, -32768.0f, 32767.0f));
+    }
+}
+} // namespace reference
+
+#if defined(NGS_MIX_X86)
+static void mix_stereo_sse2(float *dest, const float *source, const VolumeMatrix &volume_matrix, std::uint32_t frames) {
+    // Two frames per vector, the cross gains are applied to the source with its channels swapped
+    const __m128 direct = _mm_setr_ps(volume_matrix[0][0], volume_matrix[1][1], volume_matrix[0][0], volume_matrix[1][1]);
+    const __m128 cross = _mm_setr_ps(volume_matrix[1][0], volume_matrix[0][1], volume_matrix[1][0], volume_matrix[0][1]);
+    const __m128 low = _mm_set1_ps(-1.0f);
+    const __m128 high = _mm_set1_ps(1.0f);
+
+    std::uint32_t i = 0;
+    for (; i + 2 <= frames; i += 2) {
+        const __m128 src = _mm_loadu_ps(source + i * 2);
+        const __m128 swapped = _mm_shuffle_ps(src, src, _MM_SHUFFLE(2, 3, 0, 1));
+        __m128 result = _mm_add_ps(_mm_loadu_ps(dest + i * 2), _mm_mul_ps(src, direct));
+        result = _mm_add_ps(result, _mm_mul_ps(swapped, cross));
+        _mm_storeu_ps(dest + i * 2, _mm_min_ps(_mm_max_ps(result, low), high));
+    }
+
+    reference::mix_stereo(dest + i * 2, source + i * 2, volume_matrix, frames - i);
+}
+
+static void float_to_s16_sse2(const float *source, std::int16_t *dest, std::uint32_t samples) {
+    const __m128 scale = _mm_set1_ps(32768.0f);
+    const __m128 low = _mm_set1_ps(-32768.0f);
+    const __m128 high = _mm_set1_ps(32767.0f);
+
+    std::uint32_t i = 0;
+    for (; i + 8 <= samples; i += 8) {
+        const __m128 first = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(source + i), scale), low), high);
+        const __m128 second = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(source + i + 4), scale), low), high);
+        const __m128i packed = _mm_packs_epi32(_mm_cvttps_epi32(first), _mm_cvttps_epi32(second));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i), packed);
+    }
+
+    reference::float_to_s16(source + i, dest + i, samples - i);
+}
+
+NGS_MIX_TARGET_AVX2 static void mix_stereo_avx2(float *dest, const float *source, const VolumeMatrix &volume_matrix, std::uint32_t frames) {
+    const __m256 direct = _mm256_setr_ps(volume_matrix[0][0], volume_matrix[1][1], volume_matrix[0][0], volume_matrix[1][1],
+        volume_matrix[0][0], volume_matrix[1][1], volume_matrix[0][0], volume_matrix[1][1]);
+    const __m256 cross = _mm256_setr_ps(volume_matrix[1][0], volume_matrix[0][1], volume_matrix[1][0], volume_matrix[0][1],
+        volume_matrix[1][0], volume_matrix[0][1], volume_matrix[1][0], volume_matrix[0][1]);
+    const __m256 low = _mm256_set1_ps(-1.0f);
+    const __m256 high = _mm256_set1_ps(1.0f);
+
+    std::uint32_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        const __m256 src = _mm256_loadu_ps(source + i * 2);
+        const __m256 swapped = _mm256_permute_ps(src, _MM_SHUFFLE(2, 3, 0, 1));
+        __m256 result = _mm256_add_ps(_mm256_loadu_ps(dest + i * 2), _mm256_mul_ps(src, direct));
+        result = _mm256_add_ps(result, _mm256_mul_ps(swapped, cross));
+        _mm256_storeu_ps(dest + i * 2, _mm256_min_ps(_mm256_max_ps(result, low), high));
+    }
+
+    mix_stereo_sse2(dest + i * 2, source + i * 2, volume_matrix, frames - i);
+}
+
+NGS_MIX_TARGET_AVX2 static void float_to_s16_avx2(const float *source, std::int16_t *dest, std::uint32_t samples) {
+    const __m256 scale = _mm256_set1_ps(32768.0f);
+    const __m256 low = _mm256_set1_ps(-32768.0f);
+    const __m256 high = _mm256_set1_ps(32767.0f);
+
+    std::uint32_t i = 0;
+    for (; i + 16 <= samples; i += 16) {
+        const __m256 first = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(source + i), scale), low), high);
+        const __m256 second = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(source + i + 8), scale), low), high);
+        // Packing works on each 128-bit lane, put the quarters back in order
+        const __m256i packed = _mm256_packs_epi32(_mm256_cvttps_epi32(first), _mm256_cvttps_epi32(second));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dest + i), _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0)));
+    }
+
+    float_to_s16_sse2(source + i, dest + i, samples - i);
+}
+#elif defined(NGS_MIX_NEON)
+static void mix_stereo_neon(float *dest, const float *source, const VolumeMatrix &volume_matrix, std::uint32_t frames) {
+    const float direct_values[4] = { volume_matrix[0][0], volume_matrix[1][1], volume_matrix[0][0], volume_matrix[1][1] };
+    const float cross_values[4] = { volume_matrix[1][0], volume_matrix[0][1], volume_matrix[1][0], volume_matrix[0][1] };
+    const float32x4_t direct = vld1q_f32(direct_values);
+    const float32x4_t cross = vld1q_f32(cross_values);
+    const float32x4_t low = vdupq_n_f32(-1.0f);
+    const float32x4_t high = vdupq_n_f32(1.0f);
+
+    std::uint32_t i = 0;
+    for (; i + 2 <= frames; i += 2) {
+        const float32x4_t src = vld1q_f32(source + i * 2);
+        const float32x4_t swapped = vrev64q_f32(src);
+        // No fused multiply-add, to round like the reference
+        float32x4_t result = vaddq_f32(vld1q_f32(dest + i * 2), vmulq_f32(src, direct));
+        result = vaddq_f32(result, vmulq_f32(swapped, cross));
+        vst1q_f32(dest + i * 2, vminq_f32(vmaxq_f32(result, low), high));
+    }
+
+    reference::mix_stereo(dest + i * 2, source + i * 2, volume_matrix, frames - i);
+}
+
+static void float_to_s16_neon(const float *source, std::int16_t *dest, std::uint32_t samples) {
+    const float32x4_t scale = vdupq_n_f32(32768.0f);
+
+    std::uint32_t i = 0;
+    for (; i + 8 <= samples; i += 8) {
+        // Both the conversion and the narrowing saturate
+        const int32x4_t first = vcvtq_s32_f32(vmulq_f32(vld1q_f32(source + i), scale));
+        const int32x4_t second = vcvtq_s32_f32(vmulq_f32(vld1q_f32(source + i + 4), scale));
+        vst1q_s16(dest + i, vcombine_s16(vqmovn_s32(first), vqmovn_s32(second)));
+    }
+
+    reference::float_to_s16(source + i, dest + i, samples - i);
+}
+#endif
+
+typedef void (*MixStereoFunc)(float *dest, const float *source, const VolumeMatrix &volume_matrix, std::uint32_t frames);
+typedef void (*FloatToS16Func)(const float *source, std::int16_t *dest, std::uint32_t samples);
+
+struct Kernels {
+    const char *name;
+    MixStereoFunc mix_stereo;
+    FloatToS16Func float_to_s16;
+};
+
+static Kernels select_kernels() {
+#if defined(NGS_MIX_X86)
+    if (util::instrset::instrset_detect() >= util::instrset::instrset_AVX2)
+        return { "AVX2", mix_stereo_avx2, float_to_s16_avx2 };
+    return { "SSE2", mix_stereo_sse2, float_to_s16_sse2 };
+#elif defined(NGS_MIX_NEON)
+    return { "NEON", mix_stereo_neon, float_to_s16_neon };
+#else
+    return { "scalar", reference::mix_stereo, reference::float_to_s16 };
+#endif
+}
+
+static const Kernels &get_kernels() {
+    static const Kernels kernels = [] {
+        const Kernels selected = select_kernels();
+        LOG_INFO("Using {} kernels for NGS mixing", selected.name);
+        return selected;
+    }();
+    return kernels;
+}
+
+void mix_stereo(float *dest, const float *source, const VolumeMatrix &volume_matrix, std::uint32_t frames) {
+    get_kernels().mix_stereo(dest, source, volume_matrix, frames);
+}
+
+void float_to_s16(const float *source, std::int16_t *dest, std::uint32_t samples) {
+    get_kernels().float_to_s16(source, dest, samples);
+}
+
+const char *kernels_name() {
+    return get_kernels().name;
+}
+} // namespace ngs::dsp::mix
@@ -27,127 +27,122 @@
 #include <codec/state.h>
 #include <ngs/dsp/playback_rate.h>
 
+#include <algorithm>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
-#include <cstring>
 
 namespace ngs::dsp::playback_rate {
 
-Scaler::Scaler(ngs::dsp::playback_rate::scaling_settings *settings) {
-    // Set settings
-    this->settings = settings;
+// The linear resampler steps through the input by the scaling factor, it must stay positive
+static constexpr float MIN_SCALING_FACTOR = 1.0f / 64.0f;
+static constexpr float MAX_SCALING_FACTOR = 64.0f;
 
-    // Set up SoundTouch object
-    this->scaler.setSampleRate(int(this->settings->source_playback_rate));
-    this->scaler.setChannels(int(this->settings->channels));
-    this->scaler.setRate(this->settings->scaling_factor);
-};
-
-unsigned int Scaler::scale(std::vector<std::uint8_t> *audio_input) {
-    unsigned int resulting_samples_count = 0;
-
-    // Elements of the audio input array
-    unsigned int input_elements_amount = 0;
-    input_elements_amount = audio_input->size();
-
-    // Real amount of input floating point elements/samples
-    unsigned int real_elements_amount = 0;
-    real_elements_amount = input_elements_amount / 4;
-
-    // Fixed length buffer for floating-point input samples
-    const unsigned int bufferSize = 2048;
-    float fsamples_input[bufferSize];
-    for (unsigned int i = 0; i < bufferSize; i++) {
-        fsamples_input[i] = 0;
+void Scaler::configure(const ngs::dsp::playback_rate::scaling_settings &requested_settings) {
+    ngs::dsp::playback_rate::scaling_settings settings = requested_settings;
+    if (!std::isfinite(settings.scaling_factor)) {
+        settings.scaling_factor = 1.0f;
     }
+    settings.scaling_factor = std::clamp(settings.scaling_factor, MIN_SCALING_FACTOR, MAX_SCALING_FACTOR);
 
-    // Fixed length buffer to receive values from scaler
-    float fsamples_output_receive[bufferSize];
-    for (unsigned int i = 0; i < bufferSize; i++) {
-        fsamples_output_receive[i] = 0;
+    if (configured && (settings == this->settings)) {
+        return;
     }
 
-    // Amount of input samples that have already been passed to scaler
-    unsigned int already_passed_samples = 0;
-
-    // Loop to control the i/o of audio data into/from scaler based on fixed-sized buffers
-    do {
-        // Amount of input samples passed to scaler this round
-        unsigned int samples_to_pass_this_round = 0;
-        if ((real_elements_amount - already_passed_samples) < bufferSize) {
-            samples_to_pass_this_round = real_elements_amount - already_passed_samples;
-        } else {
-            samples_to_pass_this_round = bufferSize;
-        }
+    const bool keep_stream = configured && (settings.channels == this->settings.channels);
+    const bool was_soundtouch = use_soundtouch;
 
-        // Perform conversion between uint8_t and float
-        // Input audio buffer is a uint8_t array, which in reality is an array
-        // of floating-point 32-bit (4 bytes) values stored in LSB order
-        // https://wiki.libsdl.org/SDL_AudioFormat
-        for (unsigned int i = 0; i < samples_to_pass_this_round; i++) {
-            std::memcpy(&fsamples_input[i], audio_input->data() + (i + already_passed_samples) * sizeof(float), sizeof(float));
-        }
+    this->settings = settings;
+    configured = true;
+    use_soundtouch = settings.scaling_factor > 1.0f;
 
-        // Pass audio input samples to scaler
-        this->scaler.putSamples(fsamples_input, samples_to_pass_this_round / this->settings->channels);
-        already_passed_samples += samples_to_pass_this_round;
+    if (!keep_stream) {
+        history.assign(settings.channels, 0.0f);
+        position = 1.0;
+    }
+
+    // Set up SoundTouch object
+    if (use_soundtouch) {
+        if (!keep_stream || !was_soundtouch) {
+            this->scaler.clear();
+            this->scaler.setChannels(int(settings.channels));
+        }
+        this->scaler.setSampleRate(int(settings.source_playback_rate));
+        this->scaler.setRate(settings.scaling_factor);
+    }
+}
 
-        // Amount of received samples from scaler on the last receive call
-        unsigned int last_received_samples = 0;
-        // Amount of output samples that have been collected from scaler
-        unsigned int already_written_samples = 0;
-        do {
-            // Dump samples into fixed array for temporal values and get the amount of returned samples
-            last_received_samples = this->scaler.receiveSamples(fsamples_output_receive, bufferSize / this->settings->channels) * this->settings->channels;
+void Scaler::reset() {
+    if (!configured) {
+        return;
+    }
 
-            // Resize output vector to receive the new samples just dumped into the fixed array
-            this->fsamples_output.resize(this->fsamples_output.size() + last_received_samples);
+    this->scaler.clear();
+    std::fill(history.begin(), history.end(), 0.0f);
+    position = 1.0;
+}
 
-            // Append samples to the cumulative output vector
-            for (unsigned int i = 0; i < last_received_samples; i += 1) {
-                this->fsamples_output.at(already_written_samples + i) = fsamples_output_receive[i];
-            }
+unsigned int Scaler::scale(const float *input, unsigned int frames) {
+    fsamples_output.clear();
 
-            already_written_samples += last_received_samples;
+    if (!configured) {
+        return 0;
+    }
 
-        } while (last_received_samples != 0);
+    return use_soundtouch ? scale_soundtouch(input, frames) : scale_linear(input, frames);
+}
 
-        // Flush remaining samples and append
-        this->scaler.flush();
-        do {
-            // Dump samples into fixed array for temporal values and get the amount of returned samples
-            last_received_samples = this->scaler.receiveSamples(fsamples_output_receive, bufferSize / this->settings->channels) * this->settings->channels;
+unsigned int Scaler::scale_linear(const float *input, unsigned int frames) {
+    const unsigned int channels = settings.channels;
+    const double step = settings.scaling_factor;
 
-            // Resize output vector to receive the new samples just dumped into the fixed array
-            this->fsamples_output.resize(this->fsamples_output.size() + last_received_samples);
+    // Frame i of the input sits at position i + 1, the previous call's last frame at 0.
+    // An output frame needs the input frame after it, so the last one stays in history for the next call.
+    const unsigned int output_frames = (position < frames) ? static_cast<unsigned int>(std::ceil((frames - position) / step)) : 0;
+    fsamples_output.resize(static_cast<std::size_t>(output_frames) * channels);
 
-            // Append samples to the cumulative output vector
-            for (unsigned int i = 0; i < last_received_samples; i += 1) {
-                this->fsamples_output.at(already_written_samples + i) = fsamples_output_receive[i];
-            }
+    float *output = fsamples_output.data();
+    unsigned int produced = 0;
+    for (; (produced < output_frames) && (position < frames); produced++, position += step) {
+        const unsigned int index = static_cast<unsigned int>(position);
+        const float fraction = static_cast<float>(position - index);
+        const float *previous = (index == 0) ? history.data() : input + (index - 1) * channels;
+        const float *next = input + index * channels;
 
-            already_written_samples += last_received_samples;
+        for (unsigned int c = 0; c < channels; c++) {
+            *output++ = previous[c] + (next[c] - previous[c]) * fraction;
+        }
+    }
 
-        } while (last_received_samples != 0);
+    fsamples_output.resize(static_cast<std::size_t>(produced) * channels);
 
-    } while (already_passed_samples < real_elements_amount);
+    if (frames) {
+        std::copy(input + (frames - 1) * channels, input + frames * channels, history.begin());
+        position -= frames;
+    }
 
-    // Clear internal buffers of scaler
-    this->scaler.clear();
+    return produced;
+}
 
-    resulting_samples_count = fsamples_output.size();
+unsigned int Scaler::scale_soundtouch(const float *input, unsigned int frames) {
+    // Pass audio input frames to scaler, which keeps what it can't process yet for the next call
+    this->scaler.putSamples(input, frames);
 
-    return resulting_samples_count;
-};
+    const unsigned int available = this->scaler.numSamples();
+    fsamples_output.resize(static_cast<std::size_t>(available) * settings.channels);
 
-int Scaler::receive(std::vector<std::uint8_t> *audio_output) {
-    // Convert from floating-point sample values vector to uint8_t vector
-    // storing each 8 bits of each sample value in one element in LSB order
-    for (unsigned int i = 0; i < this->fsamples_output.size(); i++) {
-        std::memcpy(audio_output->data() + i * sizeof(float), this->fsamples_output.data() + i, sizeof(float));
+    // Receive scaled frames straight into the output
+    unsigned int received = 0;
+    while (received < available) {
+        const unsigned int last_received = this->scaler.receiveSamples(fsamples_output.data() + received * settings.channels, available - received);
+        if (last_received == 0) {
+            break;
+        }
+        received += last_received;
     }
 
-    return 0;
-};
+    fsamples_output.resize(static_cast<std::size_t>(received) * settings.channels);
+    return received;
+}
 
-}; // namespace ngs::dsp::playback_rate
+} // namespace ngs::dsp::playback_rate
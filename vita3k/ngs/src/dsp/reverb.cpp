@@ -0,0 +1,212 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+/**
+ * @file reverb.cpp
+ * @brief NGS reverb
+ */
+
+#include <ngs/dsp/reverb.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace ngs::dsp::reverb {
+static constexpr float PI = 3.14159265358979f;
+
+// Mutually prime lengths at 48 kHz, scaled by the density
+static constexpr std::uint32_t LINE_LENGTHS[Reverb::LINE_COUNT] = { 1433, 1601, 1867, 2053 };
+static constexpr std::uint32_t DIFFUSER_LENGTHS[2] = { 142, 379 };
+static constexpr float MAX_PREDELAY = 0.3f + 0.1f;
+
+bool Settings::operator==(const Settings &other) const {
+    return (dry == other.dry) && (room == other.room) && (room_hf == other.room_hf) && (decay_time == other.decay_time)
+        && (decay_hf_ratio == other.decay_hf_ratio) && (reflections == other.reflections) && (reflections_delay == other.reflections_delay)
+        && (reverb == other.reverb) && (reverb_delay == other.reverb_delay) && (diffusion == other.diffusion) && (density == other.density)
+        && (hf_reference == other.hf_reference);
+}
+
+void Reverb::DelayLine::resize(std::uint32_t length) {
+    if (buffer.size() != length) {
+        buffer.assign(std::max<std::uint32_t>(length, 1), 0.0f);
+        position = 0;
+    }
+}
+
+void Reverb::DelayLine::clear() {
+    std::fill(buffer.begin(), buffer.end(), 0.0f);
+    position = 0;
+}
+
+// Pole of a one-pole lowpass attenuating by gain (at most 1) at the given frequency
+static float lowpass_pole(float gain, float frequency, float sample_rate) {
+    gain = std::clamp(gain, 0.001f, 1.0f);
+    if (gain >= 0.999f) {
+        return 0.0f;
+    }
+
+    const float cos_w = std::cos(2.0f * PI * std::min(frequency, sample_rate * 0.49f) / sample_rate);
+    const float g2 = gain * gain;
+    const float b = 1.0f - g2 * cos_w;
+    const float c = 1.0f - g2;
+    return std::clamp((b - std::sqrt(std::max(b * b - c * c, 0.0f))) / c, 0.0f, 0.99f);
+}
+
+void Reverb::configure(const Settings &settings, float sample_rate) {
+    if (configured && (settings == this->settings) && (sample_rate == this->sample_rate)) {
+        return;
+    }
+
+    const bool first = !configured || (sample_rate != this->sample_rate);
+    this->settings = settings;
+    this->sample_rate = sample_rate;
+    configured = true;
+
+    const float rate_scale = sample_rate / 48000.0f;
+    const float density = std::clamp(settings.density, 0.0f, 1.0f);
+    const float decay_time = std::clamp(settings.decay_time, 0.1f, 20.0f);
+    const float decay_hf_ratio = std::clamp(settings.decay_hf_ratio, 0.1f, 2.0f);
+
+    predelay.resize(static_cast<std::uint32_t>(MAX_PREDELAY * sample_rate) + 2);
+    const float reflections_delay = std::clamp(settings.reflections_delay, 0.0f, 0.3f) * sample_rate;
+    const float reverb_delay = std::clamp(settings.reverb_delay, 0.0f, 0.1f) * sample_rate;
+    // The right channel hears the reflections a bit later, for some width
+    reflections_taps[0] = static_cast<std::uint32_t>(reflections_delay);
+    reflections_taps[1] = static_cast<std::uint32_t>(reflections_delay + 0.0023f * sample_rate);
+    late_tap = static_cast<std::uint32_t>(reflections_delay + reverb_delay);
+
+    room_lowpass = lowpass_pole(settings.room_hf, settings.hf_reference, sample_rate);
+
+    for (std::uint32_t i = 0; i < 2; i++) {
+        diffusers[i].resize(static_cast<std::uint32_t>(DIFFUSER_LENGTHS[i] * rate_scale));
+    }
+    diffusion_gain = 0.7f * std::clamp(settings.diffusion, 0.0f, 1.0f);
+
+    for (std::uint32_t i = 0; i < LINE_COUNT; i++) {
+        const std::uint32_t length = static_cast<std::uint32_t>(LINE_LENGTHS[i] * rate_scale * (0.4f + 0.6f * density));
+        lines[i].resize(length);
+
+        // -60 dB after decay_time, and after decay_time * decay_hf_ratio at hf_reference
+        line_gains[i] = std::pow(10.0f, -3.0f * length / (decay_time * sample_rate));
+        const float hf_gain = std::pow(10.0f, -3.0f * length / (decay_time * decay_hf_ratio * sample_rate));
+        line_lowpass[i] = lowpass_pole(hf_gain / line_gains[i], settings.hf_reference, sample_rate);
+    }
+
+    target.dry = settings.dry;
+    target.reflections = settings.room * settings.reflections;
+    // The four lines add up, and the network has unit energy gain
+    target.reverb = settings.room * settings.reverb * 0.5f;
+    if (first) {
+        current = target;
+    }
+}
+
+void Reverb::reset() {
+    predelay.clear();
+    for (auto &diffuser : diffusers)
+        diffuser.clear();
+    for (auto &line : lines)
+        line.clear();
+    room_lowpass_state = 0.0f;
+    line_lowpass_state.fill(0.0f);
+    current = target;
+}
+
+void Reverb::process(const float *input, float *output, std::uint32_t frames) {
+    if (!configured || !frames) {
+        return;
+    }
+
+    const float inverse = 1.0f / frames;
+    const float dry_step = (target.dry - current.dry) * inverse;
+    const float reflections_step = (target.reflections - current.reflections) * inverse;
+    const float reverb_step = (target.reverb - current.reverb) * inverse;
+    float dry = current.dry;
+    float reflections = current.reflections;
+    float reverb = current.reverb;
+
+    const std::uint32_t predelay_size = static_cast<std::uint32_t>(predelay.buffer.size());
+    float *const predelay_data = predelay.buffer.data();
+
+    for (std::uint32_t i = 0; i < frames; i++) {
+        dry += dry_step;
+        reflections += reflections_step;
+        reverb += reverb_step;
+
+        const float left = input[i * 2];
+        const float right = input[i * 2 + 1];
+
+        // Room tone
+        room_lowpass_state = (left + right) * 0.5f * (1.0f - room_lowpass) + room_lowpass_state * room_lowpass;
+
+        predelay_data[predelay.position] = room_lowpass_state;
+        const float early_left = predelay_data[(predelay.position + predelay_size - reflections_taps[0]) % predelay_size];
+        const float early_right = predelay_data[(predelay.position + predelay_size - reflections_taps[1]) % predelay_size];
+        float late = predelay_data[(predelay.position + predelay_size - late_tap) % predelay_size];
+        predelay.position = (predelay.position + 1) % predelay_size;
+
+        // Schroeder allpasses smear the input before it reaches the network
+        for (auto &diffuser : diffusers) {
+            float &delayed = diffuser.buffer[diffuser.position];
+            const float fed = late + delayed * diffusion_gain;
+            late = delayed - fed * diffusion_gain;
+            delayed = fed;
+            diffuser.position = (diffuser.position + 1) % diffuser.buffer.size();
+        }
+
+        // Feedback delay network, the loops over the lines are meant to be vectorized
+        float outputs[LINE_COUNT];
+        for (std::uint32_t j = 0; j < LINE_COUNT; j++) {
+            outputs[j] = lines[j].buffer[lines[j].position];
+        }
+
+        float damped[LINE_COUNT];
+        for (std::uint32_t j = 0; j < LINE_COUNT; j++) {
+            line_lowpass_state[j] = outputs[j] * (1.0f - line_lowpass[j]) + line_lowpass_state[j] * line_lowpass[j];
+            damped[j] = line_lowpass_state[j] * line_gains[j];
+        }
+
+        // Hadamard mixing, scaled to stay lossless
+        const float sum01 = damped[0] + damped[1];
+        const float diff01 = damped[0] - damped[1];
+        const float sum23 = damped[2] + damped[3];
+        const float diff23 = damped[2] - damped[3];
+        const float feedback[LINE_COUNT] = {
+            (sum01 + sum23) * 0.5f,
+            (diff01 + diff23) * 0.5f,
+            (sum01 - sum23) * 0.5f,
+            (diff01 - diff23) * 0.5f,
+        };
+
+        for (std::uint32_t j = 0; j < LINE_COUNT; j++) {
+            lines[j].buffer[lines[j].position] = late + feedback[j];
+            lines[j].position = (lines[j].position + 1) % lines[j].buffer.size();
+        }
+
+        output[i * 2] = left * dry + early_left * reflections + (outputs[0] + outputs[2]) * reverb;
+        output[i * 2 + 1] = right * dry + early_right * reflections + (outputs[1] + outputs[3]) * reverb;
+    }
+
+    // Flush denormals out of the recursive filters
+    auto flush = [](float value) { return std::abs(value) < 1e-15f ? 0.0f : value; };
+    room_lowpass_state = flush(room_lowpass_state);
+    for (float &state : line_lowpass_state)
+        state = flush(state);
+
+    current = target;
+}
+} // namespace ngs::dsp::reverb
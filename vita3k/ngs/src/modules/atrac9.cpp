@@ -19,10 +19,11 @@
 #include <util/bytes.h>
 #include <util/log.h>
 
+#include <algorithm>
+
 namespace ngs::atrac9 {
 Module::Module()
-    : ngs::Module(ngs::BussType::BUSS_ATRAC9)
-    , last_config(0) {}
+    : ngs::Module(ngs::BussType::BUSS_ATRAC9) {}
 
 void get_buffer_parameter(const std::uint32_t start_sample, const std::uint32_t num_samples, const std::uint32_t info, SkipBufferInfo &parameter) {
     const std::uint8_t sample_rate_index = ((info & (0b1111 << 12)) >> 12);
@@ -68,6 +69,7 @@ void Module::on_state_change(ModuleData &data, const VoiceState previous) {
 bool Module::process(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data) {
     const Parameters *params = data.get_parameters<Parameters>(mem);
     State *state = data.get_state<State>();
+    VoiceContext *context = data.get_voice_context<VoiceContext>();
 
     assert(state);
 
@@ -77,10 +79,11 @@ bool Module::process(KernelState &kern, const MemState &mem, const SceUID thread
 
     bool finished = false;
     // making this maybe to early...
-    if (!decoder || (params->config_data != last_config)) {
-        decoder = std::make_unique<Atrac9DecoderState>(params->config_data);
-        last_config = params->config_data;
+    if (!context->decoder || (params->config_data != context->last_config)) {
+        context->decoder = std::make_unique<Atrac9DecoderState>(params->config_data);
+        context->last_config = params->config_data;
     }
+    Atrac9DecoderState *decoder = context->decoder.get();
 
     auto try_cycle_to_next_buffer = [&]() {
         if (state->current_byte_position_in_buffer >= params->buffer_params[state->current_buffer].bytes_count) {
@@ -119,19 +122,19 @@ bool Module::process(KernelState &kern, const MemState &mem, const SceUID thread
         }
     };
 
-    if (static_cast<std::uint32_t>(state->decoded_samples_pending) < data.parent->rack->system->granularity) {
-        if (!data.extra_storage.empty()) {
-            data.extra_storage.erase(data.extra_storage.begin(), data.extra_storage.begin() + state->decoded_passed * 8);
-        }
+    const std::uint32_t granularity = data.parent->rack->system->granularity;
+    SampleRingBuffer &decoded_samples = context->decoded_samples;
 
-        state->decoded_passed = 0;
+    if (decoded_samples.size() < granularity) {
+        const std::uint32_t samples_per_superframe = decoder->get_samples_per_superframe();
+        decoded_samples.reserve(granularity + samples_per_superframe, std::max(granularity, samples_per_superframe));
 
-        while (static_cast<std::int32_t>(state->decoded_samples_pending) < data.parent->rack->system->granularity) {
+        while (decoded_samples.size() < granularity) {
             const ngs::atrac9::BufferParameters *bufparam = &params->buffer_params[state->current_buffer];
 
             if ((state->current_buffer == -1) || (bufparam->bytes_count == 0)) {
                 // Fill it then break
-                data.fill_to_fit_granularity();
+                decoded_samples.write_silence(granularity - decoded_samples.size());
                 finished = true;
                 break;
             }
@@ -147,7 +150,8 @@ bool Module::process(KernelState &kern, const MemState &mem, const SceUID thread
                 std::uint32_t frame_bytes_gotten = bufparam->bytes_count - state->current_byte_position_in_buffer;
                 state->current_byte_position_in_buffer += superframe_size;
 
-                std::vector<std::uint8_t> temporary_bytes;
+                std::vector<std::uint8_t> &temporary_bytes = context->superframe_bytes;
+                temporary_bytes.clear();
 
                 if (frame_bytes_gotten < superframe_size) {
                     while (frame_bytes_gotten < superframe_size) {
@@ -178,44 +182,43 @@ bool Module::process(KernelState &kern, const MemState &mem, const SceUID thread
                     input = temporary_bytes.data();
                 }
 
-                const std::size_t curr_pos = state->decoded_samples_pending * sizeof(float) * 2;
-
-                data.extra_storage.resize(curr_pos + decoder->get_samples_per_superframe() * sizeof(float) * 2);
+                float *dest = decoded_samples.begin_write(samples_per_superframe);
+                std::uint32_t samples_converted = 0;
+                const bool decode_success = decoder->send(input, decoder->get_superframe_size());
 
-                if (decoder->send(input, decoder->get_superframe_size())) {
+                if (decode_success) {
                     // convert from int16 to float
                     uint32_t const channel_count = decoder->get_channel_count();
                     uint32_t const sample_rate = decoder->get(DecoderQuery::SAMPLE_RATE);
-                    std::vector<std::uint8_t> temporary_bytes(decoder->get_samples_per_superframe() * sizeof(int16_t) * channel_count);
+                    context->decoded.resize(samples_per_superframe * sizeof(int16_t) * channel_count);
                     DecoderSize decoder_size;
-                    decoder->receive(temporary_bytes.data(), &decoder_size);
-                    resample_s16_to_f32(reinterpret_cast<const int16_t *>(temporary_bytes.data()), channel_count, decoder_size.samples, sample_rate,
-                        reinterpret_cast<float *>(data.extra_storage.data() + curr_pos), decoder_size.samples, sample_rate);
-                } else {
+                    decoder->receive(context->decoded.data(), &decoder_size);
+                    samples_converted = std::min(decoder_size.samples, samples_per_superframe);
+                    context->converter.convert(reinterpret_cast<const int16_t *>(context->decoded.data()), channel_count, samples_converted, sample_rate,
+                        dest, samples_converted, sample_rate);
+                }
+
+                std::fill(dest + samples_converted * 2, dest + samples_per_superframe * 2, 0.0f);
+                decoded_samples.end_write(samples_per_superframe);
+
+                if (!decode_success) {
                     data.parent->voice_lock->unlock();
                     data.invoke_callback(kern, mem, thread_id, SCE_NGS_AT9_CALLBACK_REASON_DECODE_ERROR, state->current_byte_position_in_buffer,
                         params->buffer_params[state->current_buffer].buffer.address());
                     data.parent->voice_lock->lock();
                 }
 
-                state->samples_generated_since_key_on += decoder->get_samples_per_superframe();
+                state->samples_generated_since_key_on += samples_per_superframe;
                 state->bytes_consumed_since_key_on += decoder->get_superframe_size();
                 state->total_bytes_consumed += decoder->get_superframe_size();
-
-                state->decoded_samples_pending += decoder->get_samples_per_superframe();
             }
 
             try_cycle_to_next_buffer();
         }
     }
 
-    std::uint8_t *data_ptr = data.extra_storage.data() + 2 * sizeof(float) * state->decoded_passed;
-    std::uint32_t samples_to_be_passed = data.parent->rack->system->granularity;
-
-    data.parent->products[0].data = data_ptr;
-
-    state->decoded_samples_pending = (state->decoded_samples_pending < samples_to_be_passed) ? 0 : (state->decoded_samples_pending - samples_to_be_passed);
-    state->decoded_passed += samples_to_be_passed;
+    data.parent->products[0].data = reinterpret_cast<std::uint8_t *>(decoded_samples.read(granularity));
+    decoded_samples.consume(granularity);
 
     return finished;
 }
@@ -26,17 +26,39 @@ std::size_t Module::get_buffer_parameter_size() const {
     return default_normal_parameter_size;
 }
 
+void Module::on_state_change(ModuleData &data, const VoiceState previous) {
+    if (data.parent->state == VOICE_STATE_AVAILABLE) {
+        for (auto &filter : data.get_voice_context<VoiceContext>()->filters)
+            filter.reset();
+    }
+}
+
 bool Module::process(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data) {
-    // TODO: Proper implement it, for now just lower volume lol
     float *product_before = reinterpret_cast<float *>(data.parent->products[0].data);
+    const Parameters *params = data.info.data ? data.get_parameters<Parameters>(mem) : nullptr;
+
+    // Parameters never set by the game leave the audio untouched
+    if (product_before && params && (params->descriptor.size >= sizeof(Parameters))) {
+        VoiceContext *context = data.get_voice_context<VoiceContext>();
+        const float sample_rate = static_cast<float>(data.parent->rack->system->sample_rate);
+        const std::uint32_t granularity = data.parent->rack->system->granularity;
+
+        for (std::size_t i = 0; i < MAX_FILTERS; i++) {
+            const FilterParameters &filter_params = params->filters[i];
+            dsp::biquad::FilterSettings settings;
+            if ((filter_params.mode > 0) && (filter_params.mode <= static_cast<SceInt32>(dsp::biquad::FilterMode::LOWPASS_RESONANT_NORMALIZED))) {
+                settings.mode = static_cast<dsp::biquad::FilterMode>(filter_params.mode);
+                settings.frequency = filter_params.frequency;
+                settings.resonance = filter_params.resonance;
+                settings.gain = filter_params.gain;
+            }
 
-    if (product_before) {
-        for (std::int32_t i = 0; i < data.parent->rack->system->granularity * 2; i++) {
-            product_before[i] *= 0.5f;
+            context->filters[i].configure(settings, sample_rate);
+            context->filters[i].process(product_before, granularity);
         }
     }
 
-    // It should do some modifications to create 4 outputs, but I'm not sure what yet kkk
+    // Every output carries the equalized audio
     data.parent->products[1] = data.parent->products[0];
     data.parent->products[2] = data.parent->products[0];
     data.parent->products[3] = data.parent->products[0];
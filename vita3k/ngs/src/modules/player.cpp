@@ -36,44 +36,42 @@ void Module::on_state_change(ModuleData &data, const VoiceState previous) {
         state->current_byte_position_in_buffer = 0;
         state->current_loop_count = 0;
         state->current_buffer = 0;
+
+        data.get_voice_context<VoiceContext>()->scaler.reset();
     }
 }
 
 bool Module::process(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data) {
     const Parameters *params = data.get_parameters<Parameters>(mem);
     State *state = data.get_state<State>();
+    VoiceContext *context = data.get_voice_context<VoiceContext>();
     bool finished = false;
 
     // If decoder hasn't been initialized or ADPCM format is going to be used
-    if (!decoder || (decoder->he_adpcm != static_cast<bool>(params->type))) {
+    if (!context->decoder || (context->decoder->he_adpcm != static_cast<bool>(params->type))) {
         // Create decoder specifying the desired destination sample rate
-        decoder = std::make_unique<PCMDecoderState>(data.parent->rack->system->sample_rate);
+        context->decoder = std::make_unique<PCMDecoderState>(data.parent->rack->system->sample_rate);
 
         // Enable ADPCM mode on the just created decoder if needed
-        decoder->he_adpcm = static_cast<bool>(params->type);
+        context->decoder->he_adpcm = static_cast<bool>(params->type);
     }
+    PCMDecoderState *decoder = context->decoder.get();
+
+    const std::uint32_t granularity = data.parent->rack->system->granularity;
+    SampleRingBuffer &decoded_samples = context->decoded_samples;
 
     // If the amount of samples already processed and pending to be passed is smaller than the amount of samples of the audio buffer
-    if (static_cast<std::int32_t>(state->decoded_gran_pending) < data.parent->rack->system->granularity) {
-        // Memory cleaning check
-        if (!data.extra_storage.empty()) {
-            // Delete data from previous processing if memory isn't empty
-            data.extra_storage.erase(data.extra_storage.begin(), data.extra_storage.begin() + state->decoded_gran_passed * 8);
-        } else {
-            // If memory is already empty and there's no buffer in need of processing or the current buffer has no data then stop processing
-            if ((state->current_buffer == -1) || (params->buffer_params[state->current_buffer].bytes_count == 0)) {
-                return true;
-            }
+    if (decoded_samples.size() < granularity) {
+        // If there's nothing left and there's no buffer in need of processing or the current buffer has no data then stop processing
+        if (!decoded_samples.size() && ((state->current_buffer == -1) || (params->buffer_params[state->current_buffer].bytes_count == 0))) {
+            return true;
         }
 
-        // Reset the passed samples count to 0
-        state->decoded_gran_passed = 0;
-
-        while (static_cast<std::int32_t>(state->decoded_gran_pending) < data.parent->rack->system->granularity) {
+        while (decoded_samples.size() < granularity) {
             // Ran out of data, supply new
             // Decode new data and deliver them
             // Let's open our context
-            if ((data.extra_storage.size() < sizeof(float) * 2 * data.parent->rack->system->granularity) && (state->current_buffer != -1)) {
+            if (state->current_buffer != -1) {
                 // Set up decoder
                 decoder->source_channels = params->channels;
                 decoder->source_frequency = params->playback_frequency;
@@ -91,64 +89,40 @@ bool Module::process(KernelState &kern, const MemState &mem, const SceUID thread
 
                 // Playback rate scaling
                 if (params->playback_scalar != 1) {
-                    LOG_INFO_IF(this->LOG_PLAYBACK_SCALING, "The currently running game requests playback rate scaling when decoding audio. Audio might crackle.");
-                    this->LOG_PLAYBACK_SCALING = false;
-
-                    // Received decoded samples from decoder
-                    std::vector<std::uint8_t> decoded_data(samples_count.samples * sizeof(float), 0);
+                    LOG_INFO_IF(this->LOG_PLAYBACK_SCALING.exchange(false), "The currently running game requests playback rate scaling when decoding audio.");
 
                     // Receive the samples processed by the decoder
-                    decoder->receive(decoded_data.data(), nullptr);
+                    context->unscaled_samples.resize(samples_count.samples);
+                    decoder->receive(reinterpret_cast<std::uint8_t *>(context->unscaled_samples.data()), nullptr);
 
-                    // Playback scaler settings
+                    // Playback scaler settings, the decoder output is stereo at the system sample rate
                     ngs::dsp::playback_rate::scaling_settings scaling_settings;
                     scaling_settings.scaling_factor = params->playback_scalar;
-                    scaling_settings.source_playback_rate = decoder->source_frequency;
-                    scaling_settings.channels = decoder->source_channels;
-
-                    // Initiate scaler object
-                    ngs::dsp::playback_rate::Scaler scaler(&scaling_settings);
+                    scaling_settings.source_playback_rate = data.parent->rack->system->sample_rate;
+                    scaling_settings.channels = 2;
+                    context->scaler.configure(scaling_settings);
 
                     // Scale the playback rate of the contents received from the decoder with the desired settings
-                    // and get the amount of resulting samples
-                    unsigned int scaled_samples_amount = 0;
-                    scaled_samples_amount = scaler.scale(&decoded_data);
-
-                    // Received scaled samples from scaler
-                    std::vector<std::uint8_t> scaled_data(scaled_samples_amount * sizeof(float), 0);
-
-                    // Receive scaled samples from scaler
-                    scaler.receive(&scaled_data);
-
-                    // Get current size of audio queue for processed samples in memory
-                    const std::size_t current_count = data.extra_storage.size();
-
-                    // Allocate memory to accommodate the result of the scaling process into the queue for the final audio buffer
-                    data.extra_storage.resize(current_count + scaled_samples_amount * sizeof(float));
-
-                    // Pass scaled audio data into the queue for the final audio buffer
-                    std::memcpy(current_count + data.extra_storage.data(), scaled_data.data(), scaled_data.size());
+                    // and pass the resulting frames into the queue for the final audio buffer
+                    const unsigned int scaled_frames = context->scaler.scale(context->unscaled_samples.data(), samples_count.samples / 2);
+                    std::memcpy(decoded_samples.begin_write(scaled_frames), context->scaler.data(), scaled_frames * 2 * sizeof(float));
+                    decoded_samples.end_write(scaled_frames);
                 } else {
-                    // Get current size of audio buffer for processed samples in memory
-                    const std::size_t current_count = data.extra_storage.size();
-
-                    // Increase the size the audio buffer for processed samples to accommodate the new about-to-be-received samples
-                    data.extra_storage.resize(current_count + samples_count.samples * sizeof(float));
-
-                    // Receive the samples processed by the decoder and append them to the buffer of already processed samples
-                    decoder->receive(current_count + data.extra_storage.data(), nullptr);
+                    // Nothing to continue from when scaling is requested again
+                    context->scaler.reset();
+
+                    // Receive the samples processed by the decoder and append them to the samples already processed,
+                    // the decoder gives interleaved stereo samples
+                    float *dest = decoded_samples.begin_write((samples_count.samples + 1) / 2);
+                    decoder->receive(reinterpret_cast<std::uint8_t *>(dest), nullptr);
+                    decoded_samples.end_write(samples_count.samples / 2);
                 }
             }
 
-            std::uint32_t bytes_left_in_buffer = data.extra_storage.size();
-            std::uint32_t samples_to_take_per_channel = bytes_left_in_buffer / sizeof(float) / 2;
-
             state->bytes_consumed_since_key_on += params->buffer_params[state->current_buffer].bytes_count;
             state->current_byte_position_in_buffer += params->buffer_params[state->current_buffer].bytes_count;
             state->total_bytes_consumed += params->buffer_params[state->current_buffer].bytes_count;
 
-            state->decoded_gran_pending = samples_to_take_per_channel;
-
             if ((state->current_buffer == -1) || (params->buffer_params[state->current_buffer].bytes_count == 0)) {
                 // If no buffer is found, stop processing
                 finished = true;
@@ -194,20 +168,14 @@ bool Module::process(KernelState &kern, const MemState &mem, const SceUID thread
         }
     }
 
-    std::uint32_t gran_to_be_passed = std::min<std::uint32_t>(state->decoded_gran_pending, data.parent->rack->system->granularity);
-
-    auto const new_size = 2 * sizeof(float) * (state->decoded_gran_passed + data.parent->rack->system->granularity);
-    if (data.extra_storage.size() < new_size) {
-        LOG_TRACE("Resize extra_storage from {} to {}", data.extra_storage.size(), new_size);
-        data.extra_storage.resize(new_size);
-    }
-    std::uint8_t *data_ptr = data.extra_storage.data();
-    data_ptr += 2 * sizeof(float) * state->decoded_gran_passed;
+    const std::uint32_t gran_to_be_passed = std::min(decoded_samples.size(), granularity);
 
-    data.parent->products[0].data = data_ptr;
+    // Pad the last granule of the voice
+    if (decoded_samples.size() < granularity)
+        decoded_samples.write_silence(granularity - decoded_samples.size());
 
-    state->decoded_gran_pending = (state->decoded_gran_pending < state->decoded_gran_passed) ? 0 : (state->decoded_gran_pending - gran_to_be_passed);
-    state->decoded_gran_passed += gran_to_be_passed;
+    data.parent->products[0].data = reinterpret_cast<std::uint8_t *>(decoded_samples.read(granularity));
+    decoded_samples.consume(granularity);
 
     state->samples_generated_since_key_on += gran_to_be_passed * 2;
 
@@ -0,0 +1,79 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <ngs/modules/reverb.h>
+#include <util/log.h>
+
+#include <cmath>
+
+namespace ngs::reverb {
+Module::Module()
+    : ngs::Module(ngs::BussType::BUSS_REVERB) {}
+
+std::size_t Module::get_buffer_parameter_size() const {
+    return default_passthrough_parameter_size;
+}
+
+void Module::on_state_change(ModuleData &data, const VoiceState previous) {
+    if (data.parent->state == VOICE_STATE_AVAILABLE) {
+        data.get_voice_context<VoiceContext>()->reverb.reset();
+    }
+}
+
+static float millibels_to_linear(SceInt32 level) {
+    return std::pow(10.0f, static_cast<float>(level) / 2000.0f);
+}
+
+bool Module::process(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data) {
+    if (data.parent->inputs.inputs.empty()) {
+        return false;
+    }
+
+    float *input = reinterpret_cast<float *>(data.parent->inputs.inputs[0].data());
+    const Parameters *params = data.info.data ? data.get_parameters<Parameters>(mem) : nullptr;
+
+    // Parameters never set by the game pass the input through
+    if (!params || (params->descriptor.size < sizeof(Parameters))) {
+        data.parent->products[0].data = data.parent->inputs.inputs[0].data();
+        return false;
+    }
+
+    dsp::reverb::Settings settings;
+    settings.dry = millibels_to_linear(params->dry);
+    settings.room = millibels_to_linear(params->room);
+    settings.room_hf = millibels_to_linear(params->room_hf);
+    settings.decay_time = params->decay_time;
+    settings.decay_hf_ratio = params->decay_hf_ratio;
+    settings.reflections = millibels_to_linear(params->reflections);
+    settings.reflections_delay = params->reflections_delay;
+    settings.reverb = millibels_to_linear(params->reverb);
+    settings.reverb_delay = params->reverb_delay;
+    settings.diffusion = params->diffusion / 100.0f;
+    settings.density = params->density / 100.0f;
+    settings.hf_reference = params->hf_reference;
+
+    VoiceContext *context = data.get_voice_context<VoiceContext>();
+    const std::uint32_t granularity = data.parent->rack->system->granularity;
+    context->output.resize(granularity * 2);
+
+    context->reverb.configure(settings, static_cast<float>(data.parent->rack->system->sample_rate));
+    context->reverb.process(input, context->output.data(), granularity);
+
+    data.parent->products[0].data = reinterpret_cast<std::uint8_t *>(context->output.data());
+    return false;
+}
+} // namespace ngs::reverb
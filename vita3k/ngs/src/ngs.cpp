@@ -21,7 +21,9 @@
 #include <ngs/definitions/master.h>
 #include <ngs/definitions/passthrough.h>
 #include <ngs/definitions/player.h>
+#include <ngs/definitions/reverb.h>
 #include <ngs/definitions/simple.h>
+#include <ngs/dsp/mix.h>
 #include <ngs/modules/atrac9.h>
 #include <ngs/modules/master.h>
 #include <ngs/modules/passthrough.h>
@@ -80,12 +82,7 @@ std::int32_t VoiceInputManager::receive(ngs::Patch *patch, const VoiceProduct &p
 
     // Try mixing, also with the use of this volume matrix
     // Dest is our voice to receive this data.
-    for (std::int32_t k = 0; k < patch->dest->rack->system->granularity; k++) {
-        dest_buffer[k * 2] = std::clamp(dest_buffer[k * 2] + data_to_mix_in[k * 2] * patch->volume_matrix[0][0]
-                + data_to_mix_in[k * 2 + 1] * patch->volume_matrix[1][0],
-            -1.0f, 1.0f);
-        dest_buffer[k * 2 + 1] = std::clamp(dest_buffer[k * 2 + 1] + data_to_mix_in[k * 2] * patch->volume_matrix[0][1] + data_to_mix_in[k * 2 + 1] * patch->volume_matrix[1][1], -1.0f, 1.0f);
-    }
+    dsp::mix::mix_stereo(dest_buffer, data_to_mix_in, patch->volume_matrix, patch->dest->rack->system->granularity);
 
     return 0;
 }
@@ -132,6 +129,14 @@ void ModuleData::invoke_callback(KernelState &kernel, const MemState &mem, const
         return;
     }
 
+    if (parent->rack->system->voice_scheduler.defer_callback(this, reason1, reason2, reason_ptr))
+        return;
+
+    run_callback(kernel, mem, thread_id, reason1, reason2, reason_ptr);
+}
+
+void ModuleData::run_callback(KernelState &kernel, const MemState &mem, const SceUID thread_id, const std::uint32_t reason1,
+    const std::uint32_t reason2, Address reason_ptr) {
     const ThreadStatePtr thread = lock_and_find(thread_id, kernel.threads, kernel.mutex);
     const Address callback_info_addr = stack_alloc(*thread->cpu, sizeof(CallbackInfo));
 
@@ -148,16 +153,6 @@ void ModuleData::invoke_callback(KernelState &kernel, const MemState &mem, const
     stack_free(*thread->cpu, sizeof(CallbackInfo));
 }
 
-void ModuleData::fill_to_fit_granularity() {
-    const std::size_t start_fill = extra_storage.size();
-    const std::size_t to_fill = parent->rack->system->granularity * 2 * sizeof(float) - start_fill;
-
-    if (to_fill > 0) {
-        extra_storage.resize(start_fill + to_fill);
-        std::fill(extra_storage.begin() + start_fill, extra_storage.end(), 0);
-    }
-}
-
 void Voice::init(Rack *mama) {
     rack = mama;
     state = VoiceState::VOICE_STATE_AVAILABLE;
@@ -217,6 +212,8 @@ Ptr<Patch> Voice::patch(const MemState &mem, const std::int32_t index, std::int3
     patch->volume_matrix[1][0] = 0.0f;
     patch->volume_matrix[1][1] = 1.0f;
 
+    rack->system->voice_scheduler.invalidate_levels();
+
     return patches[index][subindex];
 }
 
@@ -244,6 +241,7 @@ bool Voice::remove_patch(const MemState &mem, const Ptr<Patch> patch) {
     }
 
     patch_info->output_sub_index = -1;
+    rack->system->voice_scheduler.invalidate_levels();
 
     return true;
 }
@@ -380,6 +378,8 @@ Ptr<VoiceDefinition> create_voice_definition(State &ngs, MemState &mem, ngs::Bus
         return ngs.alloc_and_init<ngs::simple::Atrac9VoiceDefinition>(mem);
     case ngs::BussType::BUSS_SIMPLE:
         return ngs.alloc_and_init<ngs::simple::PlayerVoiceDefinition>(mem);
+    case ngs::BussType::BUSS_REVERB:
+        return ngs.alloc_and_init<ngs::reverb::VoiceDefinition>(mem);
 
     default:
         LOG_WARN("Missing voice definition for Buss Type {}, using passthrough.", static_cast<uint32_t>(type));
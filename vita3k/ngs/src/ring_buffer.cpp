@@ -0,0 +1,105 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <ngs/system.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace ngs {
+SampleRingBuffer::SampleRingBuffer(std::uint32_t channels)
+    : channels(channels) {
+}
+
+void SampleRingBuffer::reserve(std::uint32_t capacity, std::uint32_t max_span) {
+    if ((capacity <= ring_frames) && (max_span <= span_frames))
+        return;
+
+    const std::uint32_t new_ring_frames = std::max(capacity, ring_frames);
+    const std::uint32_t new_span_frames = std::max(max_span, span_frames);
+    std::vector<float> new_storage(static_cast<std::size_t>(new_ring_frames + new_span_frames) * channels);
+
+    // Move the pending frames to the start
+    const std::uint32_t first = std::min(count, ring_frames - read_pos);
+    if (count) {
+        std::memcpy(new_storage.data(), storage.data() + read_pos * channels, first * channels * sizeof(float));
+        std::memcpy(new_storage.data() + first * channels, storage.data(), (count - first) * channels * sizeof(float));
+    }
+
+    storage = std::move(new_storage);
+    ring_frames = new_ring_frames;
+    span_frames = new_span_frames;
+    read_pos = 0;
+}
+
+void SampleRingBuffer::clear() {
+    read_pos = 0;
+    count = 0;
+}
+
+float *SampleRingBuffer::begin_write(std::uint32_t frames) {
+    if (!ring_frames || (count + frames > ring_frames) || (frames > span_frames)) {
+        // Grow by doubling so that buffers growing a bit each time don't reallocate every time
+        reserve(std::max({ count + frames, ring_frames * 2, 1U }), frames);
+    }
+
+    const std::uint32_t write_pos = (read_pos + count) % ring_frames;
+    return storage.data() + write_pos * channels;
+}
+
+void SampleRingBuffer::end_write(std::uint32_t frames) {
+    assert(count + frames <= ring_frames);
+    if (!frames)
+        return;
+
+    const std::uint32_t write_pos = (read_pos + count) % ring_frames;
+    if (write_pos + frames > ring_frames) {
+        const std::uint32_t wrapped = write_pos + frames - ring_frames;
+        std::memcpy(storage.data(), storage.data() + ring_frames * channels, wrapped * channels * sizeof(float));
+    }
+
+    count += frames;
+}
+
+void SampleRingBuffer::write_silence(std::uint32_t frames) {
+    float *dest = begin_write(frames);
+    std::fill_n(dest, frames * channels, 0.0f);
+    end_write(frames);
+}
+
+float *SampleRingBuffer::read(std::uint32_t frames) {
+    assert(frames <= count);
+    if (frames > span_frames)
+        reserve(ring_frames, frames);
+
+    if (read_pos + frames > ring_frames) {
+        const std::uint32_t wrapped = read_pos + frames - ring_frames;
+        std::memcpy(storage.data() + ring_frames * channels, storage.data(), wrapped * channels * sizeof(float));
+    }
+
+    return storage.data() + read_pos * channels;
+}
+
+void SampleRingBuffer::consume(std::uint32_t frames) {
+    assert(frames <= count);
+    frames = std::min(frames, count);
+
+    read_pos = (read_pos + frames) % std::max<std::uint32_t>(ring_frames, 1);
+    count -= frames;
+}
+} // namespace ngs
@@ -19,9 +19,157 @@
 #include <ngs/system.h>
 
 #include <algorithm>
+#include <condition_variable>
 #include <cstring>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <unordered_map>
 
 namespace ngs {
+// Levels smaller than this are not worth waking the workers for
+static constexpr std::size_t PARALLEL_MIN_VOICES = 4;
+static constexpr std::size_t MAX_WORKER_COUNT = 4;
+
+// Scheduler whose update is running on this thread, also set on the workers while they process its voices
+static thread_local VoiceScheduler *updating_scheduler = nullptr;
+// Callbacks raised by the voice being processed on this thread
+static thread_local std::vector<VoiceScheduler::DeferredCallback> *voice_callbacks = nullptr;
+
+namespace {
+class WorkerPool {
+public:
+    explicit WorkerPool(std::size_t count) {
+        for (std::size_t i = 0; i < count; i++)
+            threads.emplace_back(&WorkerPool::worker_loop, this);
+    }
+
+    ~WorkerPool() {
+        {
+            const std::lock_guard<std::mutex> guard(mutex);
+            quit = true;
+        }
+        cond.notify_all();
+        for (auto &thread : threads)
+            thread.join();
+    }
+
+    bool empty() const {
+        return threads.empty();
+    }
+
+    // Calls job(i) for every i below count, the calling thread helping the workers, and returns once all calls are done
+    void run(std::size_t count, const std::function<void(std::size_t)> &job) {
+        // A job must never wait on its own batch, should it ever reach another update
+        if (in_job) {
+            for (std::size_t i = 0; i < count; i++)
+                job(i);
+            return;
+        }
+
+        const std::lock_guard<std::mutex> batch_guard(batch_mutex);
+        {
+            const std::lock_guard<std::mutex> guard(mutex);
+            current_job = &job;
+            job_count = count;
+            next_index = 0;
+            generation++;
+        }
+        cond.notify_all();
+
+        work(job, count);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done_cond.wait(lock, [this] { return active_workers == 0; });
+        current_job = nullptr;
+    }
+
+private:
+    void work(const std::function<void(std::size_t)> &job, std::size_t count) {
+        in_job = true;
+        for (std::size_t index = next_index++; index < count; index = next_index++)
+            job(index);
+        in_job = false;
+    }
+
+    void worker_loop() {
+        std::uint64_t seen_generation = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            cond.wait(lock, [&] { return quit || (generation != seen_generation); });
+            if (quit)
+                return;
+
+            seen_generation = generation;
+            // Woken up too late, the batch is already done
+            if (!current_job)
+                continue;
+
+            const std::function<void(std::size_t)> &job = *current_job;
+            const std::size_t count = job_count;
+            active_workers++;
+            lock.unlock();
+            work(job, count);
+            lock.lock();
+            if (--active_workers == 0)
+                done_cond.notify_all();
+        }
+    }
+
+    static thread_local bool in_job;
+
+    std::vector<std::thread> threads;
+    std::mutex batch_mutex;
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::condition_variable done_cond;
+    bool quit = false;
+
+    const std::function<void(std::size_t)> *current_job = nullptr;
+    std::size_t job_count = 0;
+    std::atomic<std::size_t> next_index{ 0 };
+    std::uint64_t generation = 0;
+    std::size_t active_workers = 0;
+};
+
+thread_local bool WorkerPool::in_job = false;
+
+WorkerPool &get_worker_pool() {
+    const std::size_t host_threads = std::thread::hardware_concurrency();
+    static WorkerPool pool(std::min<std::size_t>(host_threads > 1 ? host_threads - 1 : 0, MAX_WORKER_COUNT));
+    return pool;
+}
+
+struct UpdatingScope {
+    VoiceScheduler *previous;
+    std::vector<VoiceScheduler::DeferredCallback> *previous_callbacks;
+
+    UpdatingScope(VoiceScheduler *scheduler, std::vector<VoiceScheduler::DeferredCallback> *callbacks)
+        : previous(updating_scheduler)
+        , previous_callbacks(voice_callbacks) {
+        updating_scheduler = scheduler;
+        voice_callbacks = callbacks;
+    }
+
+    ~UpdatingScope() {
+        updating_scheduler = previous;
+        voice_callbacks = previous_callbacks;
+    }
+};
+} // namespace
+
+bool VoiceScheduler::is_updating() const {
+    return updating_scheduler == this;
+}
+
+bool VoiceScheduler::defer_callback(ModuleData *data, std::uint32_t reason1, std::uint32_t reason2, Address reason_ptr) {
+    if (!is_updating() || !voice_callbacks)
+        return false;
+
+    voice_callbacks->push_back({ data, reason1, reason2, reason_ptr });
+    return true;
+}
+
 bool VoiceScheduler::deque_voice_impl(Voice *voice) {
     auto voice_in = std::find(queue.begin(), queue.end(), voice);
 
@@ -30,20 +178,19 @@ bool VoiceScheduler::deque_voice_impl(Voice *voice) {
     }
 
     queue.erase(voice_in);
+    levels_dirty = true;
     return true;
 }
 
 bool VoiceScheduler::deque_voice(Voice *voice) {
-    if (updater.has_value() && (updater.value() == std::this_thread::get_id())) {
+    if (is_updating()) {
+        const std::lock_guard<std::mutex> guard(pending_lock);
         pending_deque.push_back(voice);
         return true;
     }
 
-    lock.lock();
-    const bool result = deque_voice_impl(voice);
-    lock.unlock();
-
-    return result;
+    const std::lock_guard<std::mutex> guard(lock);
+    return deque_voice_impl(voice);
 }
 
 bool VoiceScheduler::play(const MemState &mem, Voice *voice) {
@@ -52,28 +199,16 @@ bool VoiceScheduler::play(const MemState &mem, Voice *voice) {
         // Transition
         voice->transition(ngs::VOICE_STATE_ACTIVE);
 
-        std::int32_t lowest_dest_pos = static_cast<std::int32_t>(queue.size());
-
-        // Check its dependencies position
-        for (std::uint8_t i = 0; i < voice->patches.size(); i++) {
-            for (const auto &patch : voice->patches[i]) {
-                if (!patch) {
-                    continue;
-                }
-
-                Voice *dest = patch.get(mem)->dest;
-                const std::int32_t pos = get_position(dest);
-
-                if (pos == -1) {
-                    continue;
-                }
-
-                lowest_dest_pos = std::min<std::int32_t>(lowest_dest_pos, pos);
-            }
+        // Dependencies are sorted out when the levels are compiled
+        if (is_updating()) {
+            const std::lock_guard<std::mutex> guard(pending_lock);
+            pending_enqueue.push_back(voice);
+            return true;
         }
 
         const std::lock_guard<std::mutex> guard(lock);
-        queue.insert(queue.begin() + lowest_dest_pos, voice);
+        queue.push_back(voice);
+        levels_dirty = true;
 
         return true;
     } else if (voice->state == ngs::VOICE_STATE_ACTIVE)
@@ -128,116 +263,154 @@ bool VoiceScheduler::off(Voice *voice) {
     return true;
 }
 
-void VoiceScheduler::update(KernelState &kern, const MemState &mem, const SceUID thread_id) {
-    const std::lock_guard<std::mutex> guard(lock);
-    updater = std::this_thread::get_id();
+void VoiceScheduler::compile_levels(const MemState &mem) {
+    levels.clear();
 
-    // Do a first routine to clear inputs from previous update session
-    for (ngs::Voice *voice : queue) {
-        voice->inputs.reset_inputs();
-    }
+    std::unordered_map<Voice *, std::size_t> index_of;
+    for (std::size_t i = 0; i < queue.size(); i++)
+        index_of.emplace(queue[i], i);
 
-    for (ngs::Voice *voice : queue) {
-        // Modify the state, in peace....
-        const std::lock_guard<std::mutex> guard(*voice->voice_lock);
-        std::memset(voice->products, 0, sizeof(voice->products));
-
-        const bool is_key_off = voice->state == ngs::VOICE_STATE_KEY_OFF;
-        bool finished = false;
-        for (std::size_t i = 0; i < voice->rack->modules.size(); i++) {
-            if (voice->rack->modules[i]) {
-                finished |= voice->rack->modules[i]->process(kern, mem, thread_id, voice->datas[i]);
+    // Kahn's algorithm, a voice gets a level once every active voice patched into it has one
+    std::vector<std::uint32_t> pending_sources(queue.size(), 0);
+    std::vector<std::vector<std::size_t>> dests(queue.size());
+    for (std::size_t i = 0; i < queue.size(); i++) {
+        for (const auto &port : queue[i]->patches) {
+            for (const auto &patch : port) {
+                if (!patch || patch.get(mem)->output_sub_index == -1)
+                    continue;
+
+                const auto dest = index_of.find(patch.get(mem)->dest);
+                if (dest == index_of.end())
+                    continue;
+
+                dests[i].push_back(dest->second);
+                pending_sources[dest->second]++;
             }
         }
-        if (is_key_off || finished)
-            stop(voice);
+    }
+
+    std::vector<std::size_t> current;
+    for (std::size_t i = 0; i < queue.size(); i++) {
+        if (!pending_sources[i])
+            current.push_back(i);
+    }
 
-        for (std::size_t i = 0; i < voice->rack->vdef->output_count(); i++) {
-            if (voice->products[i].data)
-                deliver_data(mem, voice, static_cast<std::uint8_t>(i), voice->products[i]);
+    while (!current.empty()) {
+        std::vector<std::size_t> next;
+        levels.emplace_back();
+        for (const std::size_t i : current) {
+            levels.back().push_back(queue[i]);
+            for (const std::size_t dest : dests[i]) {
+                if (--pending_sources[dest] == 0)
+                    next.push_back(dest);
+            }
         }
 
-        voice->frame_count++;
+        // Play order inside a level
+        std::sort(next.begin(), next.end());
+        current = std::move(next);
     }
 
-    for (ngs::Voice *nominee : pending_deque) {
-        deque_voice_impl(nominee);
+    // Voices patched in a loop still get processed, one level each
+    for (std::size_t i = 0; i < queue.size(); i++) {
+        if (pending_sources[i])
+            levels.push_back({ queue[i] });
     }
 
-    pending_deque.clear();
-    updater.reset();
+    levels_dirty = false;
 }
 
-std::int32_t VoiceScheduler::get_position(Voice *v) {
-    const std::lock_guard<std::mutex> guard(lock);
-    auto result = std::find(queue.begin(), queue.end(), v);
+bool VoiceScheduler::process_voice(KernelState &kern, const MemState &mem, const SceUID thread_id, Voice *voice) {
+    // Modify the state, in peace....
+    const std::lock_guard<std::mutex> guard(*voice->voice_lock);
+    std::memset(voice->products, 0, sizeof(voice->products));
 
-    if (result != queue.end()) {
-        return static_cast<std::int32_t>(std::distance(queue.begin(), result));
+    const bool is_key_off = voice->state == ngs::VOICE_STATE_KEY_OFF;
+    bool finished = false;
+    for (std::size_t i = 0; i < voice->rack->modules.size(); i++) {
+        if (voice->rack->modules[i]) {
+            finished |= voice->rack->modules[i]->process(kern, mem, thread_id, voice->datas[i]);
+        }
     }
 
-    return -1;
+    return is_key_off || finished;
 }
 
-bool VoiceScheduler::resort_to_respect_dependencies(const MemState &mem, Voice *source) {
-    // Get my position
-    std::int32_t position = get_position(source);
+void VoiceScheduler::update(KernelState &kern, const MemState &mem, const SceUID thread_id) {
+    const std::lock_guard<std::mutex> guard(lock);
+    const UpdatingScope updating(this, nullptr);
+
+    if (levels_dirty)
+        compile_levels(mem);
 
-    if (position == -1) {
-        return false;
+    // Do a first routine to clear inputs from previous update session
+    for (ngs::Voice *voice : queue) {
+        voice->inputs.reset_inputs();
     }
 
-    // Check all dependencies, could be optimized- @sunho suggested dfs topological sort
-    for (size_t i = 0; i < source->patches.size(); i++) {
-        for (const auto &patch : source->patches[i]) {
-            if (!patch) {
-                continue;
-            }
+    WorkerPool &pool = get_worker_pool();
+    for (const auto &level : levels) {
+        finished.assign(level.size(), 0);
+        deferred_callbacks.resize(level.size());
+
+        const std::function<void(std::size_t)> process = [&](std::size_t i) {
+            const UpdatingScope worker_updating(this, &deferred_callbacks[i]);
+            finished[i] = process_voice(kern, mem, thread_id, level[i]);
+        };
+        if ((level.size() >= PARALLEL_MIN_VOICES) && !pool.empty())
+            pool.run(level.size(), process);
+        else {
+            for (std::size_t i = 0; i < level.size(); i++)
+                process(i);
+        }
 
-            Voice *dest = patch.get(mem)->dest;
-            const std::int32_t dest_pos = get_position(dest);
+        // The workers can't run guest code, and the voices are unlocked by now
+        for (std::size_t i = 0; i < level.size(); i++) {
+            for (const DeferredCallback &callback : deferred_callbacks[i])
+                callback.data->run_callback(kern, mem, thread_id, callback.reason1, callback.reason2, callback.reason_ptr);
+            deferred_callbacks[i].clear();
+        }
 
-            if (position == -1) {
-                // Maybe not scheduled yet. Continue
-                continue;
+        // Deliver in level order so that mixing into shared inputs doesn't depend on which voice finished first
+        for (std::size_t i = 0; i < level.size(); i++) {
+            ngs::Voice *voice = level[i];
+            if (finished[i])
+                stop(voice);
+
+            for (std::size_t j = 0; j < voice->rack->vdef->output_count(); j++) {
+                if (voice->products[j].data)
+                    deliver_data(mem, voice, static_cast<std::uint8_t>(j), voice->products[j]);
             }
 
-            if (dest_pos < position) {
-                // Switch to the end. Resort dependencies for this one that just got sorted too.
-                {
-                    const std::lock_guard<std::mutex> guard(lock);
-                    std::rotate(queue.begin() + dest_pos, queue.begin() + dest_pos + 1, queue.end());
-                }
+            voice->frame_count++;
+        }
+    }
 
-                resort_to_respect_dependencies(mem, dest);
-                position = get_position(source);
-            }
+    const std::lock_guard<std::mutex> pending_guard(pending_lock);
+    for (ngs::Voice *nominee : pending_deque) {
+        deque_voice_impl(nominee);
+    }
+    for (ngs::Voice *nominee : pending_enqueue) {
+        if (std::find(queue.begin(), queue.end(), nominee) == queue.end()) {
+            queue.push_back(nominee);
+            levels_dirty = true;
         }
     }
 
-    return true;
+    pending_deque.clear();
+    pending_enqueue.clear();
 }
 
 Ptr<Patch> VoiceScheduler::patch(const MemState &mem, PatchSetupInfo *info) {
-    // First, check if these two voices are scheduled yet
     Voice *source = info->source.get(mem);
     Voice *dest = info->dest.get(mem);
 
     Ptr<Patch> patch = source->patch(mem, info->source_output_index, info->source_output_subindex, info->dest_input_index, dest);
 
-    if (!patch) {
-        return patch;
-    }
-
-    const std::int32_t source_pos = get_position(source);
-    const std::int32_t dest_pos = get_position(dest);
-
-    if (source_pos == -1 || dest_pos == -1) {
-        // Later
-        return patch;
+    if (patch) {
+        invalidate_levels();
     }
 
-    resort_to_respect_dependencies(mem, source);
     return patch;
 }
 } // namespace ngs
@@ -0,0 +1,86 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <ngs/dsp/mix.h>
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+using namespace ngs::dsp;
+
+// Sizes not multiple of any vector width, so the tails get tested too
+static constexpr std::uint32_t TEST_SIZES[] = { 0, 1, 3, 7, 64, 255, 1021 };
+
+static std::vector<float> random_samples(std::mt19937 &rng, std::size_t count, float range) {
+    std::uniform_real_distribution<float> distribution(-range, range);
+    std::vector<float> samples(count);
+    for (float &sample : samples)
+        sample = distribution(rng);
+    return samples;
+}
+
+TEST(ngs_mix, mix_stereo_matches_reference) {
+    std::mt19937 rng(42);
+    const mix::VolumeMatrix matrices[] = {
+        { { 1.0f, 0.0f }, { 0.0f, 1.0f } },
+        { { 0.5f, 0.25f }, { -0.75f, 2.0f } },
+        { { 0.0f, 1.0f }, { 1.0f, 0.0f } },
+    };
+
+    for (const auto &matrix : matrices) {
+        for (const std::uint32_t frames : TEST_SIZES) {
+            const std::vector<float> source = random_samples(rng, frames * 2, 1.5f);
+            std::vector<float> dest = random_samples(rng, frames * 2, 1.0f);
+            std::vector<float> expected = dest;
+
+            mix::mix_stereo(dest.data(), source.data(), matrix, frames);
+            mix::reference::mix_stereo(expected.data(), source.data(), matrix, frames);
+
+            for (std::size_t i = 0; i < dest.size(); i++) {
+                ASSERT_NEAR(dest[i], expected[i], 1e-6f) << mix::kernels_name() << ", " << frames << " frames, sample " << i;
+                ASSERT_LE(std::abs(dest[i]), 1.0f);
+            }
+        }
+    }
+}
+
+TEST(ngs_mix, float_to_s16_matches_reference) {
+    std::mt19937 rng(1337);
+    for (const std::uint32_t samples : TEST_SIZES) {
+        // Out of range samples check the saturation
+        const std::vector<float> source = random_samples(rng, samples, 1.25f);
+        std::vector<std::int16_t> dest(samples);
+        std::vector<std::int16_t> expected(samples);
+
+        mix::float_to_s16(source.data(), dest.data(), samples);
+        mix::reference::float_to_s16(source.data(), expected.data(), samples);
+
+        EXPECT_EQ(dest, expected) << mix::kernels_name() << ", " << samples << " samples";
+    }
+}
+
+TEST(ngs_mix, float_to_s16_limits) {
+    const float source[] = { -2.0f, -1.0f, -0.5f, 0.0f, 0.5f, 0.999f, 1.0f, 2.0f, 0.25f, -0.25f, 1e9f, -1e9f, 0.0f, 0.0f, 0.0f, 0.0f };
+    const std::int16_t expected[] = { -32768, -32768, -16384, 0, 16384, 32735, 32767, 32767, 8192, -8192, 32767, -32768, 0, 0, 0, 0 };
+    std::int16_t dest[16];
+
+    mix::float_to_s16(source, dest, 16);
+    for (int i = 0; i < 16; i++)
+        EXPECT_EQ(dest[i], expected[i]) << "sample " << i;
+}
@@ -0,0 +1,99 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <ngs/system.h>
+
+#include <gtest/gtest.h>
+
+// Every frame holds its index on both channels, so a read tells which frames it got
+static void write_frames(ngs::SampleRingBuffer &ring, std::uint32_t first, std::uint32_t frames) {
+    float *dest = ring.begin_write(frames);
+    for (std::uint32_t i = 0; i < frames; i++) {
+        dest[i * 2] = static_cast<float>(first + i);
+        dest[i * 2 + 1] = -static_cast<float>(first + i);
+    }
+    ring.end_write(frames);
+}
+
+static void expect_frames(const float *span, std::uint32_t first, std::uint32_t frames) {
+    for (std::uint32_t i = 0; i < frames; i++) {
+        ASSERT_EQ(span[i * 2], static_cast<float>(first + i)) << "frame " << i;
+        ASSERT_EQ(span[i * 2 + 1], -static_cast<float>(first + i)) << "frame " << i;
+    }
+}
+
+// Superframe sized writes read back a granule at a time, the way the decoding modules use it
+static void run_granules(std::uint32_t granularity, std::uint32_t superframe) {
+    ngs::SampleRingBuffer ring;
+    std::uint32_t written = 0;
+    std::uint32_t read = 0;
+    std::uint32_t capacity = 0;
+
+    for (int update = 0; update < 1000; update++) {
+        while (ring.size() < granularity) {
+            write_frames(ring, written, superframe);
+            written += superframe;
+        }
+
+        expect_frames(ring.read(granularity), read, granularity);
+        ring.consume(granularity);
+        read += granularity;
+
+        // The storage settles after the first updates
+        if (update == 500)
+            capacity = ring.capacity();
+    }
+
+    EXPECT_EQ(ring.size(), written - read);
+    EXPECT_EQ(ring.capacity(), capacity);
+}
+
+TEST(sample_ring_buffer, wraps_with_odd_granularity) {
+    run_granules(333, 256);
+}
+
+TEST(sample_ring_buffer, wraps_with_granularity_above_superframe) {
+    run_granules(1021, 128);
+}
+
+TEST(sample_ring_buffer, wraps_with_granularity_below_superframe) {
+    run_granules(77, 1024);
+}
+
+TEST(sample_ring_buffer, grows_keeping_pending_frames) {
+    ngs::SampleRingBuffer ring;
+    write_frames(ring, 0, 100);
+    ring.consume(60);
+
+    // Pending frames end up wrapped around before the write that needs more room
+    write_frames(ring, 100, 50);
+    write_frames(ring, 150, 1000);
+
+    ASSERT_EQ(ring.size(), 1090);
+    expect_frames(ring.read(1090), 60, 1090);
+}
+
+TEST(sample_ring_buffer, silence) {
+    ngs::SampleRingBuffer ring;
+    write_frames(ring, 0, 10);
+    ring.write_silence(7);
+
+    const float *span = ring.read(17);
+    expect_frames(span, 0, 10);
+    for (std::uint32_t i = 20; i < 34; i++)
+        EXPECT_EQ(span[i], 0.0f);
+}
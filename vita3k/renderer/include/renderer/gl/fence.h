@@ -33,6 +33,12 @@ public:
     void insert();
     bool wait_for_signal();
 
+    // Check if the GPU has already passed the fence, without blocking
+    bool poll();
+
+    // Forget the fence without waiting for it
+    void reset();
+
     bool empty() const {
         return !sync_;
     }
@@ -47,10 +47,11 @@ std::string pre_load_glsl_shader(const char *hash_text, const char *shader_type_
 
 // Uniforms.
 bool set_uniform_buffer(GLContext &context, MemState &mem, const bool vertex_shader, const int block_num, const int size, const void *data, bool log_active_shader);
+void bind_uniform_storages(GLContext &context, const MemState &mem);
 
 bool create(SDL_Window *window, std::unique_ptr<renderer::State> &state, const char *base_path, const bool hashless_texture_cache);
 bool create(std::unique_ptr<Context> &context);
-bool create(std::unique_ptr<RenderTarget> &rt, const SceGxmRenderTargetParams &params, const FeatureState &features);
+bool create(std::unique_ptr<RenderTarget> &rt, const SceGxmRenderTargetParams &params, const FeatureState &features, const int res_multiplier);
 bool create(std::unique_ptr<FragmentProgram> &fp, GLState &state, const SceGxmProgram &program, const SceGxmBlendInfo *blend, GXPPtrMap &gxp_ptr_map, const char *base_path, const char *title_id);
 bool create(std::unique_ptr<VertexProgram> &vp, GLState &state, const SceGxmProgram &program, GXPPtrMap &gxp_ptr_map, const char *base_path, const char *title_id);
 void sync_rendertarget(const GLRenderTarget &rt);
@@ -83,6 +84,7 @@ void bind_fundamental(GLContext &context);
 void clear_previous_uniform_storage(GLContext &context);
 
 struct GLTextureCacheState;
+class YUVConverter;
 struct TextureCacheState;
 
 // Attribute formats.
@@ -95,7 +97,7 @@ namespace texture {
 // Textures.
 void bind_texture(GLTextureCacheState &cache, const SceGxmTexture &gxm_texture, const MemState &mem);
 void configure_bound_texture(const SceGxmTexture &gxm_texture);
-void upload_bound_texture(const SceGxmTexture &gxm_texture, const MemState &mem);
+void upload_bound_texture(const SceGxmTexture &gxm_texture, const MemState &mem, YUVConverter &yuv_converter);
 
 // Texture formats.
 const GLint *translate_swizzle(SceGxmTextureFormat fmt);
@@ -17,41 +17,80 @@
 
 #pragma once
 
+#include <array>
 #include <cstdint>
-#include <glutil/object_array.h>
+#include <glutil/gl.h>
 #include <renderer/gl/fence.h>
 #include <tuple>
 
 namespace renderer::gl {
 
+struct RingBufferStats {
+    std::uint32_t stall_count = 0;
+    std::uint64_t stall_time_us = 0;
+    std::uint32_t grow_count = 0;
+};
+
 struct RingBuffer {
 private:
-    GLObjectArray<1> buffer_;
-    Fence safe_segment_consumed_fence_;
+    // The buffer is divided into equal segments, each protected by its own fence. The fence of a segment is
+    // inserted once the cursor has left it, and waited on when the cursor comes back to it.
+    static constexpr std::size_t SEGMENT_COUNT = 8;
+
+    GLuint buffer_;
+    std::array<Fence, SEGMENT_COUNT> segment_fences_;
+    std::array<bool, SEGMENT_COUNT> segment_pending_fence_;
 
     std::uint8_t *base_;
     std::size_t cursor_;
     std::size_t capacity_;
+    std::size_t max_capacity_;
+    std::size_t current_segment_;
 
     GLenum purpose_;
 
+    bool grow_requested_;
+
+    RingBufferStats frame_stats_;
+    RingBufferStats last_frame_stats_;
+
     void create_and_map();
+    void unmap_and_destroy();
+
+    std::size_t segment_size() const {
+        return capacity_ / SEGMENT_COUNT;
+    }
+
+    // Make sure the GPU no longer reads from the segment before the cursor enters it.
+    void acquire_segment(const std::size_t segment);
 
 public:
-    explicit RingBuffer(GLenum purpose, const std::size_t capacity);
+    explicit RingBuffer(GLenum purpose, const std::size_t capacity, const std::size_t max_capacity = 0);
     ~RingBuffer();
 
     // Allocate new data from ring buffer, return offset of the data resided in the buffer
-    // In case the data is full, it will wait for fence to notify previous draw commands has finished on previous buffer part
-    // and then reset the cursor
+    // In case the segment the data lands in is still in use by the GPU, it will wait for the fence of that segment
+    // to be signaled. Waits are recorded in stats and make the buffer grow on the next draw_call_done.
     std::pair<std::uint8_t *, std::size_t> allocate(const std::size_t data_size);
 
-    // Notify the buffer that a draw call is done. This inserts a fence depends on the amount of data that has been consumed
-    // previously by push
-    void draw_call_done();
+    // Notify the buffer that a draw call is done. This inserts fences for segments that the cursor has left since
+    // the previous draw, and grows the buffer if stalls have been observed.
+    // Returns true if the buffer has been recreated, in which case the handle changed and previous bindings are invalid.
+    bool draw_call_done();
+
+    // Save the stats of the current frame and start over
+    void end_frame();
+
+    const RingBufferStats &last_frame_stats() const {
+        return last_frame_stats_;
+    }
+
+    std::size_t capacity() const {
+        return capacity_;
+    }
 
     GLint handle() const {
-        return buffer_[0];
+        return buffer_;
     }
 };
 
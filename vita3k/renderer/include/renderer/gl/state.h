@@ -48,6 +48,9 @@ struct GLState : public renderer::State {
 
     ScreenRenderer screen_renderer;
 
+    // Number of frames presented so far
+    std::uint64_t frame_index = 0;
+
     bool init(const char *base_path, const bool hashless_texture_cache) override;
     void render_frame(const SceFVector2 &viewport_pos, const SceFVector2 &viewport_size, const DisplayState &display,
         const MemState &mem) override;
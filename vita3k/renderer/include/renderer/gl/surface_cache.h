@@ -20,9 +20,10 @@
 #include <glutil/object_array.h>
 #include <renderer/surface_cache.h>
 
-#include <array>
+#include <map>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 #include <glad/glad.h>
 
@@ -38,6 +39,28 @@ struct GLSurfaceCacheInfo {
     };
 
     std::uint32_t flags = FLAG_FREE;
+
+    // Links in the least recently used list of the surface container
+    GLSurfaceCacheInfo *lru_prev = nullptr;
+    GLSurfaceCacheInfo *lru_next = nullptr;
+
+    // Keys of the framebuffers this surface is attached to
+    std::vector<std::uint64_t> framebuffer_keys;
+};
+
+// Intrusive list of cached surfaces, ordered from the least to the most recently used
+struct GLSurfaceLRUList {
+    GLSurfaceCacheInfo *head = nullptr;
+    GLSurfaceCacheInfo *tail = nullptr;
+    std::size_t size = 0;
+
+    void remove(GLSurfaceCacheInfo &info);
+    void push_back(GLSurfaceCacheInfo &info);
+
+    void touch(GLSurfaceCacheInfo &info) {
+        remove(info);
+        push_back(info);
+    }
 };
 
 struct GLCastedTexture {
@@ -63,6 +86,10 @@ struct GLColorSurfaceCacheInfo : public GLSurfaceCacheInfo {
     GLObjectArray<1> gl_ping_pong_texture;
     GLObjectArray<1> gl_expected_read_texture_view;
 
+    // Copy at native resolution, used for sampling and readback when rendering at a higher one
+    GLObjectArray<1> gl_downscaled_texture;
+    bool downscale_outdated = true;
+
     std::vector<std::unique_ptr<GLCastedTexture>> casted_textures;
 };
 
@@ -71,28 +98,58 @@ struct GLDepthStencilSurfaceCacheInfo : public GLSurfaceCacheInfo {
     GLObjectArray<1> gl_texture;
 };
 
+struct GLFramebufferCacheInfo {
+    GLObjectArray<1> framebuffer;
+
+    // Cached surfaces attached, null when the render target's own attachment is used
+    GLSurfaceCacheInfo *color = nullptr;
+    GLSurfaceCacheInfo *depth_stencil = nullptr;
+};
+
+using GLColorSurfaceMap = std::map<std::uint64_t, std::unique_ptr<GLColorSurfaceCacheInfo>, std::greater<std::uint64_t>>;
+
 class GLSurfaceCache : public SurfaceCache {
 private:
     static constexpr std::uint32_t MAX_CACHE_SIZE_PER_CONTAINER = 20;
 
-    std::map<std::uint64_t, std::unique_ptr<GLColorSurfaceCacheInfo>, std::greater<std::uint64_t>> color_surface_textures;
-    std::array<GLDepthStencilSurfaceCacheInfo, MAX_CACHE_SIZE_PER_CONTAINER> depth_stencil_textures;
-    std::unordered_map<std::uint64_t, GLObjectArray<1>> framebuffer_array;
+    // Keyed by guest address, in descending order so that lower_bound gives the closest surface starting at or below an address
+    GLColorSurfaceMap color_surface_textures;
+    std::map<std::uint64_t, std::unique_ptr<GLDepthStencilSurfaceCacheInfo>> depth_stencil_textures;
+    std::unordered_map<std::uint64_t, GLFramebufferCacheInfo> framebuffer_array;
 
-    std::vector<std::uint64_t> last_use_color_surface_index;
-    std::vector<std::size_t> last_use_depth_stencil_surface_index;
+    // Size of the biggest color surface cached, bounds how far below an address a surface containing it can start
+    std::size_t max_color_surface_size = 0;
+
+    GLSurfaceLRUList color_surface_lru;
+    GLSurfaceLRUList depth_stencil_surface_lru;
 
     GLObjectArray<1> typeless_copy_buffer;
     std::size_t typeless_copy_buffer_size = 0;
 
+    // Read and draw framebuffers used to blit surfaces down to native resolution
+    GLObjectArray<2> downscale_framebuffers;
+
+    // Color surface of the current scene, its content may change until another one is written to
+    GLColorSurfaceCacheInfo *last_written_color_surface = nullptr;
+
     const GLRenderTarget *target = nullptr;
 
 private:
+    GLColorSurfaceMap::iterator lookup_color_surface(const std::uint64_t address);
+    void free_color_surface(GLColorSurfaceMap::iterator ite);
+    void update_max_color_surface_size();
+    void free_framebuffers(GLSurfaceCacheInfo &info);
+    void mark_color_surface_written(GLColorSurfaceCacheInfo &info);
+    GLuint downscale_color_surface(GLColorSurfaceCacheInfo &info);
+
     void do_typeless_copy(const GLint dest_texture, const GLint source_texture, const GLenum dest_internal,
         const GLenum dest_upload_format, const GLenum dest_type, const GLenum source_format, const GLenum source_type,
         const int offset_x, const int offset_y, const int width, const int height, const int dest_width, const int dest_height, const std::size_t total_source_size);
 
 public:
+    // Surfaces are stored this many times larger than their native size
+    int res_multiplier = 1;
+
     explicit GLSurfaceCache();
 
     std::uint64_t retrieve_color_surface_texture_handle(const std::uint16_t width, const std::uint16_t height, const std::uint16_t pixel_stride,
@@ -106,6 +163,9 @@ public:
         std::uint64_t *color_texture_handle = nullptr, std::uint64_t *ds_texture_handle = nullptr,
         std::uint16_t *stored_height = nullptr) override;
 
+    // Bind the color surface at the given address, downscaled to native resolution, as the read framebuffer
+    bool bind_native_color_surface_for_reading(Ptr<void> address);
+
     void set_render_target(const GLRenderTarget *new_target) {
         target = new_target;
     }
@@ -23,6 +23,7 @@
 #include <renderer/types.h>
 
 #include <renderer/gl/ring_buffer.h>
+#include <renderer/gl/yuv_converter.h>
 #include <renderer/texture_cache_state.h>
 #include <shader/usse_program_analyzer.h>
 
@@ -61,6 +62,7 @@ struct UniformSetRequest {
 
 struct GLTextureCacheState : public renderer::TextureCacheState {
     GLObjectArray<TextureCacheSize> textures;
+    YUVConverter yuv_converter;
 };
 
 struct GLRenderTarget;
@@ -77,6 +79,19 @@ struct GXMRenderFragUniformBlock {
     float front_disabled = 0;
     float writing_mask = 0;
     float use_raw_image = 0;
+    float res_multiplier = 1;
+};
+
+// Uniform buffers of one shader stage, laid out in a single region of a persistent mapped ring buffer
+struct GLUniformStorage {
+    std::pair<std::uint8_t *, std::size_t> ptr{ nullptr, 0 };
+    std::size_t size = 0;
+
+    // Copy of the region content, a new region starts from it when only some of the blocks change
+    std::vector<std::uint8_t> shadow;
+
+    // Set once a new region has been started for the current draw
+    bool writable = false;
 };
 
 struct GLContext : public renderer::Context {
@@ -89,6 +104,10 @@ struct GLContext : public renderer::Context {
     RingBuffer vertex_info_uniform_buffer;
     RingBuffer fragment_info_uniform_buffer;
 
+    // Ring buffer stalls of the last complete frame, summed over all ring buffers
+    RingBufferStats last_frame_ring_buffer_stats;
+    std::uint64_t ring_buffer_frame_index = 0;
+
     GXMRenderVertUniformBlock previous_vert_info;
     GXMRenderFragUniformBlock previous_frag_info;
 
@@ -102,6 +121,9 @@ struct GLContext : public renderer::Context {
     GLuint current_color_attachment{ 0 };
     GLuint current_framebuffer_height{ 0 };
 
+    // Scale from native surface coordinates to the ones of the bound framebuffer
+    int res_multiplier = 1;
+
     std::vector<GLuint> self_sampling_indices;
 
     float viewport_flip[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
@@ -109,8 +131,8 @@ struct GLContext : public renderer::Context {
     std::vector<UniformSetRequest> vertex_set_requests;
     std::vector<UniformSetRequest> fragment_set_requests;
 
-    std::pair<std::uint8_t *, std::size_t> vertex_uniform_buffer_storage_ptr{ nullptr, 0 };
-    std::pair<std::uint8_t *, std::size_t> fragment_uniform_buffer_storage_ptr{ nullptr, 0 };
+    GLUniformStorage vertex_uniform_storage;
+    GLUniformStorage fragment_uniform_storage;
 
     explicit GLContext();
     ~GLContext() override = default;
@@ -144,8 +166,10 @@ struct GLVertexProgram : public renderer::VertexProgram {
 };
 
 struct GLRenderTarget : public renderer::RenderTarget {
+    // Native size, the attachments are res_multiplier times larger
     uint16_t width;
     uint16_t height;
+    int res_multiplier = 1;
     GLObjectArray<1> maskbuffer;
     GLObjectArray<1> masktexture;
     GLObjectArray<2> attachments;
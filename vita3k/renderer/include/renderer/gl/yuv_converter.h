@@ -0,0 +1,63 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <glutil/object.h>
+#include <glutil/object_array.h>
+#include <renderer/types.h>
+
+#include <string>
+
+namespace renderer::gl {
+
+// Converts YUV420 frames to RGB on the GPU. The planes are uploaded as they are and a shader does the conversion,
+// so no CPU side colour conversion is needed, whether the frame comes from a guest texture or a video decoder.
+class YUVConverter {
+public:
+    bool init(const std::string &base_path);
+
+    // Render the frame into a level of a RGBA texture of the same size. The GL state is left untouched.
+    void convert(const YUV420Frame &frame, const GLuint dest_texture, const GLint dest_level);
+
+private:
+    enum {
+        PLANE_Y,
+        PLANE_U,
+        PLANE_V,
+        PLANE_COUNT
+    };
+
+    void upload_planes(const YUV420Frame &frame);
+
+    SharedGLObject program;
+    GLObjectArray<1> vertex_array;
+    GLObjectArray<1> framebuffer;
+    GLObjectArray<PLANE_COUNT> plane_textures;
+
+    // Plane storage is only respecified when the frame layout changes
+    std::uint32_t planes_width = 0;
+    std::uint32_t planes_height = 0;
+    bool planes_chroma_interleaved = false;
+
+    GLint chroma_interleaved_location = -1;
+    GLint chroma_swapped_location = -1;
+    GLint csc_matrix_location = -1;
+    GLint frame_size_location = -1;
+};
+
+} // namespace renderer::gl
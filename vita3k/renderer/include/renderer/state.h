@@ -46,6 +46,9 @@ struct State {
     std::atomic<std::uint32_t> average_scene_per_frame = 1;
     std::uint32_t scene_processed_since_last_frame = 0;
 
+    // Internal rendering resolution of surfaces, as a multiple of the native resolution
+    int res_multiplier = 1;
+
     virtual bool init(const char *base_path, const bool hashless_texture_cache) = 0;
     virtual void render_frame(const SceFVector2 &viewport_pos, const SceFVector2 &viewport_size, const DisplayState &display,
         const MemState &mem)
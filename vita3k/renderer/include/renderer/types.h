@@ -32,6 +32,7 @@
 
 static constexpr auto DEFAULT_RES_WIDTH = 960;
 static constexpr auto DEFAULT_RES_HEIGHT = 544;
+static constexpr auto MAX_RES_MULTIPLIER = 4;
 
 struct SceGxmProgram;
 struct SDL_Window;
@@ -168,4 +169,20 @@ struct RenderTarget {
     virtual ~RenderTarget() = default;
 };
 
+enum class YUVColorSpace {
+    BT601,
+    BT709
+};
+
+// Planar 4:2:0 frame, either with separate U and V planes or with a single interleaved chroma plane (NV12)
+struct YUV420Frame {
+    std::uint32_t width = 0;
+    std::uint32_t height = 0;
+    const std::uint8_t *planes[3] = {};
+    std::uint32_t strides[3] = {}; // In bytes
+    bool chroma_interleaved = false;
+    bool chroma_swapped = false; // V comes before U
+    YUVColorSpace color_space = YUVColorSpace::BT601;
+};
+
 } // namespace renderer
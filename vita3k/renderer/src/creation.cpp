@@ -34,6 +34,8 @@
 #include <util/log.h>
 #include <util/string_utils.h>
 
+#include <algorithm>
+
 namespace renderer {
 COMMAND(handle_create_context) {
     std::unique_ptr<Context> *ctx = helper.pop<std::unique_ptr<Context> *>();
@@ -62,7 +64,7 @@ COMMAND(handle_create_render_target) {
 
     switch (renderer.current_backend) {
     case Backend::OpenGL: {
-        result = gl::create(*render_target, *params, features);
+        result = gl::create(*render_target, *params, features, renderer.res_multiplier);
         break;
     }
 
@@ -120,6 +122,11 @@ bool init(SDL_Window *window, std::unique_ptr<State> &state, Backend backend, co
     switch (backend) {
     case Backend::OpenGL:
         state = std::make_unique<gl::GLState>();
+        state->res_multiplier = std::clamp(config.resolution_multiplier, 1, MAX_RES_MULTIPLIER);
+        if (config.resolution_multiplier != state->res_multiplier) {
+            LOG_WARN("Resolution multiplier {} is out of range, using {} instead", config.resolution_multiplier, state->res_multiplier);
+        }
+
         if (!gl::create(window, state, base_path, config.hashless_taexture_cache))
             return false;
         break;
@@ -58,6 +58,51 @@ static GLenum translate_primitive(SceGxmPrimitiveType primType) {
     return GL_TRIANGLES;
 }
 
+static void ring_buffers_draw_call_done(GLState &renderer, GLContext &context) {
+    RingBuffer *ring_buffers[] = {
+        &context.vertex_stream_ring_buffer,
+        &context.index_stream_ring_buffer,
+        &context.vertex_uniform_stream_ring_buffer,
+        &context.fragment_uniform_stream_ring_buffer,
+        &context.vertex_info_uniform_buffer,
+        &context.fragment_info_uniform_buffer
+    };
+
+    if (context.ring_buffer_frame_index != renderer.frame_index) {
+        RingBufferStats total;
+        for (RingBuffer *ring_buffer : ring_buffers) {
+            ring_buffer->end_frame();
+
+            const RingBufferStats &stats = ring_buffer->last_frame_stats();
+            total.stall_count += stats.stall_count;
+            total.stall_time_us += stats.stall_time_us;
+            total.grow_count += stats.grow_count;
+        }
+
+        LOG_DEBUG_IF(total.stall_count, "Ring buffers stalled {} times ({} us) waiting for the GPU last frame", total.stall_count, total.stall_time_us);
+
+        context.last_frame_ring_buffer_stats = total;
+        context.ring_buffer_frame_index = renderer.frame_index;
+    }
+
+    for (RingBuffer *ring_buffer : ring_buffers) {
+        if (!ring_buffer->draw_call_done()) {
+            continue;
+        }
+
+        // The buffer has been recreated, make sure the info blocks and uniforms are uploaded again on next draw
+        if (ring_buffer == &context.vertex_info_uniform_buffer) {
+            std::memset(&context.previous_vert_info, 0, sizeof(GXMRenderVertUniformBlock));
+        } else if (ring_buffer == &context.fragment_info_uniform_buffer) {
+            std::memset(&context.previous_frag_info, 0, sizeof(GXMRenderFragUniformBlock));
+        } else if (ring_buffer == &context.vertex_uniform_stream_ring_buffer) {
+            context.vertex_uniform_storage.ptr = { nullptr, 0 };
+        } else if (ring_buffer == &context.fragment_uniform_stream_ring_buffer) {
+            context.fragment_uniform_storage.ptr = { nullptr, 0 };
+        }
+    }
+}
+
 void draw(GLState &renderer, GLContext &context, const FeatureState &features, SceGxmPrimitiveType type, SceGxmIndexFormat format, void *indices, size_t count, uint32_t instance_count,
     MemState &mem, const char *base_path, const char *title_id, const Config &config) {
     R_PROFILE(__func__);
@@ -149,6 +194,7 @@ void draw(GLState &renderer, GLContext &context, const FeatureState &features, S
     }
     frag_ublock.writing_mask = context.record.writing_mask;
     frag_ublock.use_raw_image = static_cast<float>(use_raw_image);
+    frag_ublock.res_multiplier = static_cast<float>(context.res_multiplier);
 
     if (memcmp(&context.previous_frag_info, &frag_ublock, sizeof(GXMRenderFragUniformBlock)) != 0) {
         std::pair<std::uint8_t *, std::size_t> allocated_buffer = context.fragment_info_uniform_buffer.allocate(sizeof(GXMRenderFragUniformBlock));
@@ -162,6 +208,8 @@ void draw(GLState &renderer, GLContext &context, const FeatureState &features, S
     context.vertex_set_requests.clear();
     context.fragment_set_requests.clear();
 
+    bind_uniform_storages(context, mem);
+
     // Upload vertex stream
     sync_vertex_streams_and_attributes(context, context.record, mem);
 
@@ -226,12 +274,7 @@ void draw(GLState &renderer, GLContext &context, const FeatureState &features, S
     context.last_draw_vertex_program_hash = context.record.vertex_program.get(mem)->renderer_data->hash;
     context.last_draw_fragment_program_hash = context.record.fragment_program.get(mem)->renderer_data->hash;
 
-    context.vertex_stream_ring_buffer.draw_call_done();
-    context.index_stream_ring_buffer.draw_call_done();
-    context.vertex_uniform_stream_ring_buffer.draw_call_done();
-    context.fragment_uniform_stream_ring_buffer.draw_call_done();
-    context.vertex_info_uniform_buffer.draw_call_done();
-    context.fragment_info_uniform_buffer.draw_call_done();
+    ring_buffers_draw_call_done(renderer, context);
 
     clear_previous_uniform_storage(context);
 }
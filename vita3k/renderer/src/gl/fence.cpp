@@ -43,6 +43,8 @@ void Fence::insert() {
     }
 
     sync_ = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    signaled_ = false;
+
     if (!sync_) {
         LOG_ERROR("Unable to create fence sync object!");
     }
@@ -102,4 +104,30 @@ bool Fence::wait_for_signal() {
     return signaled_;
 }
 
+bool Fence::poll() {
+    if (!sync_) {
+        return true;
+    }
+
+    const GLenum result = glClientWaitSync(sync_, 0, 0);
+    if ((result != GL_ALREADY_SIGNALED) && (result != GL_CONDITION_SATISFIED)) {
+        return false;
+    }
+
+    glDeleteSync(sync_);
+    sync_ = nullptr;
+    signaled_ = true;
+
+    return true;
+}
+
+void Fence::reset() {
+    if (sync_) {
+        glDeleteSync(sync_);
+        sync_ = nullptr;
+    }
+
+    signaled_ = false;
+}
+
 } // namespace renderer::gl
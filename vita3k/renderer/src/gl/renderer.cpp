@@ -42,12 +42,12 @@
 namespace renderer::gl {
 
 GLContext::GLContext()
-    : vertex_stream_ring_buffer(GL_ARRAY_BUFFER, MB(128))
-    , index_stream_ring_buffer(GL_ELEMENT_ARRAY_BUFFER, MB(64))
-    , vertex_uniform_stream_ring_buffer(GL_SHADER_STORAGE_BUFFER, MB(256))
-    , fragment_uniform_stream_ring_buffer(GL_SHADER_STORAGE_BUFFER, MB(256))
-    , vertex_info_uniform_buffer(GL_UNIFORM_BUFFER, MB(8))
-    , fragment_info_uniform_buffer(GL_UNIFORM_BUFFER, MB(8)) {
+    : vertex_stream_ring_buffer(GL_ARRAY_BUFFER, MB(32), MB(128))
+    , index_stream_ring_buffer(GL_ELEMENT_ARRAY_BUFFER, MB(16), MB(64))
+    , vertex_uniform_stream_ring_buffer(GL_SHADER_STORAGE_BUFFER, MB(64), MB(256))
+    , fragment_uniform_stream_ring_buffer(GL_SHADER_STORAGE_BUFFER, MB(64), MB(256))
+    , vertex_info_uniform_buffer(GL_UNIFORM_BUFFER, MB(2), MB(8))
+    , fragment_info_uniform_buffer(GL_UNIFORM_BUFFER, MB(2), MB(8)) {
     std::memset(&previous_vert_info, 0, sizeof(GXMRenderVertUniformBlock));
     std::memset(&previous_frag_info, 0, sizeof(GXMRenderFragUniformBlock));
 }
@@ -65,8 +65,8 @@ bool init(GLTextureCacheState &cache, const bool hashless_texture_cache) {
         configure_bound_texture(*reinterpret_cast<const SceGxmTexture *>(texture));
     };
 
-    cache.upload_texture_callback = [](const std::size_t index, const void *texture, const MemState &mem) {
-        upload_bound_texture(*reinterpret_cast<const SceGxmTexture *>(texture), mem);
+    cache.upload_texture_callback = [&](const std::size_t index, const void *texture, const MemState &mem) {
+        upload_bound_texture(*reinterpret_cast<const SceGxmTexture *>(texture), mem, cache.yuv_converter);
     };
 
     cache.use_protect = hashless_texture_cache;
@@ -294,11 +294,18 @@ bool GLState::init(const char *base_path, const bool hashless_texture_cache) {
         return false;
     }
 
+    surface_cache.res_multiplier = res_multiplier;
+
     if (!screen_renderer.init(base_path)) {
         LOG_ERROR("Failed to initialize screen renderer");
         return false;
     }
 
+    if (!texture_cache.yuv_converter.init(base_path)) {
+        LOG_ERROR("Failed to initialize YUV converter");
+        return false;
+    }
+
     shader_version = fmt::format("v{}", shader::CURRENT_VERSION);
 
     return true;
@@ -319,7 +326,7 @@ bool create(std::unique_ptr<Context> &context) {
     return true;
 }
 
-bool create(std::unique_ptr<RenderTarget> &rt, const SceGxmRenderTargetParams &params, const FeatureState &features) {
+bool create(std::unique_ptr<RenderTarget> &rt, const SceGxmRenderTargetParams &params, const FeatureState &features, const int res_multiplier) {
     R_PROFILE(__func__);
 
     rt = std::make_unique<GLRenderTarget>();
@@ -331,20 +338,24 @@ bool create(std::unique_ptr<RenderTarget> &rt, const SceGxmRenderTargetParams &p
 
     render_target->width = params.width;
     render_target->height = params.height;
+    render_target->res_multiplier = res_multiplier;
+
+    const GLsizei attachment_width = params.width * res_multiplier;
+    const GLsizei attachment_height = params.height * res_multiplier;
 
     render_target->attachments.init(reinterpret_cast<renderer::Generator *>(glGenTextures), reinterpret_cast<renderer::Deleter *>(glDeleteTextures));
 
     glBindTexture(GL_TEXTURE_2D, render_target->attachments[0]);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, params.width, params.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, attachment_width, attachment_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
     glBindTexture(GL_TEXTURE_2D, render_target->attachments[1]);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, params.width, params.height, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, nullptr);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, attachment_width, attachment_height, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, nullptr);
 
     render_target->masktexture.init(reinterpret_cast<renderer::Generator *>(glGenTextures), reinterpret_cast<renderer::Deleter *>(glDeleteTextures));
     glBindTexture(GL_TEXTURE_2D, render_target->masktexture[0]);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, params.width, params.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, attachment_width, attachment_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glBindFramebuffer(GL_FRAMEBUFFER, render_target->maskbuffer[0]);
@@ -440,6 +451,7 @@ void set_context(GLState &state, GLContext &context, const MemState &mem, const
     }
 
     state.surface_cache.set_render_target(context.render_target);
+    context.res_multiplier = state.res_multiplier;
 
     SceGxmColorSurface *color_surface_fin = &context.record.color_surface;
     if (color_surface_fin->data.address() == 0) {
@@ -499,6 +511,16 @@ void get_surface_data(GLState &renderer, GLContext &context, size_t width, size_
         return;
     }
 
+    bool downscaled = (renderer.res_multiplier > 1);
+    if (downscaled) {
+        // The guest expects the surface at its native size
+        if (!renderer.surface_cache.bind_native_color_surface_for_reading(context.record.color_surface.data)) {
+            // Better a corner of the scaled surface than nothing, read the bound framebuffer as without scaling
+            LOG_WARN("Unable to downscale color surface at 0x{:X} for readback, reading it unscaled", context.record.color_surface.data.address());
+            downscaled = false;
+        }
+    }
+
     glPixelStorei(GL_PACK_ROW_LENGTH, static_cast<GLint>(stride_in_pixels));
 
     // TODO Need more check into this
@@ -598,6 +620,11 @@ void get_surface_data(GLState &renderer, GLContext &context, size_t width, size_
     }
 
     glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+
+    if (downscaled) {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, context.current_framebuffer);
+    }
+
     ++renderer.texture_cache.timestamp;
 }
 
@@ -621,6 +648,8 @@ void GLState::render_frame(const SceFVector2 &viewport_pos, const SceFVector2 &v
     }
 
     screen_renderer.render(viewport_pos, viewport_size, need_uv ? uvs : nullptr, static_cast<GLuint>(surface_handle));
+
+    frame_index++;
 }
 
 } // namespace renderer::gl
@@ -22,25 +22,30 @@
 #include <util/align.h>
 #include <util/log.h>
 
+#include <algorithm>
+#include <chrono>
+
 namespace renderer::gl {
 
-RingBuffer::RingBuffer(GLenum purpose, const std::size_t capacity)
-    : base_(nullptr)
+RingBuffer::RingBuffer(GLenum purpose, const std::size_t capacity, const std::size_t max_capacity)
+    : buffer_(0)
+    , base_(nullptr)
     , cursor_(0)
     , capacity_(capacity)
-    , purpose_(purpose) {
-    buffer_.init(reinterpret_cast<renderer::Generator *>(glGenBuffers), reinterpret_cast<renderer::Deleter *>(glDeleteBuffers));
+    , max_capacity_(std::max(capacity, max_capacity))
+    , current_segment_(0)
+    , purpose_(purpose)
+    , grow_requested_(false) {
+    segment_pending_fence_.fill(false);
 }
 
 RingBuffer::~RingBuffer() {
-    if (base_) {
-        glBindBuffer(purpose_, buffer_[0]);
-        glUnmapBuffer(purpose_);
-    }
+    unmap_and_destroy();
 }
 
 void RingBuffer::create_and_map() {
-    glBindBuffer(purpose_, buffer_[0]);
+    glGenBuffers(1, &buffer_);
+    glBindBuffer(purpose_, buffer_);
     glBufferStorage(purpose_, capacity_, nullptr, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
 
     base_ = reinterpret_cast<std::uint8_t *>(glMapBufferRange(purpose_, 0, capacity_, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT));
@@ -48,6 +53,55 @@ void RingBuffer::create_and_map() {
     if (!base_) {
         LOG_ERROR("Failed to map persistent buffer to host!");
     }
+
+    cursor_ = 0;
+    current_segment_ = 0;
+    segment_pending_fence_.fill(false);
+
+    // Fences left from a previous buffer guard storage that is no longer ours
+    for (Fence &fence : segment_fences_) {
+        fence.reset();
+    }
+}
+
+void RingBuffer::unmap_and_destroy() {
+    if (!buffer_) {
+        return;
+    }
+
+    if (base_) {
+        glBindBuffer(purpose_, buffer_);
+        glUnmapBuffer(purpose_);
+        base_ = nullptr;
+    }
+
+    // The driver keeps the storage alive until the draws still referencing it are done
+    glDeleteBuffers(1, &buffer_);
+    buffer_ = 0;
+}
+
+void RingBuffer::acquire_segment(const std::size_t segment) {
+    Fence &fence = segment_fences_[segment];
+
+    if (segment_pending_fence_[segment]) {
+        // The cursor went around the whole buffer without a draw being done in between
+        LOG_WARN("Ring buffer segment {} is reused before its fence has been inserted!", segment);
+        fence.insert();
+        segment_pending_fence_[segment] = false;
+    }
+
+    if (fence.empty() || fence.poll()) {
+        return;
+    }
+
+    const auto wait_start = std::chrono::steady_clock::now();
+    fence.wait_for_signal();
+    const auto wait_end = std::chrono::steady_clock::now();
+
+    frame_stats_.stall_count++;
+    frame_stats_.stall_time_us += std::chrono::duration_cast<std::chrono::microseconds>(wait_end - wait_start).count();
+
+    grow_requested_ = true;
 }
 
 std::pair<std::uint8_t *, std::size_t> RingBuffer::allocate(const std::size_t data_size) {
@@ -58,29 +112,65 @@ std::pair<std::uint8_t *, std::size_t> RingBuffer::allocate(const std::size_t da
         }
     }
 
+    if (data_size > capacity_) {
+        LOG_ERROR("Requested {} bytes from a ring buffer of only {} bytes!", data_size, capacity_);
+        return std::make_pair(nullptr, static_cast<std::size_t>(-1));
+    }
+
     std::size_t offset = align(cursor_, 256);
 
-    if ((offset + data_size) >= capacity_) {
-        if (!safe_segment_consumed_fence_.empty()) {
-            safe_segment_consumed_fence_.wait_for_signal();
-        } else {
-            LOG_ERROR("Sync fence has not been inserted but the size of the ring buffer has already reached full!");
-            glFinish();
-        }
+    if ((offset + data_size) > capacity_) {
+        // Wrap around. Segments at the tail that are skipped keep the fence they got on the previous lap
+        segment_pending_fence_[current_segment_] = true;
+        current_segment_ = 0;
+        acquire_segment(current_segment_);
 
         offset = 0;
-        cursor_ = 0;
+    }
+
+    const std::size_t last_segment = std::min((offset + std::max<std::size_t>(data_size, 1) - 1) / segment_size(), SEGMENT_COUNT - 1);
+    while (current_segment_ < last_segment) {
+        segment_pending_fence_[current_segment_] = true;
+        acquire_segment(++current_segment_);
     }
 
     cursor_ = align(offset + data_size, 256);
     return std::make_pair(base_ + offset, offset);
 }
 
-void RingBuffer::draw_call_done() {
-    // Insert a fence when the buffer has been consumed about 25% (same as RPCS3)
-    if (safe_segment_consumed_fence_.empty() && (cursor_ >= (capacity_ >> 2))) {
-        safe_segment_consumed_fence_.insert();
+bool RingBuffer::draw_call_done() {
+    // All draws using the data of segments the cursor has left are now submitted
+    for (std::size_t i = 0; i < SEGMENT_COUNT; i++) {
+        if (segment_pending_fence_[i]) {
+            segment_fences_[i].insert();
+            segment_pending_fence_[i] = false;
+        }
+    }
+
+    if (!grow_requested_) {
+        return false;
+    }
+
+    grow_requested_ = false;
+
+    if (capacity_ >= max_capacity_) {
+        return false;
     }
+
+    // The GPU could not keep up with the whole buffer in flight. Start over with a bigger one,
+    // it's mapped again lazily on next allocation
+    unmap_and_destroy();
+
+    capacity_ = std::min(capacity_ * 2, max_capacity_);
+    frame_stats_.grow_count++;
+
+    LOG_INFO("Ring buffer stalled waiting for the GPU, growing it to {} bytes", capacity_);
+    return true;
+}
+
+void RingBuffer::end_frame() {
+    last_frame_stats_ = frame_stats_;
+    frame_stats_ = RingBufferStats();
 }
 
 } // namespace renderer::gl
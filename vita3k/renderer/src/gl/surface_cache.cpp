@@ -21,14 +21,203 @@
 #include <renderer/gl/types.h>
 #include <util/log.h>
 
+#include <algorithm>
 #include <chrono>
 
 namespace renderer::gl {
 static constexpr std::uint64_t CASTED_UNUSED_TEXTURE_PURGE_SECS = 40;
 
+void GLSurfaceLRUList::remove(GLSurfaceCacheInfo &info) {
+    if (!info.lru_prev && (head != &info)) {
+        // Not linked
+        return;
+    }
+
+    if (info.lru_prev) {
+        info.lru_prev->lru_next = info.lru_next;
+    } else {
+        head = info.lru_next;
+    }
+
+    if (info.lru_next) {
+        info.lru_next->lru_prev = info.lru_prev;
+    } else {
+        tail = info.lru_prev;
+    }
+
+    info.lru_prev = nullptr;
+    info.lru_next = nullptr;
+    size--;
+}
+
+void GLSurfaceLRUList::push_back(GLSurfaceCacheInfo &info) {
+    info.lru_prev = tail;
+    info.lru_next = nullptr;
+
+    if (tail) {
+        tail->lru_next = &info;
+    } else {
+        head = &info;
+    }
+
+    tail = &info;
+    size++;
+}
+
 GLSurfaceCache::GLSurfaceCache() {
 }
 
+GLColorSurfaceMap::iterator GLSurfaceCache::lookup_color_surface(const std::uint64_t address) {
+    // Surfaces may overlap, so prefer the closest one that really contains the address.
+    // Nothing starting further than the biggest surface size below the address can contain it.
+    const auto closest = color_surface_textures.lower_bound(address);
+
+    for (auto ite = closest; (ite != color_surface_textures.end()) && ((address - ite->first) < max_color_surface_size); ite++) {
+        if (address < ite->first + ite->second->total_bytes) {
+            return ite;
+        }
+    }
+
+    return closest;
+}
+
+void GLSurfaceCache::free_framebuffers(GLSurfaceCacheInfo &info) {
+    for (const std::uint64_t key : info.framebuffer_keys) {
+        auto ite = framebuffer_array.find(key);
+        if (ite == framebuffer_array.end()) {
+            continue;
+        }
+
+        // Unlink from the other surface attached
+        GLSurfaceCacheInfo *other = (ite->second.color == &info) ? ite->second.depth_stencil : ite->second.color;
+        if (other && (other != &info)) {
+            std::vector<std::uint64_t> &other_keys = other->framebuffer_keys;
+            other_keys.erase(std::remove(other_keys.begin(), other_keys.end(), key), other_keys.end());
+        }
+
+        framebuffer_array.erase(ite);
+    }
+
+    info.framebuffer_keys.clear();
+}
+
+void GLSurfaceCache::free_color_surface(GLColorSurfaceMap::iterator ite) {
+    if (last_written_color_surface == ite->second.get()) {
+        last_written_color_surface = nullptr;
+    }
+
+    free_framebuffers(*ite->second);
+    color_surface_lru.remove(*ite->second);
+    color_surface_textures.erase(ite);
+
+    update_max_color_surface_size();
+}
+
+void GLSurfaceCache::update_max_color_surface_size() {
+    // The cache holds at most MAX_CACHE_SIZE_PER_CONTAINER surfaces, so a scan is cheap
+    max_color_surface_size = 0;
+    for (const auto &[address, info] : color_surface_textures) {
+        max_color_surface_size = std::max(max_color_surface_size, info->total_bytes);
+    }
+}
+
+void GLSurfaceCache::mark_color_surface_written(GLColorSurfaceCacheInfo &info) {
+    // The previous surface won't be drawn to anymore, so its downscaled copy has to be refreshed one last time
+    if (last_written_color_surface && (last_written_color_surface != &info)) {
+        last_written_color_surface->downscale_outdated = true;
+    }
+
+    info.downscale_outdated = true;
+    last_written_color_surface = &info;
+}
+
+GLuint GLSurfaceCache::downscale_color_surface(GLColorSurfaceCacheInfo &info) {
+    if (res_multiplier == 1) {
+        return info.gl_texture[0];
+    }
+
+    if (!downscale_framebuffers[0]) {
+        if (!downscale_framebuffers.init(reinterpret_cast<renderer::Generator *>(glGenFramebuffers), reinterpret_cast<renderer::Deleter *>(glDeleteFramebuffers))) {
+            LOG_ERROR("Unable to initialize downscale framebuffers");
+            return 0;
+        }
+    }
+
+    const bool store_rawly = color::is_write_surface_stored_rawly(info.format);
+
+    if (!info.gl_downscaled_texture[0]) {
+        if (!info.gl_downscaled_texture.init(reinterpret_cast<renderer::Generator *>(glGenTextures), reinterpret_cast<renderer::Deleter *>(glDeleteTextures))) {
+            LOG_ERROR("Failed to initialise downscaled color surface texture!");
+            return 0;
+        }
+
+        glBindTexture(GL_TEXTURE_2D, info.gl_downscaled_texture[0]);
+
+        if (store_rawly) {
+            glTexImage2D(GL_TEXTURE_2D, 0, color::get_raw_store_internal_type(info.format), info.width, info.height, 0, color::get_raw_store_upload_format_type(info.format),
+                color::get_raw_store_upload_data_type(info.format), nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        } else {
+            glTexImage2D(GL_TEXTURE_2D, 0, color::translate_internal_format(info.format), info.width, info.height, 0, color::translate_format(info.format),
+                color::translate_type(info.format), nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        }
+
+        info.downscale_outdated = true;
+    }
+
+    // The surface being drawn to can change between two reads
+    if (!info.downscale_outdated && (&info != last_written_color_surface)) {
+        return info.gl_downscaled_texture[0];
+    }
+
+    GLint last_read_framebuffer = 0;
+    GLint last_draw_framebuffer = 0;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &last_read_framebuffer);
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &last_draw_framebuffer);
+
+    const GLboolean last_scissor_test = glIsEnabled(GL_SCISSOR_TEST);
+    glDisable(GL_SCISSOR_TEST);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, downscale_framebuffers[0]);
+    glFramebufferTexture(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, info.gl_texture[0], 0);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, downscale_framebuffers[1]);
+    glFramebufferTexture(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, info.gl_downscaled_texture[0], 0);
+
+    // A single filtered blit, integer formats can't be filtered
+    glBlitFramebuffer(0, 0, info.width * res_multiplier, info.height * res_multiplier, 0, 0, info.width, info.height, GL_COLOR_BUFFER_BIT,
+        store_rawly ? GL_NEAREST : GL_LINEAR);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, last_read_framebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, last_draw_framebuffer);
+
+    if (last_scissor_test) {
+        glEnable(GL_SCISSOR_TEST);
+    }
+
+    info.downscale_outdated = false;
+    return info.gl_downscaled_texture[0];
+}
+
+bool GLSurfaceCache::bind_native_color_surface_for_reading(Ptr<void> address) {
+    auto ite = color_surface_textures.find(address.address());
+    if (ite == color_surface_textures.end()) {
+        return false;
+    }
+
+    const GLuint native_texture = downscale_color_surface(*ite->second);
+    if (!native_texture) {
+        return false;
+    }
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, downscale_framebuffers[0]);
+    glFramebufferTexture(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, native_texture, 0);
+
+    return true;
+}
+
 void GLSurfaceCache::do_typeless_copy(const GLint dest_texture, const GLint source_texture, const GLenum dest_internal,
     const GLenum dest_upload_format, const GLenum dest_type, const GLenum source_format, const GLenum source_type, const int offset_x,
     const int offset_y, const int width, const int height, const int dest_width, const int dest_height, const std::size_t total_source_size) {
@@ -70,13 +259,11 @@ std::uint64_t GLSurfaceCache::retrieve_color_surface_texture_handle(const std::u
     std::size_t bytes_per_stride = pixel_stride * color::bytes_per_pixel(base_format);
     std::size_t total_surface_size = bytes_per_stride * height;
 
-    // Of course, this works under the assumption that range must be unique :D
-    auto ite = color_surface_textures.lower_bound(key);
+    auto ite = lookup_color_surface(key);
     bool invalidated = false;
 
     if (ite != color_surface_textures.end()) {
         GLColorSurfaceCacheInfo &info = *ite->second;
-        auto used_iterator = std::find(last_use_color_surface_index.begin(), last_use_color_surface_index.end(), ite->first);
 
         if (stored_height) {
             *stored_height = info.height;
@@ -107,15 +294,8 @@ std::uint64_t GLSurfaceCache::retrieve_color_surface_texture_handle(const std::u
         }
 
         if (cache_probably_freed) {
-            for (auto ite = framebuffer_array.begin(); ite != framebuffer_array.end();) {
-                if ((ite->first & 0xFFFFFFFF) == key) {
-                    ite = framebuffer_array.erase(ite);
-                } else {
-                    ite++;
-                }
-            }
-            // Clear out. We will recreate later
-            color_surface_textures.erase(ite);
+            // Clear out along with its framebuffers. We will recreate later
+            free_color_surface(ite);
             invalidated = true;
         } else if (surface_stat_changed) {
             // Remake locally to avoid making changes to framebuffer array
@@ -128,8 +308,8 @@ std::uint64_t GLSurfaceCache::retrieve_color_surface_texture_handle(const std::u
 
             bool store_rawly = false;
 
-            auto remake_and_apply_filters_to_current_binded = [&]() {
-                glTexImage2D(GL_TEXTURE_2D, 0, surface_internal_format, width, height, 0, surface_upload_format, surface_data_type, nullptr);
+            auto remake_and_apply_filters_to_current_binded = [&](const GLsizei remake_width, const GLsizei remake_height) {
+                glTexImage2D(GL_TEXTURE_2D, 0, surface_internal_format, remake_width, remake_height, 0, surface_upload_format, surface_data_type, nullptr);
 
                 if (!store_rawly) {
                     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -141,7 +321,7 @@ std::uint64_t GLSurfaceCache::retrieve_color_surface_texture_handle(const std::u
 
             if (info.gl_expected_read_texture_view[0]) {
                 glBindTexture(GL_TEXTURE_2D, info.gl_ping_pong_texture[0]);
-                remake_and_apply_filters_to_current_binded();
+                remake_and_apply_filters_to_current_binded(width * res_multiplier, height * res_multiplier);
             }
 
             if (color::is_write_surface_stored_rawly(base_format)) {
@@ -154,27 +334,35 @@ std::uint64_t GLSurfaceCache::retrieve_color_surface_texture_handle(const std::u
 
             // This handles some situation where game may stores texture in a larger texture then rebind it
             glBindTexture(GL_TEXTURE_2D, info.gl_texture[0]);
-            remake_and_apply_filters_to_current_binded();
+            remake_and_apply_filters_to_current_binded(width * res_multiplier, height * res_multiplier);
 
             if (info.gl_ping_pong_texture[0]) {
                 glBindTexture(GL_TEXTURE_2D, info.gl_ping_pong_texture[0]);
-                remake_and_apply_filters_to_current_binded();
+                remake_and_apply_filters_to_current_binded(width * res_multiplier, height * res_multiplier);
+            }
+
+            if (info.gl_downscaled_texture[0]) {
+                glBindTexture(GL_TEXTURE_2D, info.gl_downscaled_texture[0]);
+                remake_and_apply_filters_to_current_binded(width, height);
+                info.downscale_outdated = true;
             }
 
             info.casted_textures.clear();
+
+            // The surface may have shrunk
+            update_max_color_surface_size();
         }
-        if (!addr_in_range_of_cache) {
+
+        if (invalidated) {
+            // The surface is gone, don't touch it anymore
+        } else if (!addr_in_range_of_cache) {
             if (purpose == SurfaceTextureRetrievePurpose::WRITING) {
                 invalidated = true;
             }
         } else {
             // If we read and it's still in range
             if ((purpose == SurfaceTextureRetrievePurpose::READING) && addr_in_range_of_cache) {
-                if (used_iterator != last_use_color_surface_index.end()) {
-                    last_use_color_surface_index.erase(used_iterator);
-                }
-
-                last_use_color_surface_index.push_back(ite->first);
+                color_surface_lru.touch(info);
 
                 if (info.flags & GLSurfaceCacheInfo::FLAG_DIRTY) {
                     // We can't use this texture sadly :( If it uses for writing of course it will be gud gud
@@ -210,6 +398,12 @@ std::uint64_t GLSurfaceCache::retrieve_color_surface_texture_handle(const std::u
                 }
 
                 if (castable) {
+                    // Sample a native resolution copy, so that crops and casts stay in guest pixel units
+                    const GLuint source_texture = downscale_color_surface(info);
+                    if (!source_texture) {
+                        return 0;
+                    }
+
                     const std::size_t data_delta = address.address() - ite->first;
                     std::size_t start_sourced_line = data_delta / bytes_per_stride;
                     std::size_t start_x = (data_delta % bytes_per_stride) / color::bytes_per_pixel(base_format);
@@ -243,10 +437,10 @@ std::uint64_t GLSurfaceCache::retrieve_color_surface_texture_handle(const std::u
                                     glBindTexture(GL_TEXTURE_2D, casted_vec[i]->texture[0]);
 
                                     if (color::bytes_per_pixel_in_gl_storage(base_format) == color::bytes_per_pixel_in_gl_storage(info.format)) {
-                                        glCopyImageSubData(info.gl_texture[0], GL_TEXTURE_2D, 0, static_cast<int>(start_x), static_cast<int>(start_sourced_line), 0, casted_vec[i]->texture[0], GL_TEXTURE_2D,
+                                        glCopyImageSubData(source_texture, GL_TEXTURE_2D, 0, static_cast<int>(start_x), static_cast<int>(start_sourced_line), 0, casted_vec[i]->texture[0], GL_TEXTURE_2D,
                                             0, 0, 0, 0, width, height, 1);
                                     } else {
-                                        do_typeless_copy(casted_vec[i]->texture[0], info.gl_texture[0], surface_internal_format, surface_upload_format,
+                                        do_typeless_copy(casted_vec[i]->texture[0], source_texture, surface_internal_format, surface_upload_format,
                                             surface_data_type, source_format, source_data_type, static_cast<int>(start_x), static_cast<int>(start_sourced_line), info.width,
                                             height, width, height, info.total_bytes);
                                     }
@@ -282,12 +476,12 @@ std::uint64_t GLSurfaceCache::retrieve_color_surface_texture_handle(const std::u
                             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
                             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-                            glCopyImageSubData(info.gl_texture[0], GL_TEXTURE_2D, 0, 0, start_sourced_line, 0, casted_info.texture[0], GL_TEXTURE_2D,
+                            glCopyImageSubData(source_texture, GL_TEXTURE_2D, 0, 0, start_sourced_line, 0, casted_info.texture[0], GL_TEXTURE_2D,
                                 0, 0, 0, 0, width, height, 1);
                         } else {
                             // TODO: Copy sub region of typeless copy is still not handled ((
                             // We must do a typeless copy (RPCS3)
-                            do_typeless_copy(casted_info.texture[0], info.gl_texture[0], surface_internal_format, surface_upload_format,
+                            do_typeless_copy(casted_info.texture[0], source_texture, surface_internal_format, surface_upload_format,
                                 surface_data_type, source_format, source_data_type, static_cast<int>(start_x), static_cast<int>(start_sourced_line), info.width,
                                 height, width, height, info.total_bytes);
 
@@ -319,13 +513,13 @@ std::uint64_t GLSurfaceCache::retrieve_color_surface_texture_handle(const std::u
                                 glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
                             }
 
-                            glCopyImageSubData(info.gl_texture[0], GL_TEXTURE_2D, 0, 0, 0, 0, info.gl_expected_read_texture_view[0], GL_TEXTURE_2D,
+                            glCopyImageSubData(source_texture, GL_TEXTURE_2D, 0, 0, 0, 0, info.gl_expected_read_texture_view[0], GL_TEXTURE_2D,
                                 0, 0, 0, 0, width, height, 1);
 
                             return info.gl_expected_read_texture_view[0];
                         }
 
-                        return info.gl_texture[0];
+                        return source_texture;
                     }
                 }
             }
@@ -333,22 +527,21 @@ std::uint64_t GLSurfaceCache::retrieve_color_surface_texture_handle(const std::u
 
         if (!invalidated) {
             if (purpose == SurfaceTextureRetrievePurpose::WRITING) {
-                if (used_iterator != last_use_color_surface_index.end()) {
-                    last_use_color_surface_index.erase(used_iterator);
-                }
-
-                last_use_color_surface_index.push_back(ite->first);
+                color_surface_lru.touch(info);
+                mark_color_surface_written(info);
                 return info.gl_texture[0];
             } else {
                 return 0;
             }
-        } else if (invalidated) {
-            if (used_iterator != last_use_color_surface_index.end()) {
-                last_use_color_surface_index.erase(used_iterator);
-            }
         }
     }
 
+    // A surface with the same base but a layout that can't be reused
+    auto same_base = color_surface_textures.find(key);
+    if (same_base != color_surface_textures.end()) {
+        free_color_surface(same_base);
+    }
+
     std::unique_ptr<GLColorSurfaceCacheInfo> info_added = std::make_unique<GLColorSurfaceCacheInfo>();
 
     info_added->width = width;
@@ -378,7 +571,7 @@ std::uint64_t GLSurfaceCache::retrieve_color_surface_texture_handle(const std::u
     }
 
     glBindTexture(GL_TEXTURE_2D, texture_handle_return);
-    glTexImage2D(GL_TEXTURE_2D, 0, surface_internal_format, width, height, 0, surface_upload_format, surface_data_type, nullptr);
+    glTexImage2D(GL_TEXTURE_2D, 0, surface_internal_format, width * res_multiplier, height * res_multiplier, 0, surface_upload_format, surface_data_type, nullptr);
 
     if (!store_rawly) {
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -388,28 +581,23 @@ std::uint64_t GLSurfaceCache::retrieve_color_surface_texture_handle(const std::u
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     }
 
-    color_surface_textures.emplace(address.address(), std::move(info_added));
-
     // Now that everything goes well, we can start rearranging
-    if (last_use_color_surface_index.size() >= MAX_CACHE_SIZE_PER_CONTAINER) {
+    if (color_surface_lru.size >= MAX_CACHE_SIZE_PER_CONTAINER) {
         // We have to purge a cache along with framebuffer
         // So choose the one that is last used
-        const std::uint64_t first_key = last_use_color_surface_index.front();
-        GLuint texture_handle = color_surface_textures.find(first_key)->second->gl_texture[0];
+        const GLColorSurfaceCacheInfo *least_used = static_cast<GLColorSurfaceCacheInfo *>(color_surface_lru.head);
+        free_color_surface(color_surface_textures.find(least_used->data.address()));
+    }
 
-        for (auto it = framebuffer_array.cbegin(); it != framebuffer_array.cend();) {
-            if ((it->first & 0xFFFFFFFF) == texture_handle) {
-                it = framebuffer_array.erase(it);
-            } else {
-                ++it;
-            }
-        }
+    color_surface_lru.push_back(*info_added);
 
-        last_use_color_surface_index.erase(last_use_color_surface_index.begin());
-        color_surface_textures.erase(first_key);
+    if (purpose == SurfaceTextureRetrievePurpose::WRITING) {
+        mark_color_surface_written(*info_added);
     }
 
-    last_use_color_surface_index.push_back(key);
+    color_surface_textures.emplace(key, std::move(info_added));
+
+    max_color_surface_size = std::max(max_color_surface_size, total_surface_size);
 
     if (stored_height) {
         *stored_height = height;
@@ -441,14 +629,15 @@ std::uint64_t GLSurfaceCache::retrieve_ping_pong_color_surface_texture_handle(Pt
         }
 
         glBindTexture(GL_TEXTURE_2D, info.gl_ping_pong_texture[0]);
-        glTexImage2D(GL_TEXTURE_2D, 0, surface_internal_format, info.width, info.height, 0, surface_upload_format, surface_data_type, nullptr);
+        glTexImage2D(GL_TEXTURE_2D, 0, surface_internal_format, info.width * res_multiplier, info.height * res_multiplier, 0, surface_upload_format, surface_data_type, nullptr);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     } else {
         glBindTexture(GL_TEXTURE_2D, info.gl_ping_pong_texture[0]);
     }
 
-    glCopyImageSubData(info.gl_texture[0], GL_TEXTURE_2D, 0, 0, 0, 0, info.gl_ping_pong_texture[0], GL_TEXTURE_2D, 0, 0, 0, 0, info.width, info.height, 1);
+    glCopyImageSubData(info.gl_texture[0], GL_TEXTURE_2D, 0, 0, 0, 0, info.gl_ping_pong_texture[0], GL_TEXTURE_2D, 0, 0, 0, 0,
+        info.width * res_multiplier, info.height * res_multiplier, 1);
     return info.gl_ping_pong_texture[0];
 }
 
@@ -458,75 +647,57 @@ std::uint64_t GLSurfaceCache::retrieve_depth_stencil_texture_handle(const SceGxm
         return 0;
     }
 
-    std::size_t found_index = static_cast<std::size_t>(-1);
-    for (std::size_t i = 0; i < depth_stencil_textures.size(); i++) {
-        if (std::memcmp(&depth_stencil_textures[i].surface, &surface, sizeof(SceGxmDepthStencilSurface)) == 0) {
-            found_index = i;
-            break;
-        }
-    }
+    const std::uint64_t key = surface.depthData ? surface.depthData.address() : surface.stencilData.address();
+    auto ite = depth_stencil_textures.find(key);
+
+    if (ite != depth_stencil_textures.end()) {
+        GLDepthStencilSurfaceCacheInfo &info = *ite->second;
+        depth_stencil_surface_lru.touch(info);
 
-    if (found_index != static_cast<std::size_t>(-1)) {
-        auto ite = std::find(last_use_depth_stencil_surface_index.begin(), last_use_depth_stencil_surface_index.end(), found_index);
-        if (ite != last_use_depth_stencil_surface_index.end()) {
-            last_use_depth_stencil_surface_index.erase(ite);
-            last_use_depth_stencil_surface_index.push_back(found_index);
+        if (std::memcmp(&info.surface, &surface, sizeof(SceGxmDepthStencilSurface)) == 0) {
+            return info.gl_texture[0];
         }
 
-        return depth_stencil_textures[found_index].gl_texture[0];
+        // Same memory but different parameters, respecify the texture in place so attached framebuffers stay valid
+        info.surface = surface;
+
+        glBindTexture(GL_TEXTURE_2D, info.gl_texture[0]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, target->width * res_multiplier, target->height * res_multiplier, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, nullptr);
+
+        return info.gl_texture[0];
     }
 
     // Now that everything goes well, we can start rearranging
-    // Almost carbon copy but still too specific
-    if (last_use_depth_stencil_surface_index.size() >= MAX_CACHE_SIZE_PER_CONTAINER) {
+    if (depth_stencil_surface_lru.size >= MAX_CACHE_SIZE_PER_CONTAINER) {
         // We have to purge a cache along with framebuffer
         // So choose the one that is last used
-        const std::size_t index = last_use_depth_stencil_surface_index.front();
-        GLuint ds_texture_handle = depth_stencil_textures[index].gl_texture[0];
-
-        for (auto it = framebuffer_array.cbegin(); it != framebuffer_array.cend();) {
-            if (((it->first >> 32) & 0xFFFFFFFF) == ds_texture_handle) {
-                it = framebuffer_array.erase(it);
-            } else {
-                ++it;
-            }
-        }
+        GLDepthStencilSurfaceCacheInfo *least_used = static_cast<GLDepthStencilSurfaceCacheInfo *>(depth_stencil_surface_lru.head);
+        const SceGxmDepthStencilSurface &least_used_surface = least_used->surface;
+        const std::uint64_t least_used_key = least_used_surface.depthData ? least_used_surface.depthData.address() : least_used_surface.stencilData.address();
 
-        last_use_depth_stencil_surface_index.erase(last_use_depth_stencil_surface_index.begin());
-        depth_stencil_textures[index].flags = GLSurfaceCacheInfo::FLAG_FREE;
-
-        found_index = index;
-    }
-
-    if (found_index == static_cast<std::size_t>(-1)) {
-        // Still nowhere to found a free slot? We can search maybe
-        for (std::size_t i = 0; i < depth_stencil_textures.size(); i++) {
-            if (depth_stencil_textures[i].flags & GLSurfaceCacheInfo::FLAG_FREE) {
-                if (depth_stencil_textures[i].gl_texture[0] == 0) {
-                    if (!depth_stencil_textures[i].gl_texture.init(reinterpret_cast<renderer::Generator *>(glGenTextures), reinterpret_cast<renderer::Deleter *>(glDeleteTextures))) {
-                        LOG_ERROR("Fail to initialize depth stencil texture!");
-                        return 0;
-                    }
-                }
-                found_index = i;
-                break;
-            }
-        }
+        free_framebuffers(*least_used);
+        depth_stencil_surface_lru.remove(*least_used);
+        depth_stencil_textures.erase(least_used_key);
     }
 
-    if (found_index == static_cast<std::size_t>(-1)) {
-        LOG_ERROR("No free depth stencil texture cache slot!");
+    std::unique_ptr<GLDepthStencilSurfaceCacheInfo> info_added = std::make_unique<GLDepthStencilSurfaceCacheInfo>();
+    if (!info_added->gl_texture.init(reinterpret_cast<renderer::Generator *>(glGenTextures), reinterpret_cast<renderer::Deleter *>(glDeleteTextures))) {
+        LOG_ERROR("Fail to initialize depth stencil texture!");
         return 0;
     }
 
-    last_use_depth_stencil_surface_index.push_back(found_index);
-    depth_stencil_textures[found_index].flags = 0;
-    depth_stencil_textures[found_index].surface = surface;
+    info_added->flags = 0;
+    info_added->surface = surface;
+
+    const GLuint texture_handle_return = info_added->gl_texture[0];
+
+    glBindTexture(GL_TEXTURE_2D, texture_handle_return);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, target->width * res_multiplier, target->height * res_multiplier, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, nullptr);
 
-    glBindTexture(GL_TEXTURE_2D, depth_stencil_textures[found_index].gl_texture[0]);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, target->width, target->height, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, nullptr);
+    depth_stencil_surface_lru.push_back(*info_added);
+    depth_stencil_textures.emplace(key, std::move(info_added));
 
-    return depth_stencil_textures[found_index].gl_texture[0];
+    return texture_handle_return;
 }
 
 std::uint64_t GLSurfaceCache::retrieve_framebuffer_handle(SceGxmColorSurface *color, SceGxmDepthStencilSurface *depth_stencil,
@@ -544,16 +715,30 @@ std::uint64_t GLSurfaceCache::retrieve_framebuffer_handle(SceGxmColorSurface *co
     GLuint color_handle = 0;
     GLuint ds_handle = 0;
 
+    GLSurfaceCacheInfo *color_info = nullptr;
+    GLSurfaceCacheInfo *ds_info = nullptr;
+
     if (color) {
         color_handle = static_cast<GLuint>(retrieve_color_surface_texture_handle(color->width,
             color->height, color->strideInPixels, gxm::get_base_format(color->colorFormat), color->data,
             renderer::SurfaceTextureRetrievePurpose::WRITING, stored_height));
+
+        // The texture may come from a surface containing the address rather than one starting at it
+        auto color_ite = lookup_color_surface(color->data.address());
+        if ((color_ite != color_surface_textures.end()) && (color_ite->second->gl_texture[0] == color_handle)) {
+            color_info = color_ite->second.get();
+        }
     } else {
         color_handle = target->attachments[0];
     }
 
-    if (ds_handle) {
+    if (depth_stencil) {
         ds_handle = static_cast<GLuint>(retrieve_depth_stencil_texture_handle(*depth_stencil));
+
+        auto ds_ite = depth_stencil_textures.find(depth_stencil->depthData ? depth_stencil->depthData.address() : depth_stencil->stencilData.address());
+        if (ds_ite != depth_stencil_textures.end()) {
+            ds_info = ds_ite->second.get();
+        }
     } else {
         ds_handle = target->attachments[1];
     }
@@ -570,16 +755,30 @@ std::uint64_t GLSurfaceCache::retrieve_framebuffer_handle(SceGxmColorSurface *co
             *ds_texture_handle = ds_handle;
         }
 
-        return ite->second[0];
+        return ite->second.framebuffer[0];
     }
 
     // Create a new framebuffer for our sake
-    GLObjectArray<1> &fb = framebuffer_array[key];
+    GLFramebufferCacheInfo &fb_info = framebuffer_array[key];
+    GLObjectArray<1> &fb = fb_info.framebuffer;
     if (!fb.init(reinterpret_cast<renderer::Generator *>(glGenFramebuffers), reinterpret_cast<renderer::Deleter *>(glDeleteFramebuffers))) {
         LOG_ERROR("Can't initialize framebuffer!");
+        framebuffer_array.erase(key);
         return 0;
     }
 
+    // Remember which surfaces use it, so it can be released along with them
+    fb_info.color = color_info;
+    fb_info.depth_stencil = ds_info;
+
+    if (color_info) {
+        color_info->framebuffer_keys.push_back(key);
+    }
+
+    if (ds_info) {
+        ds_info->framebuffer_keys.push_back(key);
+    }
+
     glBindFramebuffer(GL_FRAMEBUFFER, fb[0]);
 
     if (color && renderer::gl::color::is_write_surface_stored_rawly(gxm::get_base_format(color->colorFormat))) {
@@ -612,7 +811,7 @@ std::uint64_t GLSurfaceCache::retrieve_framebuffer_handle(SceGxmColorSurface *co
 }
 
 std::uint64_t GLSurfaceCache::sourcing_color_surface_for_presentation(Ptr<const void> address, const std::uint32_t width, const std::uint32_t height, const std::uint32_t pitch, float *uvs) {
-    auto ite = color_surface_textures.lower_bound(address.address());
+    auto ite = lookup_color_surface(address.address());
     if (ite == color_surface_textures.end()) {
         return 0;
     }
@@ -108,21 +108,31 @@ static GLenum translate_stencil_func(SceGxmStencilFunc stencil_func) {
 
 void sync_mask(GLContext &context, const MemState &mem) {
     auto control = context.record.depth_stencil_surface.control.get(mem);
-    auto width = context.render_target->width;
-    auto height = context.render_target->height;
-    GLubyte initial_byte;
+    GLfloat initial_value;
     if (control) {
-        initial_byte = control->backgroundMask ? 0xFF : 0;
+        initial_value = control->backgroundMask ? 1.0f : 0.0f;
     } else {
         // always accept
-        initial_byte = 0xFF;
+        initial_value = 1.0f;
     }
-    std::vector<GLubyte> emptyData(width * height * 4, initial_byte);
-    GLint texId;
-    glGetIntegerv(GL_TEXTURE_BINDING_2D, &texId);
-    glBindTexture(GL_TEXTURE_2D, context.render_target->masktexture[0]);
-    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, &emptyData[0]);
-    glBindTexture(GL_TEXTURE_2D, texId);
+
+    // Clear on the GPU, the mask is as large as the scaled attachments
+    GLboolean last_color_mask[4];
+    glGetBooleanv(GL_COLOR_WRITEMASK, last_color_mask);
+    // The whole mask is cleared, not only the guest's current scissor region
+    const GLboolean last_scissor_test = glIsEnabled(GL_SCISSOR_TEST);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, context.render_target->maskbuffer[0]);
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glDisable(GL_SCISSOR_TEST);
+    // Leaves the clear color used for guest clears alone
+    const GLfloat clear_value[4] = { initial_value, initial_value, initial_value, initial_value };
+    glClearBufferfv(GL_COLOR, 0, clear_value);
+
+    if (last_scissor_test)
+        glEnable(GL_SCISSOR_TEST);
+    glColorMask(last_color_mask[0], last_color_mask[1], last_color_mask[2], last_color_mask[3]);
+    glBindFramebuffer(GL_FRAMEBUFFER, context.current_framebuffer);
 }
 
 void sync_viewport_flat(GLContext &context) {
@@ -137,7 +147,8 @@ void sync_viewport_flat(GLContext &context) {
 
     context.record.viewport_flat = true;
 
-    glViewport(0, context.current_framebuffer_height - display_h, display_w, display_h);
+    const GLsizei scale = context.res_multiplier;
+    glViewport(0, (context.current_framebuffer_height - display_h) * scale, display_w * scale, display_h * scale);
     glDepthRange(0, 1);
 
     if (previous_flip_y != context.viewport_flip[1]) {
@@ -166,7 +177,8 @@ void sync_viewport_real(GLContext &context, const float xOffset, const float yOf
 
     context.record.viewport_flat = false;
 
-    glViewportIndexedf(0, x, y, w, h);
+    const GLfloat scale = static_cast<GLfloat>(context.res_multiplier);
+    glViewportIndexedf(0, x * scale, y * scale, w * scale, h * scale);
     glDepthRange(zOffset - zScale, zOffset + zScale);
 
     if (previous_flip_y != context.viewport_flip[1]) {
@@ -199,7 +211,7 @@ void sync_clipping(GLContext &context) {
         break;
     case SCE_GXM_REGION_CLIP_OUTSIDE:
         glEnable(GL_SCISSOR_TEST);
-        glScissor(scissor_x, scissor_y, scissor_w, scissor_h);
+        glScissor(scissor_x * context.res_multiplier, scissor_y * context.res_multiplier, scissor_w * context.res_multiplier, scissor_h * context.res_multiplier);
         break;
     case SCE_GXM_REGION_CLIP_INSIDE:
         // TODO: Implement SCE_GXM_REGION_CLIP_INSIDE
@@ -412,10 +424,9 @@ void sync_blending(const GxmRecordState &state, const MemState &mem) {
 }
 
 void clear_previous_uniform_storage(GLContext &context) {
-    context.vertex_uniform_buffer_storage_ptr.first = nullptr;
-    context.vertex_uniform_buffer_storage_ptr.second = 0;
-    context.fragment_uniform_buffer_storage_ptr.first = nullptr;
-    context.fragment_uniform_buffer_storage_ptr.second = 0;
+    // Keep the regions bound for the next draws, but don't write to them anymore since the GPU may be reading them
+    context.vertex_uniform_storage.writable = false;
+    context.fragment_uniform_storage.writable = false;
 }
 
 void sync_vertex_streams_and_attributes(GLContext &context, GxmRecordState &state, const MemState &mem) {
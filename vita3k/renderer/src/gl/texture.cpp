@@ -42,7 +42,7 @@ void bind_texture(GLTextureCacheState &cache, const SceGxmTexture &gxm_texture,
     R_PROFILE(__func__);
     glBindTexture(get_gl_texture_type(gxm_texture), cache.textures[0]);
     configure_bound_texture(gxm_texture);
-    upload_bound_texture(gxm_texture, mem);
+    upload_bound_texture(gxm_texture, mem, cache.yuv_converter);
 }
 
 static bool can_texture_be_unswizzled_without_decode(SceGxmTextureBaseFormat fmt) {
@@ -250,7 +250,7 @@ static void convert_f32m_to_f32(void *dest, const void *data, const uint32_t wid
     }
 }
 
-void upload_bound_texture(const SceGxmTexture &gxm_texture, const MemState &mem) {
+void upload_bound_texture(const SceGxmTexture &gxm_texture, const MemState &mem, YUVConverter &yuv_converter) {
     R_PROFILE(__func__);
 
     const SceGxmTextureFormat fmt = gxm::get_format(&gxm_texture);
@@ -267,7 +267,6 @@ void upload_bound_texture(const SceGxmTexture &gxm_texture, const MemState &mem)
     std::vector<uint8_t> texture_data_decompressed;
     std::vector<uint8_t> texture_pixels_lineared; // TODO Move to context to avoid frequent allocation?
     std::vector<uint32_t> palette_texture_pixels;
-    std::vector<uint8_t> yuv_texture_pixels;
 
     const void *pixels = nullptr;
 
@@ -427,6 +426,8 @@ void upload_bound_texture(const SceGxmTexture &gxm_texture, const MemState &mem)
             pixels_per_stride = width;
         }
 
+        bool converted_on_gpu = false;
+
         if (gxm::is_yuv_format(base_format)) {
             switch (fmt) {
             case SCE_GXM_TEXTURE_FORMAT_YUV420P2_CSC0:
@@ -437,11 +438,15 @@ void upload_bound_texture(const SceGxmTexture &gxm_texture, const MemState &mem)
             case SCE_GXM_TEXTURE_FORMAT_YVU420P3_CSC0:
             case SCE_GXM_TEXTURE_FORMAT_YUV420P3_CSC1:
             case SCE_GXM_TEXTURE_FORMAT_YVU420P3_CSC1: {
-                yuv_texture_pixels.resize(width * height * 3);
-                renderer::texture::yuv420_texture_to_rgb(yuv_texture_pixels.data(),
-                    reinterpret_cast<const uint8_t *>(pixels), width, height);
-                pixels = yuv_texture_pixels.data();
-                pixels_per_stride = width;
+                // Render the planes into the bound texture
+                GLint dest_texture = 0;
+                glGetIntegerv(GL_TEXTURE_BINDING_2D, &dest_texture);
+
+                yuv_converter.convert(renderer::texture::get_yuv420_texture_frame(reinterpret_cast<const uint8_t *>(pixels), fmt, width, height),
+                    static_cast<GLuint>(dest_texture), static_cast<GLint>(mip_index));
+
+                source_size = width * height * 3 / 2;
+                converted_on_gpu = true;
                 break;
             }
 
@@ -465,7 +470,9 @@ void upload_bound_texture(const SceGxmTexture &gxm_texture, const MemState &mem)
 
         glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<GLint>(pixels_per_stride));
 
-        if (need_decompress_and_unswizzle_on_cpu)
+        if (converted_on_gpu) {
+            // Already in place
+        } else if (need_decompress_and_unswizzle_on_cpu)
             glTexSubImage2D(upload_type, mip_index, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
         else {
             size_t compressed_size = 0;
@@ -60,8 +60,7 @@ static const GLint swizzle_rgb1[4] = { GL_ONE, GL_BLUE, GL_GREEN, GL_RED };
 static const GLint swizzle_bgr1[4] = { GL_ONE, GL_RED, GL_GREEN, GL_BLUE };
 
 // SceGxmTextureSwizzleYUV420Mode
-// TODO I don't know what these should be.
-// NOTE: We'll probably need an intermediate shader pass to translate them to RGB.
+// These are converted to RGB by YUVConverter on upload, so no swizzle is needed.
 static const GLint swizzle_yuv_csc0[4] = { GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA };
 static const GLint swizzle_yvu_csc0[4] = { GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA };
 static const GLint swizzle_yuv_csc1[4] = { GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA };
@@ -24,6 +24,28 @@
 #include <algorithm>
 
 namespace renderer::gl {
+static bool start_uniform_storage(RingBuffer &ring_buffer, GLUniformStorage &storage, const std::size_t size) {
+    storage.ptr = ring_buffer.allocate(size);
+    storage.writable = false;
+
+    if (!storage.ptr.first) {
+        storage.size = 0;
+        return false;
+    }
+
+    // Blocks that are not sent again for this draw are unchanged since the last upload
+    if (storage.shadow.size() < size) {
+        storage.shadow.resize(size, 0);
+    }
+
+    std::memcpy(storage.ptr.first, storage.shadow.data(), size);
+
+    storage.size = size;
+    storage.writable = true;
+
+    return true;
+}
+
 bool set_uniform_buffer(GLContext &context, MemState &mem, const bool vertex_shader, const int block_num, const int size, const void *data, bool log_active_shader) {
     renderer::ShaderProgram *program = vertex_shader ? reinterpret_cast<renderer::ShaderProgram *>(context.record.vertex_program.get(mem)->renderer_data.get())
                                                      : reinterpret_cast<renderer::ShaderProgram *>(context.record.fragment_program.get(mem)->renderer_data.get());
@@ -33,29 +55,16 @@ bool set_uniform_buffer(GLContext &context, MemState &mem, const bool vertex_sha
         return true;
     }
 
-    if (vertex_shader) {
-        if (!context.vertex_uniform_buffer_storage_ptr.first) {
-            // Allocate a region for it. Don't worry though, when the shader program is changed
-            context.vertex_uniform_buffer_storage_ptr = context.vertex_uniform_stream_ring_buffer.allocate(program->max_total_uniform_buffer_storage * 4);
-
-            if (!context.vertex_uniform_buffer_storage_ptr.first) {
-                LOG_ERROR("Unable to allocate vertex SSBO from persistent mapped buffer");
-                return false;
-            }
-
-            glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, context.vertex_uniform_stream_ring_buffer.handle(), context.vertex_uniform_buffer_storage_ptr.second, program->max_total_uniform_buffer_storage * 4);
-        }
-    } else {
-        if (!context.fragment_uniform_buffer_storage_ptr.first) {
-            // Allocate a region for it. Don't worry though, when the shader program is changed
-            context.fragment_uniform_buffer_storage_ptr = context.fragment_uniform_stream_ring_buffer.allocate(program->max_total_uniform_buffer_storage * 4);
+    GLUniformStorage &storage = vertex_shader ? context.vertex_uniform_storage : context.fragment_uniform_storage;
+    const std::size_t storage_size = program->max_total_uniform_buffer_storage * 4;
 
-            if (!context.fragment_uniform_buffer_storage_ptr.first) {
-                LOG_ERROR("Unable to allocate fragment SSBO from persistent mapped buffer");
-                return false;
-            }
+    if (!storage.writable || (storage.size < storage_size)) {
+        // The region of the previous draw may still be in use by the GPU, continue in a new one
+        RingBuffer &ring_buffer = vertex_shader ? context.vertex_uniform_stream_ring_buffer : context.fragment_uniform_stream_ring_buffer;
 
-            glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 1, context.fragment_uniform_stream_ring_buffer.handle(), context.fragment_uniform_buffer_storage_ptr.second, program->max_total_uniform_buffer_storage * 4);
+        if (!start_uniform_storage(ring_buffer, storage, storage_size)) {
+            LOG_ERROR("Unable to allocate {} SSBO from persistent mapped buffer", vertex_shader ? "vertex" : "fragment");
+            return false;
         }
     }
 
@@ -63,11 +72,8 @@ bool set_uniform_buffer(GLContext &context, MemState &mem, const bool vertex_sha
     const std::size_t data_size_upload = std::min<GLsizeiptr>(size, program->uniform_buffer_sizes.at(block_num) * 4);
     const std::size_t offset_start_upload = offset * 4;
 
-    if (vertex_shader) {
-        std::memcpy(context.vertex_uniform_buffer_storage_ptr.first + offset_start_upload, data, data_size_upload);
-    } else {
-        std::memcpy(context.fragment_uniform_buffer_storage_ptr.first + offset_start_upload, data, data_size_upload);
-    }
+    std::memcpy(storage.ptr.first + offset_start_upload, data, data_size_upload);
+    std::memcpy(storage.shadow.data() + offset_start_upload, data, data_size_upload);
 
     if (log_active_shader) {
         std::vector<uint8_t> my_data((uint8_t *)data, (uint8_t *)data + size);
@@ -76,4 +82,30 @@ bool set_uniform_buffer(GLContext &context, MemState &mem, const bool vertex_sha
 
     return true;
 }
+
+static void bind_uniform_storage(RingBuffer &ring_buffer, GLUniformStorage &storage, const renderer::ShaderProgram &program, const GLuint binding) {
+    const std::size_t storage_size = program.max_total_uniform_buffer_storage * 4;
+    if (storage_size == 0) {
+        return;
+    }
+
+    if (!storage.ptr.first || (storage.size < storage_size)) {
+        // Nothing uploaded yet, or the region went away with the ring buffer it was allocated from
+        if (!start_uniform_storage(ring_buffer, storage, storage_size)) {
+            LOG_ERROR("Unable to allocate SSBO from persistent mapped buffer");
+            return;
+        }
+    }
+
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, binding, ring_buffer.handle(), storage.ptr.second, storage_size);
+}
+
+void bind_uniform_storages(GLContext &context, const MemState &mem) {
+    const renderer::ShaderProgram &vertex_program = *context.record.vertex_program.get(mem)->renderer_data;
+    const renderer::ShaderProgram &fragment_program = *context.record.fragment_program.get(mem)->renderer_data;
+
+    // Unchanged uniforms are not sent again, so the region of a previous draw is reused as is
+    bind_uniform_storage(context.vertex_uniform_stream_ring_buffer, context.vertex_uniform_storage, vertex_program, 0);
+    bind_uniform_storage(context.fragment_uniform_stream_ring_buffer, context.fragment_uniform_storage, fragment_program, 1);
+}
 } // namespace renderer::gl
@@ -0,0 +1,186 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <renderer/gl/yuv_converter.h>
+
+#include <glutil/shader.h>
+#include <util/log.h>
+
+namespace renderer::gl {
+
+// Limited range conversion matrices, in row-major order
+static const GLfloat csc_matrix_bt601[9] = {
+    1.164f, 0.0f, 1.596f,
+    1.164f, -0.392f, -0.813f,
+    1.164f, 2.017f, 0.0f
+};
+
+static const GLfloat csc_matrix_bt709[9] = {
+    1.164f, 0.0f, 1.793f,
+    1.164f, -0.213f, -0.533f,
+    1.164f, 2.112f, 0.0f
+};
+
+bool YUVConverter::init(const std::string &base_path) {
+    const auto builtin_shaders_path = base_path + "shaders-builtin/";
+
+    program = ::gl::load_shaders(builtin_shaders_path + "yuv_convert.vert", builtin_shaders_path + "yuv_convert.frag");
+    if (!program) {
+        LOG_ERROR("Couldn't compile YUV conversion shaders");
+        return false;
+    }
+
+    if (!vertex_array.init(reinterpret_cast<renderer::Generator *>(glGenVertexArrays), reinterpret_cast<renderer::Deleter *>(glDeleteVertexArrays))
+        || !framebuffer.init(reinterpret_cast<renderer::Generator *>(glGenFramebuffers), reinterpret_cast<renderer::Deleter *>(glDeleteFramebuffers))
+        || !plane_textures.init(reinterpret_cast<renderer::Generator *>(glGenTextures), reinterpret_cast<renderer::Deleter *>(glDeleteTextures))) {
+        LOG_ERROR("Failed to initialize YUV conversion objects");
+        return false;
+    }
+
+    GLint last_program = 0;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &last_program);
+
+    glUseProgram(*program);
+    glUniform1i(glGetUniformLocation(*program, "y_plane"), PLANE_Y);
+    glUniform1i(glGetUniformLocation(*program, "u_plane"), PLANE_U);
+    glUniform1i(glGetUniformLocation(*program, "v_plane"), PLANE_V);
+    glUseProgram(last_program);
+
+    chroma_interleaved_location = glGetUniformLocation(*program, "chroma_interleaved");
+    chroma_swapped_location = glGetUniformLocation(*program, "chroma_swapped");
+    csc_matrix_location = glGetUniformLocation(*program, "csc_matrix");
+    frame_size_location = glGetUniformLocation(*program, "frame_size");
+
+    return true;
+}
+
+void YUVConverter::upload_planes(const YUV420Frame &frame) {
+    const bool respecify = (planes_width != frame.width) || (planes_height != frame.height) || (planes_chroma_interleaved != frame.chroma_interleaved);
+    const std::uint32_t chroma_width = frame.width / 2;
+    const std::uint32_t chroma_height = frame.height / 2;
+
+    const auto upload_plane = [&](const int plane, const GLenum internal_format, const GLenum format, const std::uint32_t width, const std::uint32_t height,
+                                  const std::uint32_t bytes_per_pixel) {
+        glActiveTexture(GL_TEXTURE0 + plane);
+        glBindTexture(GL_TEXTURE_2D, plane_textures[plane]);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<GLint>(frame.strides[plane] / bytes_per_pixel));
+
+        if (respecify) {
+            glTexImage2D(GL_TEXTURE_2D, 0, internal_format, width, height, 0, format, GL_UNSIGNED_BYTE, frame.planes[plane]);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        } else {
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, GL_UNSIGNED_BYTE, frame.planes[plane]);
+        }
+    };
+
+    // Rows of 8-bit planes are not 4-byte aligned in general
+    GLint last_unpack_alignment = 4;
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &last_unpack_alignment);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    upload_plane(PLANE_Y, GL_R8, GL_RED, frame.width, frame.height, 1);
+
+    if (frame.chroma_interleaved) {
+        upload_plane(PLANE_U, GL_RG8, GL_RG, chroma_width, chroma_height, 2);
+    } else {
+        upload_plane(PLANE_U, GL_R8, GL_RED, chroma_width, chroma_height, 1);
+        upload_plane(PLANE_V, GL_R8, GL_RED, chroma_width, chroma_height, 1);
+    }
+
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, last_unpack_alignment);
+
+    planes_width = frame.width;
+    planes_height = frame.height;
+    planes_chroma_interleaved = frame.chroma_interleaved;
+}
+
+void YUVConverter::convert(const YUV420Frame &frame, const GLuint dest_texture, const GLint dest_level) {
+    if (!program || !frame.width || !frame.height) {
+        return;
+    }
+
+    // Backup GL state, this runs in the middle of a draw setup
+    GLint last_active_texture;
+    glGetIntegerv(GL_ACTIVE_TEXTURE, &last_active_texture);
+    GLint last_textures[PLANE_COUNT];
+    for (int i = 0; i < PLANE_COUNT; i++) {
+        glActiveTexture(GL_TEXTURE0 + i);
+        glGetIntegerv(GL_TEXTURE_BINDING_2D, &last_textures[i]);
+    }
+    GLint last_program;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &last_program);
+    GLint last_vertex_array;
+    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &last_vertex_array);
+    GLint last_draw_framebuffer;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &last_draw_framebuffer);
+    GLfloat last_viewport[4];
+    glGetFloatv(GL_VIEWPORT, last_viewport);
+    GLboolean last_color_mask[4];
+    glGetBooleanv(GL_COLOR_WRITEMASK, last_color_mask);
+    GLboolean last_enable_blend = glIsEnabled(GL_BLEND);
+    GLboolean last_enable_scissor_test = glIsEnabled(GL_SCISSOR_TEST);
+    GLboolean last_enable_cull = glIsEnabled(GL_CULL_FACE);
+
+    upload_planes(frame);
+
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer[0]);
+    glFramebufferTexture(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, dest_texture, dest_level);
+
+    glDisable(GL_BLEND);
+    glDisable(GL_SCISSOR_TEST);
+    glDisable(GL_CULL_FACE);
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glViewportIndexedf(0, 0.0f, 0.0f, static_cast<GLfloat>(frame.width), static_cast<GLfloat>(frame.height));
+
+    glUseProgram(*program);
+    glUniform1i(chroma_interleaved_location, frame.chroma_interleaved);
+    glUniform1i(chroma_swapped_location, frame.chroma_swapped);
+    glUniformMatrix3fv(csc_matrix_location, 1, GL_TRUE, (frame.color_space == YUVColorSpace::BT709) ? csc_matrix_bt709 : csc_matrix_bt601);
+    glUniform2f(frame_size_location, static_cast<GLfloat>(frame.width), static_cast<GLfloat>(frame.height));
+
+    glBindVertexArray(vertex_array[0]);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    // Restore GL state
+    glBindVertexArray(last_vertex_array);
+    glUseProgram(last_program);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, last_draw_framebuffer);
+    glViewportIndexedf(0, last_viewport[0], last_viewport[1], last_viewport[2], last_viewport[3]);
+    glColorMask(last_color_mask[0], last_color_mask[1], last_color_mask[2], last_color_mask[3]);
+
+    if (last_enable_blend)
+        glEnable(GL_BLEND);
+
+    if (last_enable_scissor_test)
+        glEnable(GL_SCISSOR_TEST);
+
+    if (last_enable_cull)
+        glEnable(GL_CULL_FACE);
+
+    for (int i = 0; i < PLANE_COUNT; i++) {
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, last_textures[i]);
+    }
+
+    glActiveTexture(last_active_texture);
+}
+
+} // namespace renderer::gl
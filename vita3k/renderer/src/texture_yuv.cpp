@@ -17,64 +17,35 @@
 
 #include <renderer/functions.h>
 
-#include <util/log.h>
-
-#include <algorithm>
-
-extern "C" {
-#include <libswscale/swscale.h>
-}
+#include <gxm/functions.h>
 
 namespace renderer::texture {
 
-static SwsContext *s_render_sws_context{};
-static size_t res[2] = { 0, 0 };
-SwsContext *get_sws_context(size_t width, size_t height) {
-    bool recreate = false;
-    if (res[0] != width || res[1] != height) {
-        recreate = true;
-        res[0] = width;
-        res[1] = height;
-    } else if (s_render_sws_context == nullptr) {
-        recreate = true;
+YUV420Frame get_yuv420_texture_frame(const uint8_t *src, SceGxmTextureFormat format, size_t width, size_t height) {
+    const SceGxmTextureBaseFormat base_format = gxm::get_base_format(format);
+    const std::uint32_t swizzle = format & SCE_GXM_TEXTURE_SWIZZLE_MASK;
+
+    YUV420Frame frame;
+    frame.width = static_cast<std::uint32_t>(width);
+    frame.height = static_cast<std::uint32_t>(height);
+    frame.chroma_interleaved = (base_format == SCE_GXM_TEXTURE_BASE_FORMAT_YUV420P2);
+    frame.chroma_swapped = (swizzle == SCE_GXM_TEXTURE_SWIZZLE_YVU_CSC0) || (swizzle == SCE_GXM_TEXTURE_SWIZZLE_YVU_CSC1);
+    frame.color_space = ((swizzle == SCE_GXM_TEXTURE_SWIZZLE_YUV_CSC1) || (swizzle == SCE_GXM_TEXTURE_SWIZZLE_YVU_CSC1)) ? YUVColorSpace::BT709 : YUVColorSpace::BT601;
+
+    // Y plane first, then either the interleaved chroma plane or the first and second chroma planes
+    frame.planes[0] = src;
+    frame.strides[0] = frame.width;
+
+    frame.planes[1] = src + width * height;
+
+    if (frame.chroma_interleaved) {
+        frame.strides[1] = frame.width;
+    } else {
+        frame.strides[1] = frame.width / 2;
+        frame.planes[2] = frame.planes[1] + width * height / 4;
+        frame.strides[2] = frame.width / 2;
     }
 
-    if (recreate) {
-        if (s_render_sws_context != nullptr) {
-            sws_freeContext(s_render_sws_context);
-            s_render_sws_context = nullptr;
-        }
-        s_render_sws_context = sws_getContext(width, height, AV_PIX_FMT_YUV420P, width, height, AV_PIX_FMT_RGB24,
-            0, nullptr, nullptr, nullptr);
-    }
-    return s_render_sws_context;
-}
-
-void yuv420_texture_to_rgb(uint8_t *dst, const uint8_t *src, size_t width, size_t height) {
-    SwsContext *context = get_sws_context(width, height);
-    assert(context);
-
-    const uint8_t *slices[] = {
-        &src[0], // Y Slice
-        &src[width * height], // U Slice
-        &src[width * height + width * height / 4], // V Slice
-    };
-
-    int strides[] = {
-        static_cast<int>(width),
-        static_cast<int>(width / 2),
-        static_cast<int>(width / 2),
-    };
-
-    uint8_t *dst_slices[] = {
-        dst,
-    };
-
-    const int dst_strides[] = {
-        static_cast<int>(width * 3),
-    };
-
-    int error = sws_scale(context, slices, strides, 0, height, dst_slices, dst_strides);
-    assert(error == height);
+    return frame;
 }
 } // namespace renderer::texture
@@ -107,6 +107,7 @@ struct TranslationState {
     spv::Id color_attachment_raw_id = spv::NoResult;
     spv::Id mask_id = spv::NoResult;
     spv::Id frag_coord_id = spv::NoResult; ///< gl_FragCoord, not built-in in SPIR-V.
+    spv::Id native_frag_coord_id = spv::NoResult; ///< gl_FragCoord divided by the resolution multiplier
     spv::Id render_info_id = spv::NoResult;
     std::vector<VarToReg> var_to_regs;
     std::vector<spv::Id> interfaces;
@@ -428,7 +429,9 @@ static void create_fragment_inputs(spv::Builder &b, SpirvShaderParameters &param
 
             // TODO how about centroid?
             if (input_id == 0xD000) {
-                pa_iter_var = translation_state.frag_coord_id;
+                // Filled from gl_FragCoord at the start of main, the guest expects native pixel positions
+                pa_iter_var = b.createVariable(spv::StorageClassPrivate, v4, "native_frag_coord");
+                translation_state.native_frag_coord_id = pa_iter_var;
             } else {
                 pa_iter_var = b.createVariable(spv::StorageClassInput, pa_iter_type, pa_name.c_str());
                 b.addDecoration(pa_iter_var, spv::DecorationLocation, pa_loc);
@@ -1063,7 +1066,7 @@ static SpirvShaderParameters create_parameters(spv::Builder &b, const SceGxmProg
     }
 
     if (program_type == SceGxmProgramType::Fragment) {
-        spv::Id render_buf_type = b.makeStructType({ f32, f32, f32, f32 }, "GxmRenderFragBufferBlock");
+        spv::Id render_buf_type = b.makeStructType({ f32, f32, f32, f32, f32 }, "GxmRenderFragBufferBlock");
 
         b.addDecoration(render_buf_type, spv::DecorationBlock);
         b.addDecoration(render_buf_type, spv::DecorationGLSLShared);
@@ -1072,11 +1075,13 @@ static SpirvShaderParameters create_parameters(spv::Builder &b, const SceGxmProg
         b.addMemberDecoration(render_buf_type, 1, spv::DecorationOffset, 4);
         b.addMemberDecoration(render_buf_type, 2, spv::DecorationOffset, 8);
         b.addMemberDecoration(render_buf_type, 3, spv::DecorationOffset, 12);
+        b.addMemberDecoration(render_buf_type, 4, spv::DecorationOffset, 16);
 
         b.addMemberName(render_buf_type, 0, "back_disabled");
         b.addMemberName(render_buf_type, 1, "front_disabled");
         b.addMemberName(render_buf_type, 2, "writing_mask");
         b.addMemberName(render_buf_type, 3, "use_raw_image");
+        b.addMemberName(render_buf_type, 4, "res_multiplier");
 
         translation_state.render_info_id = b.createVariable(spv::StorageClassUniform, render_buf_type, "renderFragInfo");
 
@@ -1457,6 +1462,17 @@ static SpirvCode convert_gxp_to_spirv_impl(const SceGxmProgram &program, const s
             end_hook_func = make_vert_finalize_function(b, parameters, program, utils, features, translation_state);
         }
 
+        if (translation_state.native_frag_coord_id != spv::NoResult) {
+            // Rendering may happen at a multiple of the native resolution
+            spv::Id f32 = b.makeFloatType(32);
+            spv::Id v4 = b.makeVectorType(f32, 4);
+            spv::Id one = b.makeFloatConstant(1.0f);
+            spv::Id res_multiplier = b.createLoad(b.createAccessChain(spv::StorageClassUniform, translation_state.render_info_id, { b.makeIntConstant(4) }));
+            spv::Id divisor = b.createCompositeConstruct(v4, { res_multiplier, res_multiplier, one, one });
+            spv::Id native_coord = b.createBinOp(spv::OpFDiv, v4, b.createLoad(translation_state.frag_coord_id), divisor);
+            b.createStore(native_coord, translation_state.native_frag_coord_id);
+        }
+
         for (auto &var_to_reg : translation_state.var_to_regs) {
             create_input_variable(b, parameters, utils, features, "", var_to_reg.pa ? RegisterBank::PRIMATTR : RegisterBank::SECATTR,
                 var_to_reg.offset, spv::NoResult, var_to_reg.size, var_to_reg.var, var_to_reg.dtype);
@@ -0,0 +1,50 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#version 410 core
+
+uniform sampler2D y_plane;
+uniform sampler2D u_plane; // Holds both chroma components when they are interleaved
+uniform sampler2D v_plane;
+
+uniform bool chroma_interleaved;
+uniform bool chroma_swapped;
+uniform mat3 csc_matrix;
+uniform vec2 frame_size;
+
+out vec4 color_frag;
+
+void main() {
+  const vec3 yuv_offset = vec3(16.0 / 255.0, 128.0 / 255.0, 128.0 / 255.0);
+
+  // Chroma planes are half size, linear filtering upsamples them
+  vec2 uv = gl_FragCoord.xy / frame_size;
+  float luma = texelFetch(y_plane, ivec2(gl_FragCoord.xy), 0).r;
+  vec2 chroma;
+
+  if (chroma_interleaved) {
+    chroma = texture(u_plane, uv).rg;
+  } else {
+    chroma = vec2(texture(u_plane, uv).r, texture(v_plane, uv).r);
+  }
+
+  if (chroma_swapped) {
+    chroma = chroma.yx;
+  }
+
+  color_frag = vec4(clamp(csc_matrix * (vec3(luma, chroma) - yuv_offset), 0.0, 1.0), 1.0);
+}